@@ -33,6 +33,7 @@
 
 #include "utest-common.h"
 #include "utest-display.h"
+#include "utest-display-wayland.h"
 #include "utest-camera.h"
 #include "svlib.h"
 
@@ -47,6 +48,8 @@
 typedef struct app_data     app_data_t;
 typedef struct track_desc   track_desc_t;
 typedef struct track_list   track_list_t;
+typedef struct app_view     app_view_t;
+typedef struct sview_frame  sview_frame_t;
 /*******************************************************************************
  * Local types definitions
  ******************************************************************************/
@@ -55,6 +58,73 @@ typedef struct track_list   track_list_t;
  * Types definitions
  ******************************************************************************/
 
+/* ...maximal number of output views (primary window plus auxiliary outputs) */
+#define APP_VIEWS_MAX                   4
+
+/* ...output view rendering surround-view scene */
+struct app_view
+{
+    /* ...application handle */
+    app_data_t         *app;
+
+    /* ...view window */
+    window_data_t      *window;
+
+    /* ...surround-view engine instance (per-window GL objects and view state) */
+    sview_t            *sv;
+
+    /* ...frame-sets still read by the GPU (render thread only) */
+    GQueue              retire;
+
+    /* ...maximal number of frame-sets awaiting GPU completion */
+    u32                 retire_max;
+
+    /* ...sequence number of last frame-set drawn */
+    u32                 seq;
+
+    /* ...text overlay batch */
+    text_batch_t       *text;
+};
+
+/* ...performance HUD history length (samples) */
+#define APP_HUD_SAMPLES                 64
+
+/* ...performance HUD graphs (per-camera input rate plus global metrics) */
+#define APP_HUD_GRAPHS                  (CAMERAS_NUMBER + 8)
+
+/* ...performance HUD data */
+typedef struct app_hud
+{
+    /* ...camera frames received since last sample (protected by queue lock) */
+    u32                 input[CAMERAS_NUMBER];
+
+    /* ...frames decimated or dropped as late since last sample (protected by queue lock) */
+    u32                 dropped;
+
+    /* ...maximal inter-camera skew (in microseconds) and render queue depth since last sample */
+    u32                 skew, depth;
+
+    /* ...history restart request (protected by queue lock; served by render thread) */
+    int                 reset;
+
+    /* ...window statistics snapshot taken at last sample (render thread only) */
+    window_cpu_stats_t  cpu;
+    window_gpu_stats_t  gpu;
+
+    /* ...timestamp of last sample (zero to restart sampling; render thread only) */
+    u32                 ts;
+
+    /* ...history rings, write position and number of valid samples */
+    float               graph[APP_HUD_GRAPHS][APP_HUD_SAMPLES];
+    int                 pos, num;
+
+    /* ...HUD font, labels batch and graphs stream (rebuilt on every sample only) */
+    text_font_t        *font;
+    text_batch_t       *batch;
+    overlay_t          *overlay;
+
+}   app_hud_t;
+
 /* ...surround-view application data */
 struct app_data
 {
@@ -91,6 +161,9 @@ struct app_data
 
     /* ...current vehicle information */
     vehicle_info_t      vehicle;  
+
+    /* ...timestamp of last vehicle information update (rate-scaled) */
+    u64                 vehicle_ts;
 #endif
     
     /* ...miscellaneous control flags */
@@ -101,9 +174,18 @@ struct app_data
 
     /* ...mask of available frames (for surround view) */
     u32                 frames;
-    
-    /* ...surround-view library handle */
-    sview_t            *sv;
+
+    /* ...latest complete frame-set shared by all views */
+    sview_frame_t      *frame;
+
+    /* ...frame-set sequence number */
+    u32                 frame_seq;
+
+    /* ...output views (first one is the main window) */
+    app_view_t          views[APP_VIEWS_MAX];
+
+    /* ...number of active output views */
+    int                 views_num;
     
     /* ...queues access lock */
     pthread_mutex_t     lock;
@@ -117,16 +199,58 @@ struct app_data
     /* ...frame number */
     u32                 frame_num;
 
+    /* ...GUI layer has been visible in previously presented frame */
+    int                 gui_shown;
+
     /* ...GUI widget handle */
     widget_data_t      *gui;
+
+    /* ...overlay text font */
+    text_font_t        *font;
+
+    /* ...performance HUD */
+    app_hud_t           hud;
     
     u32 configuration;
     
     track_desc_t       *track_sv_live;
     
     track_list_t       *track_list;
+
+    /* ...track looping state (segment-seek based playback) */
+    int                 loop_state;
+
+    /* ...number of loop boundaries passed */
+    u32                 loop_count;
+
+    /* ...timestamp of last loop boundary (in microseconds) */
+    u32                 loop_ts;
+
+    /* ...loop-boundary glitch statistics (in microseconds) */
+    u32                 loop_glitch, loop_glitch_max;
+    u64                 loop_glitch_acc;
+
+    /* ...frame-sets delivered to the renderer, camera frames decimated in render queues */
+    u32                 rate_delivered, rate_dropped;
+
+    /* ...frames dropped by the sinks as late (QoS) */
+    u32                 rate_late;
+
+    /* ...start of the current rate-statistics period (in microseconds) */
+    u32                 rate_ts;
+
+    /* ...cameras yet to report video-sink statistics in current period */
+    u32                 rate_pool;
+
+    /* ...timestamp of the first replayed CAN/PDU message */
+    u64                 rate_pkt_ts;
 };
 
+/* ...track seeking states (looping and/or non-default playback rate) */
+#define APP_LOOP_NONE                   0
+#define APP_LOOP_PENDING                1
+#define APP_LOOP_ACTIVE                 2
+
 
 /* ...double-linked list item */
 struct track_list
@@ -229,6 +353,12 @@ extern int app_track_start(app_data_t *app, track_desc_t *track, int start);
 /* ...output devices for main / auxiliary windows */
 extern int __output_main, __output_transform;
 
+/* ...additional outputs mirroring surround-view scene */
+extern int __output_aux[APP_VIEWS_MAX - 1], __output_aux_num;
+
+/* ...split-screen layout of output windows */
+extern layout_t __layout;
+
 /*******************************************************************************
  * Public module API
  ******************************************************************************/
@@ -297,6 +427,9 @@ extern void app_debug_enable(app_data_t *app, int enable);
 /* ...enable debugging output */
 extern int app_debug_enabled(app_data_t *app);
 
+/* ...enable performance HUD */
+extern void app_hud_enable(app_data_t *app, int enable);
+
 /* ...close application */
 extern void app_exit(app_data_t *app);
 
@@ -307,8 +440,8 @@ extern void app_exit(app_data_t *app);
 /* ...GUI initialization function */
 extern widget_data_t * gui_create(window_data_t *window, app_data_t *app);
 
-/* ...draw GUI layer */
-extern void gui_redraw(widget_data_t *widget, cairo_t *cr);
+/* ...draw GUI layer (returns non-zero if layer is visible) */
+extern int gui_redraw(widget_data_t *widget, cairo_t *cr);
 
 /* ...update GUI configuration */
 extern void gui_config_update(widget_data_t *widget);
@@ -343,4 +476,13 @@ extern int app_has_multiple_sources(app_data_t *app);
 /* ...application has tracks file*/
 #define APP_FLAG_FILE                   (1 << 7)
 
+/* ...loop offline tracks without pipeline rebuild */
+#define APP_FLAG_LOOP                   (1 << 8)
+
+/* ...present frontal camera on compositor plane instead of GL drawing */
+#define APP_FLAG_CAMERA_PLANE           (1 << 9)
+
+/* ...show performance HUD */
+#define APP_FLAG_HUD                    (1 << 10)
+
 #endif  /* __UTEST_APP_H */
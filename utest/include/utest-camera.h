@@ -79,6 +79,56 @@ const char * video_stream_filename(void);
 
 const char * video_stream_get_file(int i);
 
+/* ...playback rate of offline video streams (0.25 .. 8) */
+extern double video_stream_rate;
+
+#define VIDEO_STREAM_RATE_MIN           0.25
+#define VIDEO_STREAM_RATE_MAX           8.0
+
+/*******************************************************************************
+ * File source
+ ******************************************************************************/
+
+/* ...file source modes */
+#define FILE_SOURCE_MODE_FILESRC        0
+#define FILE_SOURCE_MODE_READAHEAD      1
+#define FILE_SOURCE_MODE_MMAP           2
+
+/* ...default read block size */
+#define FILE_SOURCE_BLOCK_SIZE          (1 << 20)
+
+/* ...file source I/O statistics */
+typedef struct file_source_stats
+{
+    /* ...total amount of bytes delivered */
+    u64             bytes;
+
+    /* ...number of storage accesses */
+    u32             reads;
+
+    /* ...accumulated / longest storage access time (in microseconds) */
+    u64             read_time;
+    u32             read_max;
+
+    /* ...number of accesses exceeding stall threshold and their total time */
+    u32             stalls;
+    u64             stall_time;
+
+    /* ...time since first access (in microseconds) */
+    u64             elapsed;
+
+}   file_source_stats_t;
+
+/* ...global file source configuration */
+extern int          file_source_mode;
+extern u32          file_source_block;
+
+/* ...create file source element (filesrc or read-ahead / mmap-based appsrc) */
+extern GstElement * file_source_create(const char *filename, int id);
+
+/* ...retrieve I/O statistics of the file source */
+extern int file_source_get_stats(GstElement *element, file_source_stats_t *stats);
+
 /* ...ethernet frame processing callback - tbd */
 extern void camera_mjpeg_packet_receive(int id, u8 *pdu, u16 len, u64 ts);
 
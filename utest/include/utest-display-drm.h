@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * utest-display-drm.h
+ *
+ * Direct DRM/KMS output support (GBM surfaces and atomic page flips)
+ *
+ * Copyright (c) 2015-2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_DISPLAY_DRM_H
+#define __UTEST_DISPLAY_DRM_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <gbm.h>
+
+/*******************************************************************************
+ * Types definitions
+ ******************************************************************************/
+
+/* ...KMS device handle */
+typedef struct kms_device       kms_device_t;
+
+/* ...KMS output (connector, CRTC and planes driven by a window) */
+typedef struct kms_output       kms_output_t;
+
+/* ...page-flip completion callback (invoked from display dispatch thread) */
+typedef void (*kms_flip_cb_t)(void *cdata);
+
+/* ...page-flip latency statistics (in microseconds) */
+typedef struct kms_output_stats
+{
+    /* ...number of completed flips */
+    u32                 flips;
+
+    /* ...commit-to-flip latency */
+    u32                 latency, latency_max;
+    u64                 latency_acc;
+
+    /* ...flips that missed a vblank (interval longer than 1.5 refresh periods) */
+    u32                 missed;
+
+}   kms_output_stats_t;
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...open DRM device and enable atomic modesetting */
+extern kms_device_t * kms_open(const char *path);
+
+/* ...close DRM device */
+extern void kms_close(kms_device_t *kms);
+
+/* ...GBM device used as EGL native display */
+extern struct gbm_device * kms_gbm_device(kms_device_t *kms);
+
+/* ...DRM file descriptor (delivers page-flip events) */
+extern int kms_fd(kms_device_t *kms);
+
+/* ...process pending DRM events */
+extern int kms_dispatch(kms_device_t *kms);
+
+/* ...create output on n-th connected connector; return mode dimensions */
+extern kms_output_t * kms_output_create(kms_device_t *kms, int n, u32 format, kms_flip_cb_t cb, void *cdata, int *width, int *height);
+
+/* ...destroy output (no flip must be pending) */
+extern void kms_output_destroy(kms_output_t *output);
+
+/* ...GBM surface to be used as EGL native window */
+extern struct gbm_surface * kms_output_surface(kms_output_t *output);
+
+/* ...present last swapped buffer with a non-blocking atomic commit */
+extern int kms_output_commit(kms_output_t *output);
+
+/* ...retrieve page-flip statistics */
+extern int kms_output_get_stats(kms_output_t *output, kms_output_stats_t *stats);
+
+#endif  /* __UTEST_DISPLAY_DRM_H */
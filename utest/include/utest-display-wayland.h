@@ -81,8 +81,16 @@ typedef struct egl_data
     /* ...current EGL configuration */
     EGLConfig               conf;
 
+    /* ...mask of optional EGL extensions supported by the display */
+    uint32_t                ext;
+
 }   egl_data_t;
 
+/* ...optional EGL extensions */
+#define EGL_DATA_EXT_DMABUF_IMPORT      (1 << 0)
+#define EGL_DATA_EXT_DMABUF_MODIFIERS   (1 << 1)
+#define EGL_DATA_EXT_SWAP_DAMAGE        (1 << 2)
+
 
     
 
@@ -127,22 +135,135 @@ typedef struct vbo_data
     /* ...mapped index buffer */
     void               *index;
 
+    /* ...streaming mode (single buffer, orphaning or unsynchronized ring) */
+    u32                 mode;
+
+    /* ...number of ring segments and currently mapped segment */
+    u32                 segments;
+    u32                 segment;
+
+    /* ...segment sizes of vertex/index buffers (in bytes) */
+    u32                 v_segment, i_segment;
+
+    /* ...byte offsets of the current segment in vertex/index buffers */
+    u32                 v_offset, i_offset;
+
+    /* ...per-segment GPU completion fences */
+    EGLSyncKHR         *fence;
+
+    /* ...number of mappings that had to wait for GPU */
+    u32                 stalls;
+
 }   vbo_data_t;
 
 /* ...handling of VBOs */
 extern vbo_data_t * vbo_create(u32 v_size, u32 v_number, u32 i_size, u32 i_number);
+extern vbo_data_t * vbo_ring_create(u32 v_size, u32 v_number, u32 i_size, u32 i_number, u32 segments);
 extern int vbo_map(vbo_data_t *vbo, int buffer, int index);
 extern void vbo_draw(vbo_data_t *vbo, int offset, int stride, int number, GLfloat *pvm);
+extern void vbo_draw_segment(vbo_data_t *vbo, u32 segment, int offset, int stride, int number, GLfloat *pvm);
 extern void vbo_unmap(vbo_data_t *vbo);
 extern void vbo_destroy(vbo_data_t *vbo);
 
+/* ...VBO streaming microbenchmark (runs in display resource context) */
+extern int vbo_benchmark(display_data_t *display, int frames);
+
+/*******************************************************************************
+ * GPU timing of render stages
+ ******************************************************************************/
+
+/* ...frame rendering stages */
+#define WINDOW_GPU_STAGE_NONE           -1
+#define WINDOW_GPU_STAGE_CLEAR          0
+#define WINDOW_GPU_STAGE_SCENE          1
+#define WINDOW_GPU_STAGE_OVERLAY        2
+#define WINDOW_GPU_STAGE_GUI            3
+#define WINDOW_GPU_STAGE_SWAP           4
+#define WINDOW_GPU_STAGES               5
+
+/* ...histogram buckets; bucket #i counts times below (50 << i) microseconds */
+#define WINDOW_GPU_HIST_BUCKETS         12
+
+/* ...per-stage GPU time statistics */
+typedef struct window_gpu_stage_stats
+{
+    /* ...number of samples and longest time (in microseconds) */
+    u32                 count, max;
+
+    /* ...accumulated time (in microseconds; does not wrap over long runs) */
+    u64                 total;
+
+    /* ...time distribution (last bucket collects everything above) */
+    u32                 hist[WINDOW_GPU_HIST_BUCKETS];
+
+}   window_gpu_stage_stats_t;
+
+/* ...window GPU timing statistics */
+typedef struct window_gpu_stats
+{
+    /* ...number of frames measured */
+    u32                 frames;
+
+    /* ...frames not instrumented because earlier results were not ready */
+    u32                 skipped;
+
+    /* ...frames discarded due to disjoint operation (e.g. frequency change) */
+    u32                 disjoint;
+
+    /* ...per-stage statistics */
+    window_gpu_stage_stats_t    stage[WINDOW_GPU_STAGES];
+
+}   window_gpu_stats_t;
+
+/* ...render-stage CPU time statistics (accumulated since window creation) */
+typedef struct window_cpu_stats
+{
+    /* ...number of frames presented */
+    u32                 frames;
+
+    /* ...rendering thread CPU time per stage (in microseconds) */
+    u32                 stage[WINDOW_GPU_STAGES];
+
+    /* ...wall-clock time spent in buffers swap (in microseconds) */
+    u32                 swap;
+
+}   window_cpu_stats_t;
+
+/* ...global enable flag for GPU timing (requires GL_EXT_disjoint_timer_query) */
+extern int window_gpu_timing;
+
+/* ...switch GPU timer to the next rendering stage (called in window context) */
+extern void window_gpu_stage(window_data_t *window, int stage);
+
+/* ...retrieve GPU timing statistics */
+extern int window_get_gpu_stats(window_data_t *window, window_gpu_stats_t *stats);
+
+/* ...retrieve render-stage CPU time statistics (stages are delimited by window_gpu_stage) */
+extern int window_get_cpu_stats(window_data_t *window, window_cpu_stats_t *stats);
+
 /*******************************************************************************
  * Public API
  ******************************************************************************/
 
+/* ...rotate fullscreen windows with wl_surface_set_buffer_transform instead of rendering */
+extern int window_buffer_transform;
+
+#ifdef DISPLAY_DRM_ENABLED
+/* ...DRM device for direct KMS output bypassing compositor (NULL - use Wayland) */
+extern const char  * display_drm_device;
+#endif
+
+#ifdef DISPLAY_X11_ENABLED
+/* ...X display name for desktop profiling (NULL - use Wayland, empty - default display) */
+extern const char  * display_x11_name;
+#endif
+
 /* ...get current EGL configuration data */
 extern egl_data_t  * display_egl_data(display_data_t *display);
 
+/* ...program binaries cache directory (NULL - default, empty string - disabled) */
+extern const char  * program_cache_dir;
+
 /*******************************************************************************
  * Miscellaneous helpers for 2D-graphics
  ******************************************************************************/
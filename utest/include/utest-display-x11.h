@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * utest-display-x11.h
+ *
+ * X11 platform support for display module (desktop profiling)
+ *
+ * Copyright (c) 2015-2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_DISPLAY_X11_H
+#define __UTEST_DISPLAY_X11_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include <X11/Xlib.h>
+#include "utest-event.h"
+
+/*******************************************************************************
+ * Types definitions
+ ******************************************************************************/
+
+/* ...X11 connection handle */
+typedef struct x11_display      x11_display_t;
+
+/* ...X11 top-level window */
+typedef struct x11_window       x11_window_t;
+
+/* ...input event callback (invoked from display dispatch thread) */
+typedef void (*x11_event_cb_t)(void *cdata, widget_event_t *event);
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...connect to X server (NULL - use DISPLAY environment variable) */
+extern x11_display_t * x11_open(const char *name);
+
+/* ...close X server connection */
+extern void x11_close(x11_display_t *x11);
+
+/* ...Xlib display used as EGL native display */
+extern Display * x11_native_display(x11_display_t *x11);
+
+/* ...connection file descriptor */
+extern int x11_fd(x11_display_t *x11);
+
+/* ...process pending X events */
+extern int x11_dispatch(x11_display_t *x11);
+
+/* ...create window with given visual; zero dimensions select screen size */
+extern x11_window_t * x11_window_create(x11_display_t *x11, VisualID visual, const char *title, int fullscreen, x11_event_cb_t cb, void *cdata, int *width, int *height);
+
+/* ...destroy window */
+extern void x11_window_destroy(x11_window_t *window);
+
+/* ...native window handle to be used for EGL surface creation */
+extern Window x11_window_native(x11_window_t *window);
+
+#endif  /* __UTEST_DISPLAY_X11_H */
@@ -52,6 +52,8 @@ typedef struct widget_data      widget_data_t;
 typedef struct texture_data     texture_data_t;
 typedef struct vbo_data         vbo_data_t;
 typedef struct texture_platform texture_platform_t;
+typedef struct texture_upload   texture_upload_t;
+typedef struct plane_buffer     plane_buffer_t;
 
     
 /*******************************************************************************
@@ -109,6 +111,9 @@ struct texture_data
 
     /* ...buffer plane size */
     uint32_t                 size[3];
+
+    /* ...copy-upload data (NULL for zero-copy textures) */
+    texture_upload_t   *upload;
 };
 
     /* ...texture cropping data */
@@ -157,9 +162,12 @@ struct texture_data
     extern widget_data_t *window_get_widget(window_data_t *window);
     extern const window_info_t *window_get_info(window_data_t *window);
     extern cairo_t * window_get_cairo(window_data_t *window);
+    extern void window_add_damage(window_data_t *window, int x, int y, int w, int h);
     extern void window_put_cairo(window_data_t *window, cairo_t *cr);
     extern cairo_device_t * window_get_cairo_device(window_data_t *window);
     extern cairo_matrix_t * window_get_cmatrix(window_data_t *window);
+    extern u32 window_get_transform(window_data_t *window);
+    extern int window_get_scanout(window_data_t *window);
    
 //    window->fps_acc = 0, window->fps_ts = 0;
 //    extern window_set_
@@ -172,12 +180,27 @@ struct texture_data
     
     /* ...external textures handling */
     extern texture_data_t * texture_create(int w, int h, void **pb, int format);
+    extern texture_data_t * texture_create_dmabuf(int w, int h, void **pb, int *fd, int *stride, int *offset, u64 modifier, int format);
+    extern int texture_upload(texture_data_t *texture, void (*cb)(texture_data_t *, void *), void *cdata);
+    extern void texture_upload_stop(void);
     extern void texture_destroy(texture_data_t *texture);
     extern void texture_draw(texture_data_t *texture, texture_crop_t *crop, texture_view_t *view, float alpha);
+
+    /* ...maximal number of textures drawn with a single call */
+#define TEXTURE_BATCH_MAX               4
+
+    /* ...draw a set of textures with a minimal number of draw calls */
+    extern void texture_draw_batch(int n, texture_data_t **textures, texture_view_t *views, texture_crop_t *crops, float alpha);
 #ifdef ENABLE_OBJDET
     extern cl_mem texture_map(texture_data_t *texture, cl_mem_flags flags);
     extern void texture_unmap(cl_mem buf);
 #endif
+    /* ...camera buffers presented by compositor on a plane below window (no GPU copy) */
+    extern plane_buffer_t * plane_buffer_create(int w, int h, int *fd, int *stride, int *offset, u64 modifier, int format);
+    extern void plane_buffer_destroy(plane_buffer_t *buffer);
+    extern int window_plane_present(window_data_t *window, plane_buffer_t *buffer, int x, int y, int w, int h, void (*release)(void *), void *cookie);
+    extern void window_plane_hide(window_data_t *window);
+
     /* ...texture viewport/cropping setting */
     extern void texture_set_view(texture_view_t *vcoord, float x0, float y0, float x1, float y1);
     extern void texture_set_crop(texture_crop_t *tcoord, float x0, float y0, float x1, float y1);
@@ -187,6 +210,100 @@ struct texture_data
     /* ...helper that scales texture on window with current transformation */
     extern void texture_scale_to_window(texture_view_t *vcoord, window_data_t *window, int w, int h, cairo_matrix_t *m);
 
+/*******************************************************************************
+ * Split-screen layouts
+ ******************************************************************************/
+
+/* ...maximal number of cells in a layout */
+#define LAYOUT_CELLS_MAX                8
+
+/* ...cell showing rendered scene (non-negative sources are camera indices) */
+#define LAYOUT_SOURCE_SCENE             (-1)
+
+/* ...layout cell (fractions of window viewable area, origin in upper-left corner) */
+typedef struct layout_cell
+{
+    float               x, y, w, h;
+    int                 source;
+
+}   layout_cell_t;
+
+/* ...window layout descriptor */
+typedef struct layout
+{
+    int                 num;
+    layout_cell_t       cell[LAYOUT_CELLS_MAX];
+
+}   layout_t;
+
+    /* ...parse layout specification (preset name or explicit cells list) */
+    extern int layout_parse(layout_t *layout, const char *spec);
+
+    /* ...get cell occupied by the scene (NULL if there is none) */
+    extern const layout_cell_t * layout_scene_cell(const layout_t *layout);
+
+    /* ...restrict GL and cairo output to a layout cell */
+    extern void layout_cell_enter(const layout_cell_t *cell, window_data_t *window, cairo_t *cr);
+    extern void layout_cell_leave(window_data_t *window, cairo_t *cr);
+
+    /* ...draw camera previews into their cells in a single batch */
+    extern void layout_draw_previews(const layout_t *layout, window_data_t *window, texture_data_t **textures, int n, int w, int h);
+
+/*******************************************************************************
+ * Glyph-atlas text rendering
+ ******************************************************************************/
+
+    /* ...font rasterized into a texture atlas */
+    typedef struct text_font    text_font_t;
+
+    /* ...batch of glyph (and solid box) quads drawn with a single call */
+    typedef struct text_batch   text_batch_t;
+
+    /* ...rasterize printable ASCII glyphs of a font face */
+    extern text_font_t * text_font_create(const char *face, int size);
+    extern void text_font_destroy(text_font_t *font);
+    extern int text_font_height(text_font_t *font);
+
+    /* ...create batch holding up to "size" quads */
+    extern text_batch_t * text_batch_create(text_font_t *font, int size);
+    extern void text_batch_destroy(text_batch_t *batch);
+    extern void text_batch_reset(text_batch_t *batch);
+
+    /* ...add (multi-line) text; (x,y) is the baseline origin, color is 0xRRGGBBAA; returns width */
+    extern int text_batch_printf(text_batch_t *batch, int x, int y, u32 color, const char *fmt, ...);
+
+    /* ...add solid rectangle */
+    extern void text_batch_box(text_batch_t *batch, int x, int y, int w, int h, u32 color);
+
+    /* ...draw batch in a window in viewport pixel coordinates (cairo output is flushed first) */
+    extern void text_batch_draw(text_batch_t *batch, window_data_t *window, cairo_t *cr);
+
+/*******************************************************************************
+ * Overlay primitives batching
+ ******************************************************************************/
+
+    /* ...per-frame stream of lines and polygons drawn with a single call */
+    typedef struct overlay      overlay_t;
+
+    /* ...create stream holding up to "size" vertices (6 per segment or triangle pair) */
+    extern overlay_t * overlay_create(int size);
+    extern void overlay_destroy(overlay_t *overlay);
+
+    /* ...start new frame (transformation is reset to identity) */
+    extern void overlay_reset(overlay_t *overlay);
+
+    /* ...set user-to-viewport transformation (same semantics as cairo_set_matrix) */
+    extern void overlay_set_matrix(overlay_t *overlay, const cairo_matrix_t *matrix);
+
+    /* ...record primitives; colors are 0xRRGGBBAA, line widths are in viewport pixels, polygons are convex */
+    extern void overlay_line(overlay_t *overlay, float x0, float y0, float x1, float y1, float width, u32 color);
+    extern void overlay_polyline(overlay_t *overlay, const float *xy, int n, int closed, float width, u32 color);
+    extern void overlay_polygon(overlay_t *overlay, const float *xy, int n, u32 color);
+    extern void overlay_box(overlay_t *overlay, float x, float y, float w, float h, float width, u32 color);
+
+    /* ...draw recorded primitives in a window (cairo output is flushed first) */
+    extern void overlay_draw(overlay_t *overlay, window_data_t *window, cairo_t *cr);
+
 /*******************************************************************************
  * Generic widgets support
  ******************************************************************************/
@@ -216,13 +333,17 @@ typedef struct widget_info
 /* ...widget creation/destruction */
 extern widget_data_t * widget_create(window_data_t *window, widget_info_t *info, void *cdata);
 extern void widget_destroy(widget_data_t *widget);
+extern void widget_rasterizer_stop(void);
 
 /* Platform-dependent declaration */
 int __widget_init(widget_data_t *widget, window_data_t *window, int W, int H, widget_info_t *info, void *cdata);
+void __widget_fini(widget_data_t *widget);
+void __widget_layer_schedule(widget_data_t *widget);
 
 /* ...widget rendering */
 extern void widget_render(widget_data_t *widget, cairo_t *cr, float alpha);
 extern void widget_update(widget_data_t *widget, int flush);
+extern void widget_compose(widget_data_t *widget, cairo_t *cr, float dim, float alpha);
 extern void widget_schedule_redraw(widget_data_t *widget);
 extern cairo_device_t * widget_get_cairo_device(widget_data_t *widget);
 
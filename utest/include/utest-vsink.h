@@ -64,11 +64,21 @@ typedef struct vsink_meta
     /* ...plane buffers DMA file-descriptors */
     int                 dmafd[GST_VIDEO_MAX_PLANES];
 
+    /* ...plane strides (zero if tightly packed) and offsets within DMA buffers */
+    int                 stride[GST_VIDEO_MAX_PLANES];
+    int                 offset[GST_VIDEO_MAX_PLANES];
+
+    /* ...DMA buffers format modifier (VSINK_MODIFIER_IMPLICIT if layout is driver-defined) */
+    u64                 modifier;
+
     /* ...sink pointer */
     video_sink_t       *sink;
     
 }   vsink_meta_t;
 
+/* ...implicit format modifier (matches DRM_FORMAT_MOD_INVALID) */
+#define VSINK_MODIFIER_IMPLICIT         0x00FFFFFFFFFFFFFFULL
+
 /* ...metadata API type accessor */
 extern GType vsink_meta_api_get_type(void);
 #define VSINK_META_API_TYPE             (vsink_meta_api_get_type())
@@ -103,6 +113,30 @@ typedef struct vsink_callback
     
 }   vsink_callback_t;
     
+/* ...buffer pool statistics (counters are updated atomically from streaming threads) */
+typedef struct vsink_pool_stats
+{
+    /* ...number of buffers allocated */
+    u32         allocs;
+
+    /* ...number of buffers acquired / served without allocation */
+    u32         acquires, reuses;
+
+    /* ...number of acquisitions blocked on empty pool and total wait time (in microseconds) */
+    u32         waits;
+    u64         wait_time;
+
+    /* ...number of caps-identical renegotiations that kept the pool */
+    u32         renegotiations;
+
+    /* ...texture cache statistics for foreign (system-memory / dmabuf) buffers */
+    u32         cache_hits, cache_misses, cache_evictions;
+
+}   vsink_pool_stats_t;
+
+/* ...buffer pool depth (number of buffers preallocated) */
+extern int      vsink_pool_depth;
+
 /* ...custom video sink node creation */
 extern video_sink_t * video_sink_create(GstCaps *caps, const vsink_callback_t *cb, void *data);
 
@@ -112,4 +146,7 @@ extern void video_sink_destroy(video_sink_t *vsink);
 /* ...retrieve GStreamer element node */
 extern GstElement * video_sink_element(video_sink_t *sink);
 
+/* ...retrieve buffer pool and texture cache statistics */
+extern int video_sink_get_stats(video_sink_t *sink, vsink_pool_stats_t *stats);
+
 #endif  /* __UTEST_VSINK_H */
@@ -0,0 +1,655 @@
+/*******************************************************************************
+ * utest-display-drm.c
+ *
+ * Direct DRM/KMS output support (GBM surfaces and atomic page flips)
+ *
+ * Copyright (c) 2015-2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      DRM
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest.h"
+#include "utest-common.h"
+#include "utest-display-drm.h"
+
+#include <fcntl.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm/drm_fourcc.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
+
+/* ...maximal number of planes claimed by all outputs */
+#define KMS_PLANES_MAX                  16
+
+/* ...number of flips between statistics reports */
+#define KMS_REPORT_FLIPS                600
+
+/* ...property identifiers used in atomic commits */
+typedef struct kms_props {
+    /* ...connector properties */
+    u32 connector_crtc_id;
+
+    /* ...CRTC properties */
+    u32 crtc_mode_id, crtc_active;
+
+    /* ...plane properties */
+    u32 plane_fb_id, plane_crtc_id;
+    u32 plane_src_x, plane_src_y, plane_src_w, plane_src_h;
+    u32 plane_crtc_x, plane_crtc_y, plane_crtc_w, plane_crtc_h;
+
+} kms_props_t;
+
+/* ...KMS device data */
+struct kms_device {
+    /* ...DRM device file descriptor */
+    int fd;
+
+    /* ...GBM device (EGL native display) */
+    struct gbm_device *gbm;
+
+    /* ...mask of CRTCs driven by outputs */
+    u32 crtcs;
+
+    /* ...planes claimed by outputs */
+    u32 planes[KMS_PLANES_MAX];
+    int planes_num;
+};
+
+/* ...KMS output data */
+struct kms_output {
+    /* ...owning device */
+    kms_device_t *kms;
+
+    /* ...connector, CRTC (and its index) */
+    u32 connector_id, crtc_id;
+    int crtc_index;
+
+    /* ...primary plane */
+    u32 plane_id;
+
+    /* ...current mode and its property blob */
+    drmModeModeInfo mode;
+    u32 mode_blob;
+
+    /* ...refresh period (in microseconds) */
+    u32 period;
+
+    /* ...scanout buffers format */
+    u32 format;
+
+    /* ...rendering surface */
+    struct gbm_surface *surface;
+
+    /* ...buffer on screen, buffer awaiting flip and buffer replaced by last flip */
+    struct gbm_bo *front, *pending, *retired;
+
+    /* ...first commit performs modesetting */
+    int modeset;
+
+    /* ...flip completion callback */
+    kms_flip_cb_t cb;
+    void *cdata;
+
+    /* ...property identifiers */
+    kms_props_t props;
+
+    /* ...timestamps of last commit and last flip */
+    u32 commit_ts, flip_ts;
+
+    /* ...page-flip statistics */
+    kms_output_stats_t stats;
+
+    /* ...buffers and statistics access lock */
+    pthread_mutex_t lock;
+};
+
+/*******************************************************************************
+ * Properties handling
+ ******************************************************************************/
+
+/* ...find property of KMS object by name; return its identifier and value */
+static u32 kms_prop_find(int fd, u32 obj, u32 type, const char *name, u64 *value) {
+    drmModeObjectPropertiesPtr props;
+    u32 id = 0, i;
+
+    if ((props = drmModeObjectGetProperties(fd, obj, type)) == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < props->count_props && !id; i++) {
+        drmModePropertyPtr p = drmModeGetProperty(fd, props->props[i]);
+
+        if (!p) continue;
+
+        if (strcmp(p->name, name) == 0) {
+            id = p->prop_id;
+            (value ? *value = props->prop_values[i] : 0);
+        }
+
+        drmModeFreeProperty(p);
+    }
+
+    drmModeFreeObjectProperties(props);
+
+    return id;
+}
+
+/* ...retrieve identifiers of all properties used in commits */
+static int kms_props_init(kms_output_t *output) {
+    int fd = output->kms->fd;
+    kms_props_t *p = &output->props;
+    u32 plane = output->plane_id;
+
+    p->connector_crtc_id = kms_prop_find(fd, output->connector_id, DRM_MODE_OBJECT_CONNECTOR, "CRTC_ID", NULL);
+    p->crtc_mode_id = kms_prop_find(fd, output->crtc_id, DRM_MODE_OBJECT_CRTC, "MODE_ID", NULL);
+    p->crtc_active = kms_prop_find(fd, output->crtc_id, DRM_MODE_OBJECT_CRTC, "ACTIVE", NULL);
+    p->plane_fb_id = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "FB_ID", NULL);
+    p->plane_crtc_id = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "CRTC_ID", NULL);
+    p->plane_src_x = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "SRC_X", NULL);
+    p->plane_src_y = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "SRC_Y", NULL);
+    p->plane_src_w = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "SRC_W", NULL);
+    p->plane_src_h = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "SRC_H", NULL);
+    p->plane_crtc_x = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "CRTC_X", NULL);
+    p->plane_crtc_y = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "CRTC_Y", NULL);
+    p->plane_crtc_w = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "CRTC_W", NULL);
+    p->plane_crtc_h = kms_prop_find(fd, plane, DRM_MODE_OBJECT_PLANE, "CRTC_H", NULL);
+
+    /* ...all properties are mandatory for atomic drivers */
+    CHK_ERR(p->connector_crtc_id && p->crtc_mode_id && p->crtc_active, -(errno = ENOENT));
+    CHK_ERR(p->plane_fb_id && p->plane_crtc_id && p->plane_src_x && p->plane_src_y && p->plane_src_w && p->plane_src_h, -(errno = ENOENT));
+    CHK_ERR(p->plane_crtc_x && p->plane_crtc_y && p->plane_crtc_w && p->plane_crtc_h, -(errno = ENOENT));
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Resources selection
+ ******************************************************************************/
+
+/* ...check if plane is claimed by another output */
+static int kms_plane_claimed(kms_device_t *kms, u32 plane) {
+    int i;
+
+    for (i = 0; i < kms->planes_num; i++) {
+        if (kms->planes[i] == plane) return 1;
+    }
+
+    return 0;
+}
+
+/* ...claim plane for an output */
+static void kms_plane_claim(kms_device_t *kms, u32 plane) {
+    (plane && kms->planes_num < KMS_PLANES_MAX ? kms->planes[kms->planes_num++] = plane : 0);
+}
+
+/* ...release plane claimed by an output */
+static void kms_plane_release(kms_device_t *kms, u32 plane) {
+    int i;
+
+    for (i = 0; i < kms->planes_num; i++) {
+        if (kms->planes[i] == plane) {
+            kms->planes[i] = kms->planes[--kms->planes_num];
+            break;
+        }
+    }
+}
+
+/* ...check if plane supports a format */
+static int kms_plane_format(drmModePlanePtr plane, u32 format) {
+    u32 i;
+
+    for (i = 0; i < plane->count_formats; i++) {
+        if (plane->formats[i] == format) return 1;
+    }
+
+    return 0;
+}
+
+/* ...select primary plane for the CRTC (GUI layer is blended by GPU, overlay planes are not used) */
+static int kms_planes_select(kms_output_t *output, u32 format) {
+    kms_device_t *kms = output->kms;
+    drmModePlaneResPtr res;
+    u32 i;
+
+    CHK_ERR(res = drmModeGetPlaneResources(kms->fd), -errno);
+
+    for (i = 0; i < res->count_planes; i++) {
+        drmModePlanePtr plane;
+        u64 type = 0;
+
+        if (kms_plane_claimed(kms, res->planes[i])) continue;
+
+        if ((plane = drmModeGetPlane(kms->fd, res->planes[i])) == NULL) continue;
+
+        /* ...plane must be usable with our CRTC */
+        if (plane->possible_crtcs & (1 << output->crtc_index)) {
+            kms_prop_find(kms->fd, plane->plane_id, DRM_MODE_OBJECT_PLANE, "type", &type);
+
+            if (type == DRM_PLANE_TYPE_PRIMARY && !output->plane_id && kms_plane_format(plane, format)) {
+                output->plane_id = plane->plane_id;
+            }
+        }
+
+        drmModeFreePlane(plane);
+    }
+
+    drmModeFreePlaneResources(res);
+
+    CHK_ERR(output->plane_id, -(errno = ENODEV));
+
+    return 0;
+}
+
+/* ...select n-th connected connector, its preferred mode and a free CRTC */
+static int kms_connector_select(kms_output_t *output, int n) {
+    kms_device_t *kms = output->kms;
+    drmModeResPtr res;
+    drmModeConnectorPtr conn = NULL;
+    int i, j;
+
+    CHK_ERR(res = drmModeGetResources(kms->fd), -errno);
+
+    /* ...find connector */
+    for (i = 0; i < res->count_connectors; i++) {
+        if ((conn = drmModeGetConnector(kms->fd, res->connectors[i])) == NULL) continue;
+
+        if (conn->connection == DRM_MODE_CONNECTED && conn->count_modes > 0 && n-- == 0) break;
+
+        drmModeFreeConnector(conn), conn = NULL;
+    }
+
+    if (!conn) {
+        TRACE(ERROR, _x("connected connector not found"));
+        errno = ENODEV;
+        goto error;
+    }
+
+    output->connector_id = conn->connector_id;
+
+    /* ...use preferred mode (first one otherwise) */
+    output->mode = conn->modes[0];
+    for (i = 0; i < conn->count_modes; i++) {
+        if (conn->modes[i].type & DRM_MODE_TYPE_PREFERRED) {
+            output->mode = conn->modes[i];
+            break;
+        }
+    }
+
+    /* ...find a CRTC not driven by other outputs */
+    output->crtc_index = -1;
+    for (i = 0; i < conn->count_encoders && output->crtc_index < 0; i++) {
+        drmModeEncoderPtr enc = drmModeGetEncoder(kms->fd, conn->encoders[i]);
+
+        if (!enc) continue;
+
+        for (j = 0; j < res->count_crtcs; j++) {
+            if ((enc->possible_crtcs & (1 << j)) && !(kms->crtcs & (1 << j))) {
+                output->crtc_index = j, output->crtc_id = res->crtcs[j];
+                break;
+            }
+        }
+
+        drmModeFreeEncoder(enc);
+    }
+
+    drmModeFreeConnector(conn);
+
+    if (output->crtc_index < 0) {
+        TRACE(ERROR, _x("no CRTC available for connector %u"), output->connector_id);
+        errno = EBUSY;
+        goto error;
+    }
+
+    drmModeFreeResources(res);
+
+    return 0;
+
+error:
+    drmModeFreeResources(res);
+    return -errno;
+}
+
+/*******************************************************************************
+ * Framebuffers
+ ******************************************************************************/
+
+/* ...destroy framebuffer attached to a buffer object */
+static void __kms_fb_destroy(struct gbm_bo *bo, void *data) {
+    int fd = gbm_device_get_fd(gbm_bo_get_device(bo));
+
+    drmModeRmFB(fd, (u32)(uintptr_t)data);
+}
+
+/* ...get framebuffer of a buffer object (created on first use) */
+static u32 kms_bo_fb(kms_output_t *output, struct gbm_bo *bo) {
+    u32 fb = (u32)(uintptr_t)gbm_bo_get_user_data(bo);
+    u32 handles[4] = { 0 }, pitches[4] = { 0 }, offsets[4] = { 0 };
+    int r;
+
+    /* ...surface buffers are recycled; framebuffer is created once per buffer */
+    if (fb) return fb;
+
+    handles[0] = gbm_bo_get_handle(bo).u32;
+    pitches[0] = gbm_bo_get_stride(bo);
+
+    if ((r = drmModeAddFB2(output->kms->fd, gbm_bo_get_width(bo), gbm_bo_get_height(bo), output->format, handles, pitches, offsets, &fb, 0)) != 0) {
+        TRACE(ERROR, _x("failed to create framebuffer: %d"), r);
+        return 0;
+    }
+
+    gbm_bo_set_user_data(bo, (void *)(uintptr_t)fb, __kms_fb_destroy);
+
+    return fb;
+}
+
+/*******************************************************************************
+ * Page flips
+ ******************************************************************************/
+
+/* ...page-flip completion (dispatch thread context) */
+static void __kms_page_flip(int fd, unsigned int seq, unsigned int sec, unsigned int usec, void *data) {
+    kms_output_t *output = data;
+    kms_output_stats_t *st = &output->stats;
+    u32 ts = (u32)((u64)sec * 1000000ULL + usec);
+    u32 latency = ts - output->commit_ts;
+
+    pthread_mutex_lock(&output->lock);
+
+    /* ...pending buffer is on screen; previous one is released by the renderer */
+    BUG(output->retired != NULL, _x("buffer not released: %p"), output->retired);
+    output->retired = output->front;
+    output->front = output->pending, output->pending = NULL;
+
+    /* ...commit-to-vblank latency (both timestamps are monotonic) */
+    st->flips++;
+    st->latency = latency, st->latency_acc += latency;
+    (st->latency_max < latency ? st->latency_max = latency : 0);
+    (output->flip_ts && ts - output->flip_ts > output->period + output->period / 2 ? st->missed++ : 0);
+    output->flip_ts = ts;
+
+    if (st->flips % KMS_REPORT_FLIPS == 0) {
+        TRACE(INFO, _b("crtc-%u: flips=%u, latency=%u us (avg=%u, max=%u), missed=%u"), output->crtc_id,
+              st->flips, latency, (u32)(st->latency_acc / st->flips), st->latency_max, st->missed);
+    }
+
+    pthread_mutex_unlock(&output->lock);
+
+    /* ...notify window the next frame may be submitted */
+    output->cb(output->cdata);
+}
+
+/* ...present last swapped buffer */
+int kms_output_commit(kms_output_t *output) {
+    int fd = output->kms->fd;
+    kms_props_t *p = &output->props;
+    u32 w = output->mode.hdisplay, h = output->mode.vdisplay;
+    u32 flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+    drmModeAtomicReqPtr req;
+    struct gbm_bo *bo, *retired;
+    u32 fb;
+    int r;
+
+    pthread_mutex_lock(&output->lock);
+    retired = output->retired, output->retired = NULL;
+    r = (output->pending != NULL);
+    pthread_mutex_unlock(&output->lock);
+
+    /* ...return buffer replaced by previous flip to the surface */
+    if (retired) {
+        gbm_surface_release_buffer(output->surface, retired);
+    }
+
+    /* ...only one flip may be in flight */
+    CHK_ERR(!r, -EBUSY);
+
+    /* ...get buffer produced by last swap */
+    CHK_ERR(bo = gbm_surface_lock_front_buffer(output->surface), -(errno = ENOMEM));
+
+    if ((fb = kms_bo_fb(output, bo)) == 0) {
+        gbm_surface_release_buffer(output->surface, bo);
+        return -(errno = ENOMEM);
+    }
+
+    if ((req = drmModeAtomicAlloc()) == NULL) {
+        gbm_surface_release_buffer(output->surface, bo);
+        return -(errno = ENOMEM);
+    }
+
+    /* ...first commit sets the mode and routes connector to CRTC */
+    if (output->modeset) {
+        drmModeAtomicAddProperty(req, output->connector_id, p->connector_crtc_id, output->crtc_id);
+        drmModeAtomicAddProperty(req, output->crtc_id, p->crtc_mode_id, output->mode_blob);
+        drmModeAtomicAddProperty(req, output->crtc_id, p->crtc_active, 1);
+        flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+    }
+
+    /* ...full-screen primary plane (source coordinates are in 16.16 format) */
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_fb_id, fb);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_crtc_id, output->crtc_id);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_src_x, 0);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_src_y, 0);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_src_w, (u64)w << 16);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_src_h, (u64)h << 16);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_crtc_x, 0);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_crtc_y, 0);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_crtc_w, w);
+    drmModeAtomicAddProperty(req, output->plane_id, p->plane_crtc_h, h);
+
+    /* ...mark buffer as pending before event may arrive */
+    pthread_mutex_lock(&output->lock);
+    output->pending = bo;
+    output->commit_ts = __get_time_usec();
+    pthread_mutex_unlock(&output->lock);
+
+    if ((r = drmModeAtomicCommit(fd, req, flags, output)) != 0) {
+        TRACE(ERROR, _x("atomic commit failed: %d"), r);
+
+        pthread_mutex_lock(&output->lock);
+        output->pending = NULL;
+        pthread_mutex_unlock(&output->lock);
+
+        gbm_surface_release_buffer(output->surface, bo);
+    } else {
+        output->modeset = 0;
+    }
+
+    drmModeAtomicFree(req);
+
+    return (r ? -(errno = -r) : 0);
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...process pending DRM events */
+int kms_dispatch(kms_device_t *kms) {
+    drmEventContext ev = {
+        .version = 2,
+        .page_flip_handler = __kms_page_flip,
+    };
+
+    return drmHandleEvent(kms->fd, &ev);
+}
+
+/* ...create output on n-th connected connector */
+kms_output_t * kms_output_create(kms_device_t *kms, int n, u32 format, kms_flip_cb_t cb, void *cdata, int *width, int *height) {
+    kms_output_t *output;
+
+    CHK_ERR(output = calloc(1, sizeof(*output)), (errno = ENOMEM, NULL));
+
+    output->kms = kms, output->format = format;
+    output->cb = cb, output->cdata = cdata;
+
+    if (kms_connector_select(output, n) < 0) {
+        TRACE(ERROR, _x("output-%d: connector selection failed: %m"), n);
+        goto error;
+    } else if (kms_planes_select(output, format) < 0) {
+        TRACE(ERROR, _x("output-%d: no primary plane for crtc-%u: %m"), n, output->crtc_id);
+        goto error;
+    } else if (kms_props_init(output) < 0) {
+        TRACE(ERROR, _x("output-%d: missing atomic properties"), n);
+        goto error;
+    }
+
+    /* ...mode is passed to the kernel as a property blob */
+    if (drmModeCreatePropertyBlob(kms->fd, &output->mode, sizeof(output->mode), &output->mode_blob) != 0) {
+        TRACE(ERROR, _x("output-%d: failed to create mode blob: %m"), n);
+        goto error;
+    }
+
+    /* ...create scanout-capable rendering surface */
+    if ((output->surface = gbm_surface_create(kms->gbm, output->mode.hdisplay, output->mode.vdisplay, format, GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING)) == NULL) {
+        TRACE(ERROR, _x("output-%d: failed to create GBM surface: %m"), n);
+        goto error_blob;
+    }
+
+    /* ...claim resources */
+    kms->crtcs |= 1 << output->crtc_index;
+    kms_plane_claim(kms, output->plane_id);
+
+    pthread_mutex_init(&output->lock, NULL);
+    output->modeset = 1;
+    output->period = (output->mode.vrefresh ? 1000000 / output->mode.vrefresh : 16667);
+
+    *width = output->mode.hdisplay, *height = output->mode.vdisplay;
+
+    TRACE(INIT, _b("output-%d: connector=%u, crtc=%u, plane=%u, mode=%s@%u"), n,
+          output->connector_id, output->crtc_id, output->plane_id, output->mode.name, output->mode.vrefresh);
+
+    return output;
+
+error_blob:
+    drmModeDestroyPropertyBlob(kms->fd, output->mode_blob);
+
+error:
+    free(output);
+    return NULL;
+}
+
+/* ...destroy output */
+void kms_output_destroy(kms_output_t *output) {
+    kms_device_t *kms = output->kms;
+
+    BUG(output->pending != NULL, _x("flip is pending"));
+
+    /* ...return buffers to the surface; framebuffers are removed with the buffers */
+    if (output->retired) {
+        gbm_surface_release_buffer(output->surface, output->retired);
+    }
+
+    if (output->front) {
+        gbm_surface_release_buffer(output->surface, output->front);
+    }
+
+    gbm_surface_destroy(output->surface);
+
+    drmModeDestroyPropertyBlob(kms->fd, output->mode_blob);
+
+    /* ...release resources */
+    kms->crtcs &= ~(1 << output->crtc_index);
+    kms_plane_release(kms, output->plane_id);
+
+    pthread_mutex_destroy(&output->lock);
+
+    free(output);
+}
+
+/* ...GBM surface of the output */
+struct gbm_surface * kms_output_surface(kms_output_t *output) {
+    return output->surface;
+}
+
+/* ...retrieve page-flip statistics */
+int kms_output_get_stats(kms_output_t *output, kms_output_stats_t *stats) {
+    pthread_mutex_lock(&output->lock);
+    *stats = output->stats;
+    pthread_mutex_unlock(&output->lock);
+
+    return 0;
+}
+
+/* ...GBM device of the DRM device */
+struct gbm_device * kms_gbm_device(kms_device_t *kms) {
+    return kms->gbm;
+}
+
+/* ...DRM device file descriptor */
+int kms_fd(kms_device_t *kms) {
+    return kms->fd;
+}
+
+/* ...open DRM device */
+kms_device_t * kms_open(const char *path) {
+    kms_device_t *kms;
+
+    CHK_ERR(kms = calloc(1, sizeof(*kms)), (errno = ENOMEM, NULL));
+
+    if ((kms->fd = open(path, O_RDWR | O_CLOEXEC)) < 0) {
+        TRACE(ERROR, _x("failed to open '%s': %m"), path);
+        goto error;
+    }
+
+    /* ...atomic modesetting requires universal planes */
+    if (drmSetClientCap(kms->fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0 || drmSetClientCap(kms->fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0) {
+        TRACE(ERROR, _x("'%s': atomic modesetting is not supported"), path);
+        errno = ENOTSUP;
+        goto error_fd;
+    }
+
+    if ((kms->gbm = gbm_create_device(kms->fd)) == NULL) {
+        TRACE(ERROR, _x("failed to create GBM device: %m"));
+        goto error_fd;
+    }
+
+    TRACE(INIT, _b("DRM device '%s' opened (atomic)"), path);
+
+    return kms;
+
+error_fd:
+    close(kms->fd);
+
+error:
+    free(kms);
+    return NULL;
+}
+
+/* ...close DRM device */
+void kms_close(kms_device_t *kms) {
+    gbm_device_destroy(kms->gbm);
+    close(kms->fd);
+    free(kms);
+}
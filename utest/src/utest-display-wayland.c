@@ -36,13 +36,26 @@
 #include "utest-display-wayland.h"
 #include "utest-event.h"
 
+#ifdef DISPLAY_DRM_ENABLED
+#include "utest-display-drm.h"
+#endif
+
+#ifdef DISPLAY_X11_ENABLED
+#include "utest-display-x11.h"
+#endif
+
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/epoll.h>
 
 #include <wayland-client.h>
 #include <wayland-kms-client-protocol.h>
+#ifdef DISPLAY_PLANE_ENABLED
+#include <linux-dmabuf-unstable-v1-client-protocol.h>
+#include <viewporter-client-protocol.h>
+#endif
 #include <wayland-egl.h>
 #include <wayland-cursor.h>
 
@@ -59,6 +72,23 @@
 
 #include <cairo-gl.h>
 #include <math.h>
+#include <drm/drm_fourcc.h>
+
+/* ...layout modifiers (missing in older kernel headers) */
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR           0ULL
+#endif
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID          0x00FFFFFFFFFFFFFFULL
+#endif
+
+/* ...GLES3 pixel-buffer objects (entry points are bound at run-time) */
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER          0x88EC
+#endif
+
+typedef void * (GL_APIENTRYP PFNGLMAPBUFFERRANGEPROC_)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (GL_APIENTRYP PFNGLUNMAPBUFFERPROC_)(GLenum target);
 
 /*******************************************************************************
  * Tracing configuration
@@ -75,6 +105,24 @@ TRACE_TAG(DEBUG, 1);
 
 typedef void* texture_platform;
 
+/* ...asynchronous texture uploader */
+typedef struct texture_uploader texture_uploader_t;
+
+/* ...asynchronous widget layers rasterizer */
+typedef struct widget_rasterizer widget_rasterizer_t;
+
+/* ...widget layer (textures composed by render thread) */
+typedef struct widget_layer widget_layer_t;
+
+/* ...resource thread command */
+typedef struct resource_cmd resource_cmd_t;
+
+/* ...window GPU stages timer */
+typedef struct window_gpu_timer window_gpu_timer_t;
+
+/* ...maximal number of dma-buf format/modifier pairs tracked */
+#define DISPLAY_DMABUF_FORMATS          64
+
 /* ...output device data */
 typedef struct output_data {
     /* ...list node */
@@ -137,13 +185,39 @@ typedef struct gl_shader {
     GLuint program;
     GLuint vertex_shader, fragment_shader;
     GLint proj_uniform;
-    GLint tex_uniforms[3];
+    GLint tex_uniforms[4];
     GLint width_uniform;
     GLint height_uniform;
     GLint alpha_uniform;
+    GLint dim_uniform;
 
 } gl_shader_t;
 
+/* ...shadowed GL state of a window context */
+typedef struct gl_state {
+    /* ...current program */
+    GLuint program;
+
+    /* ...program used by cairo (restored before cairo drawing) */
+    GLuint cprog;
+
+    /* ...external texture bound to unit #0 */
+    GLuint texture_ext;
+
+    /* ...vertex/index buffers bindings */
+    GLuint array_buffer, element_buffer;
+
+    /* ...streaming vertex buffer for batched textures drawing (created on demand) */
+    GLuint batch_vbo;
+
+    /* ...validity flags (state modified outside of tracker) */
+    u32 valid;
+
+    /* ...objects deletion sequence number the bindings are valid for */
+    u32 seq;
+
+} gl_state_t;
+
 /* ...display data */
 struct display_data {
     /* ...Wayland display handle */
@@ -155,9 +229,20 @@ struct display_data {
     /* ...screen compositor */
     struct wl_compositor *compositor;
 
-    /* ...subcompositor interface handle (not used) */
+    /* ...subcompositor interface handle (camera planes) */
     struct wl_subcompositor *subcompositor;
 
+    /* ...linux-dmabuf interface and format/modifier pairs accepted by compositor */
+    struct zwp_linux_dmabuf_v1 *dmabuf;
+    struct {
+        u32 format;
+        u64 modifier;
+    } dmabuf_formats[DISPLAY_DMABUF_FORMATS];
+    int dmabuf_formats_num;
+
+    /* ...surface scaling interface */
+    struct wp_viewporter *viewporter;
+
     /* ...shell interface handle */
     struct wl_shell *shell;
 
@@ -167,6 +252,16 @@ struct display_data {
     /* ...shared memory interface handle (not used?) */
     struct wl_shm *shm;
 
+#ifdef DISPLAY_DRM_ENABLED
+    /* ...direct KMS device (compositor is bypassed if set) */
+    kms_device_t *drm;
+#endif
+
+#ifdef DISPLAY_X11_ENABLED
+    /* ...X server connection (used instead of Wayland if set) */
+    x11_display_t *x11;
+#endif
+
     /* ...input/output device handles */
     struct wl_list outputs, inputs;
 
@@ -190,6 +285,31 @@ struct display_data {
     /* ...VBO drawing shader - tbd - looks a bit bad */
     gl_shader_t shader_vbo;
 
+    /* ...batched external textures drawing shader */
+    gl_shader_t shader_batch;
+
+    /* ...cached widget layers composition shader */
+    gl_shader_t shader_gui;
+
+    /* ...glyph-atlas text (and solid boxes) drawing shader */
+    gl_shader_t shader_text;
+
+    /* ...overlay primitives (lines and polygons) drawing shader */
+    gl_shader_t shader_overlay;
+
+    /* ...texture upload thread (started on demand) */
+    texture_uploader_t *uploader;
+
+    /* ...widget layers rasterization thread (started on demand; not retried after failure) */
+    widget_rasterizer_t *rasterizer;
+    int rasterizer_failed;
+
+    /* ...mask of optional GL extensions supported by display context */
+    u32 gl_ext;
+
+    /* ...program binary cache statistics (hits/misses and time spent, in us) */
+    u32 pcache_hits, pcache_misses, pcache_load_us, pcache_build_us;
+
     /* ...dispatch loop epoll descriptor */
     int efd;
 
@@ -199,8 +319,15 @@ struct display_data {
     /* ...dispatch thread handle */
     pthread_t thread;
 
-    /* ...display lock (need that really? - tbd) */
-    pthread_mutex_t lock;
+    /* ...resource thread handle (owns shared display EGL context) */
+    pthread_t resource_thread;
+
+    /* ...resource commands queue */
+    resource_cmd_t *resource_head, **resource_tail;
+
+    /* ...resource queue lock (protects list only) and signalling variable */
+    pthread_mutex_t resource_lock;
+    pthread_cond_t resource_wait;
 };
 
 /* ...widget data structure */
@@ -231,6 +358,9 @@ struct widget_data {
 
     /* ...surface update request */
     int dirty;
+
+    /* ...layer rasterized off the render thread (NULL for root widget) */
+    widget_layer_t *layer;
 };
 
 /* ...output window data */
@@ -253,6 +383,26 @@ struct window_data {
     /* ...native EGL window */
     struct wl_egl_window *native;
 
+#ifdef DISPLAY_DRM_ENABLED
+    /* ...KMS output driven by the window (direct display mode) */
+    kms_output_t *kms_output;
+#endif
+
+    /* ...camera plane subsurface placed below window surface */
+    struct wl_surface *plane_surface;
+    struct wl_subsurface *plane_sub;
+    struct wp_viewport *plane_viewport;
+
+    /* ...plane destination rectangle and buffer attachment status */
+    int plane_x, plane_y, plane_w, plane_h;
+    int plane_attached;
+
+#ifdef DISPLAY_X11_ENABLED
+    /* ...X11 window and current input focus (X11 display mode) */
+    x11_window_t *x11_window;
+    widget_data_t *pointer_focus, *keyboard_focus;
+#endif
+
     /* ...window EGL context (used by native / cairo renderers) */
     EGLContext user_egl_ctx;
 
@@ -265,8 +415,18 @@ struct window_data {
     /* ...current cairo transformation matrix (screen rotation) */
     cairo_matrix_t cmatrix;
 
-    /* ...saved cairo program */
-    GLint cprog;
+    /* ...rotation applied by application (zero if offloaded to compositor) */
+    u32 transform;
+
+    /* ...window buffer satisfies direct scanout conditions */
+    int scanout;
+
+    /* ...bounding box of damaged area for the next swap (GL convention) */
+    EGLint damage[4];
+    int damaged;
+
+    /* ...shadowed GL context state */
+    gl_state_t gl;
 
     /* ...window information */
     const window_info_t *info;
@@ -288,6 +448,19 @@ struct window_data {
 
     /* ...frame-rate calculation */
     u32 fps_ts, fps_acc;
+
+    /* ...rendering thread CPU time accounting */
+    u32 cpu_ts, cpu_acc, cpu_max, cpu_frames;
+
+    /* ...GPU stages timer (created on first use in window context) */
+    window_gpu_timer_t *gpu;
+
+    /* ...current stage CPU accounting (rendering thread only) */
+    int cpu_stage;
+    u32 cpu_stage_ts, cpu_stage_acc[WINDOW_GPU_STAGES];
+
+    /* ...render-stage CPU statistics (protected by window lock) */
+    window_cpu_stats_t cpu_stats;
 };
 
 /*******************************************************************************
@@ -302,6 +475,188 @@ struct window_data {
 
 #define WINDOW_BV_REINIT                (1 << 2)
 
+/* ...page flip is pending (KMS output) */
+#define WINDOW_FLAG_FLIP_PENDING        (1 << 3)
+
+/*******************************************************************************
+ * Optional GL extensions
+ ******************************************************************************/
+
+/* ...unsynchronized buffer range mapping */
+#define DISPLAY_GL_EXT_MAP_BUFFER_RANGE (1 << 0)
+
+/* ...program binaries retrieval and loading */
+#define DISPLAY_GL_EXT_PROGRAM_BINARY   (1 << 1)
+
+/* ...GPU timer queries */
+#define DISPLAY_GL_EXT_TIMER_QUERY      (1 << 2)
+
+/*******************************************************************************
+ * VBO streaming modes
+ ******************************************************************************/
+
+/* ...single buffer mapped as a whole (legacy behaviour) */
+#define VBO_MODE_SINGLE                 0
+
+/* ...buffer storage is orphaned on every mapping */
+#define VBO_MODE_ORPHAN                 1
+
+/* ...ring of segments mapped without implicit synchronization */
+#define VBO_MODE_RING                   2
+
+/* ...rendering CPU time report period (in microseconds) */
+#define WINDOW_CPU_REPORT_PERIOD        (5 * 1000000)
+
+/*******************************************************************************
+ * GL state tracking (window rendering context)
+ ******************************************************************************/
+
+/* ...state validity flags */
+#define GL_STATE_PROGRAM                (1 << 0)
+#define GL_STATE_CPROG                  (1 << 1)
+#define GL_STATE_TEXTURE_EXT            (1 << 2)
+#define GL_STATE_ARRAY_BUFFER           (1 << 3)
+#define GL_STATE_ELEMENT_BUFFER         (1 << 4)
+
+/* ...state of the context current in calling thread (NULL if not tracked) */
+static __thread gl_state_t *__gl_state;
+
+/* ...textures/buffers deletion counter (names deleted in shared contexts may be reused) */
+static volatile u32 __gl_delete_seq;
+
+/* ...mark objects names deletion */
+static inline void gl_state_deleted(void) {
+    __sync_fetch_and_add(&__gl_delete_seq, 1);
+}
+
+/* ...get tracked state with bindings validated against objects deletion */
+static inline gl_state_t * __gl_state_bindings(void) {
+    gl_state_t *gl = __gl_state;
+    u32 seq = __gl_delete_seq;
+
+    if (gl && gl->seq != seq) {
+        gl->valid &= ~(GL_STATE_TEXTURE_EXT | GL_STATE_ARRAY_BUFFER | GL_STATE_ELEMENT_BUFFER);
+        gl->seq = seq;
+    }
+
+    return gl;
+}
+
+/* ...reset shadow copy; state is unknown after foreign GL code (cairo, engine) */
+static inline void gl_state_invalidate(gl_state_t *gl) {
+    gl->valid = 0;
+}
+
+/* ...drop parts of the shadow state modified by raw GL calls in current context */
+static inline void gl_state_forget(u32 flags) {
+    if (__gl_state) {
+        __gl_state->valid &= ~flags;
+    }
+}
+
+/* ...set current program */
+static inline void gl_state_use_program(GLuint program) {
+    gl_state_t *gl = __gl_state;
+
+    if (!gl) {
+        glUseProgram(program);
+    } else if (!(gl->valid & GL_STATE_PROGRAM) || gl->program != program) {
+        /* ...program is switched from cairo's one; remember it once for restoring */
+        if (!(gl->valid & (GL_STATE_PROGRAM | GL_STATE_CPROG))) {
+            GLint cprog;
+
+            glGetIntegerv(GL_CURRENT_PROGRAM, &cprog);
+            gl->cprog = (GLuint)cprog, gl->valid |= GL_STATE_CPROG;
+        }
+
+        glUseProgram(gl->program = program);
+        gl->valid |= GL_STATE_PROGRAM;
+    }
+}
+
+/* ...bind external texture to active unit */
+static inline void gl_state_bind_texture_ext(GLuint tex) {
+    gl_state_t *gl = __gl_state_bindings();
+
+    if (!gl) {
+        glBindTexture(GL_TEXTURE_EXTERNAL_OES, tex);
+    } else if (!(gl->valid & GL_STATE_TEXTURE_EXT) || gl->texture_ext != tex) {
+        glBindTexture(GL_TEXTURE_EXTERNAL_OES, gl->texture_ext = tex);
+        gl->valid |= GL_STATE_TEXTURE_EXT;
+    }
+}
+
+/* ...bind buffer object */
+static inline void gl_state_bind_buffer(GLenum target, GLuint buffer) {
+    gl_state_t *gl = __gl_state_bindings();
+    GLuint *b;
+    u32 flag;
+
+    if (!gl) {
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (target == GL_ARRAY_BUFFER) {
+        b = &gl->array_buffer, flag = GL_STATE_ARRAY_BUFFER;
+    } else {
+        b = &gl->element_buffer, flag = GL_STATE_ELEMENT_BUFFER;
+    }
+
+    if (!(gl->valid & flag) || *b != buffer) {
+        glBindBuffer(target, *b = buffer);
+        gl->valid |= flag;
+    }
+}
+
+/* ...identity projection matrix (vertices are given in normalized device coordinates) */
+static const GLfloat __gl_identity[4 * 4] = {
+    1, 0, 0, 0,
+    0, 1, 0, 0,
+    0, 0, 1, 0,
+    0, 0, 0, 1,
+};
+
+/* ...hand the context over to cairo; restore its program if we have changed it */
+static inline void gl_state_enter_cairo(gl_state_t *gl) {
+    if ((gl->valid & (GL_STATE_PROGRAM | GL_STATE_CPROG)) == (GL_STATE_PROGRAM | GL_STATE_CPROG) && gl->program != gl->cprog) {
+        glUseProgram(gl->program = gl->cprog);
+    }
+}
+
+/* ...context returned from cairo; anything could have been changed */
+static inline void gl_state_leave_cairo(gl_state_t *gl) {
+    gl_state_invalidate(gl);
+}
+
+/* ...get thread CPU time in microseconds */
+static inline u32 __get_thread_cpu_usec(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return (u32)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+/* ...output accumulated GPU stage timings (defined below) */
+static void window_gpu_report(window_data_t *window);
+
+/* ...account rendering thread CPU time spent on a frame */
+static void window_cpu_update(window_data_t *window, u32 cpu) {
+    u32 ts = __get_time_usec();
+
+    window->cpu_acc += cpu, window->cpu_frames++;
+    (cpu > window->cpu_max ? window->cpu_max = cpu : 0);
+
+    if (window->cpu_ts == 0) {
+        window->cpu_ts = ts;
+    } else if ((u32)(ts - window->cpu_ts) >= WINDOW_CPU_REPORT_PERIOD) {
+        TRACE(INFO, _b("window[%p]: frame CPU time: avg=%u us, max=%u us (%u frames)"), window, window->cpu_acc / window->cpu_frames, window->cpu_max, window->cpu_frames);
+        window_gpu_report(window);
+        window->cpu_ts = ts, window->cpu_acc = window->cpu_max = window->cpu_frames = 0;
+    }
+}
+
 /*******************************************************************************
  * Local variables
  ******************************************************************************/
@@ -309,6 +664,25 @@ struct window_data {
 /* ...this should be singleton for now - tbd */
 static display_data_t __display;
 
+/* ...display runs without Wayland connection (KMS or X11 backend) */
+static inline int __display_native(display_data_t *display) {
+#ifdef DISPLAY_X11_ENABLED
+    if (display->x11) return 1;
+#endif
+#ifdef DISPLAY_DRM_ENABLED
+    if (display->drm) return 1;
+#endif
+    return 0;
+}
+
+/* ...display backend name */
+static inline const char * __display_backend(display_data_t *display) {
+#ifdef DISPLAY_DRM_ENABLED
+    if (display->drm) return "KMS";
+#endif
+    return (__display_native(display) ? "X11" : "Wayland");
+}
+
 /*******************************************************************************
  * EGL functions binding (make them global; create EGL adaptation layer - tbd)
  ******************************************************************************/
@@ -324,6 +698,17 @@ PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOES;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOES;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOES;
 PFNGLISVERTEXARRAYOESPROC glIsVertexArrayOES;
+static PFNGLMAPBUFFERRANGEEXTPROC glMapBufferRangeEXT;
+static PFNGLMAPBUFFERRANGEPROC_ glMapBufferRange;
+static PFNGLUNMAPBUFFERPROC_ glUnmapBuffer;
+static PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOES;
+static PFNGLPROGRAMBINARYOESPROC glProgramBinaryOES;
+static PFNGLGENQUERIESEXTPROC glGenQueriesEXT;
+static PFNGLDELETEQUERIESEXTPROC glDeleteQueriesEXT;
+static PFNGLBEGINQUERYEXTPROC glBeginQueryEXT;
+static PFNGLENDQUERYEXTPROC glEndQueryEXT;
+static PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT;
+static PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
 
 PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR;
 PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR;
@@ -392,6 +777,99 @@ static const char texture_fragment_shader_ext[] =
         "   gl_FragColor = vec4(texture2D(tex, v_texcoord).rgb, alpha);\n"
         "}\n";
 
+/* ...fragment shader composing cached widget layer (premultiplied cairo ARGB32) over a dimmed scene */
+static const char gui_fragment_shader[] =
+        "varying mediump vec2 v_texcoord;\n"
+        "uniform sampler2D tex;\n"
+        "uniform mediump float alpha;\n"
+        "uniform mediump float dim;\n"
+        "void main()\n"
+        "{\n"
+        "   mediump vec4 c = texture2D(tex, v_texcoord).bgra * alpha;\n"
+        "   if (any(lessThan(v_texcoord, vec2(0.0))) || any(greaterThan(v_texcoord, vec2(1.0)))) c = vec4(0.0);\n"
+        "   gl_FragColor = vec4(c.rgb, dim + c.a - dim * c.a);\n"
+        "}\n";
+
+/* ...text vertex shader (viewport pixel coordinates, per-vertex color) */
+static const char text_vertex_shader[] =
+        "uniform mat4 proj;\n"
+        "attribute vec2 position;\n"
+        "attribute vec2 texcoord;\n"
+        "attribute vec4 color;\n"
+        "varying vec2 v_texcoord;\n"
+        "varying vec4 v_color;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = proj * vec4(position, 0.0, 1.0);\n"
+        "   v_texcoord = texcoord;\n"
+        "   v_color = color;\n"
+        "}\n";
+
+/* ...text fragment shader (glyph coverage modulates premultiplied color) */
+static const char text_fragment_shader[] =
+        "varying mediump vec2 v_texcoord;\n"
+        "varying lowp vec4 v_color;\n"
+        "uniform sampler2D tex;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_FragColor = v_color * texture2D(tex, v_texcoord).a;\n"
+        "}\n";
+
+/* ...overlay primitives vertex shader (viewport pixel coordinates, per-vertex color) */
+static const char overlay_vertex_shader[] =
+        "uniform mat4 proj;\n"
+        "attribute vec2 position;\n"
+        "attribute vec4 color;\n"
+        "varying vec4 v_color;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = proj * vec4(position, 0.0, 1.0);\n"
+        "   v_color = color;\n"
+        "}\n";
+
+/* ...overlay primitives fragment shader */
+static const char overlay_fragment_shader[] =
+        "varying lowp vec4 v_color;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_FragColor = v_color;\n"
+        "}\n";
+
+/* ...vertex shader for batched textures (per-vertex texture unit index) */
+static const char batch_vertex_shader[] =
+        "uniform mat4 proj;\n"
+        "attribute vec2 position;\n"
+        "attribute vec2 texcoord;\n"
+        "attribute float index;\n"
+        "varying vec2 v_texcoord;\n"
+        "varying float v_index;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = proj * vec4(position, 0.0, 1.0);\n"
+        "   v_texcoord = texcoord;\n"
+        "   v_index = index;\n"
+        "}\n";
+
+/* ...fragment shader for batched external textures (up to TEXTURE_BATCH_MAX units) */
+static const char batch_fragment_shader_ext[] =
+        "#extension GL_OES_EGL_image_external : enable\n"
+        "varying mediump vec2 v_texcoord;\n"
+        "varying mediump float v_index;\n"
+        "uniform samplerExternalOES tex0;\n"
+        "uniform samplerExternalOES tex1;\n"
+        "uniform samplerExternalOES tex2;\n"
+        "uniform samplerExternalOES tex3;\n"
+        "uniform mediump float alpha;\n"
+        "void main()\n"
+        "{\n"
+        "   mediump vec3 c;\n"
+        "   if (v_index < 0.5) c = texture2D(tex0, v_texcoord).rgb;\n"
+        "   else if (v_index < 1.5) c = texture2D(tex1, v_texcoord).rgb;\n"
+        "   else if (v_index < 2.5) c = texture2D(tex2, v_texcoord).rgb;\n"
+        "   else c = texture2D(tex3, v_texcoord).rgb;\n"
+        "   gl_FragColor = vec4(c, alpha);\n"
+        "}\n";
+
 /* ...VBO vertex shader */
 static const char vbo_vertex_shader[] =
         //"precision mediump float;\n"	
@@ -517,6 +995,71 @@ error:
     return (void *) (intptr_t) - errno;
 }
 
+#ifdef DISPLAY_DRM_ENABLED
+/* ...DRM events processing (page-flip completions) */
+static int display_kms_event(display_data_t *display, display_source_cb_t *cb, u32 events) {
+    return kms_dispatch(display->drm);
+}
+
+static display_source_cb_t kms_source = {
+    .hook = display_kms_event,
+};
+#endif
+
+#ifdef DISPLAY_X11_ENABLED
+/* ...X events processing (input) */
+static int display_x11_event(display_data_t *display, display_source_cb_t *cb, u32 events) {
+    return x11_dispatch(display->x11);
+}
+
+static display_source_cb_t x11_source = {
+    .hook = display_x11_event,
+};
+#endif
+
+/* ...dispatch thread of direct KMS or X11 display (no Wayland connection) */
+static void * dispatch_thread_epoll(void *arg) {
+    display_data_t *display = arg;
+    struct epoll_event event[DISPLAY_EVENTS_NUM];
+
+#ifdef DISPLAY_X11_ENABLED
+    /* ...add X server connection descriptor */
+    if (display->x11) {
+        CHK_ERR(display_add_poll_source(display, x11_fd(display->x11), &x11_source) == 0, NULL);
+
+        /* ...process events queued while connection was set up */
+        x11_dispatch(display->x11);
+    }
+#endif
+
+#ifdef DISPLAY_DRM_ENABLED
+    /* ...add DRM device file descriptor */
+    if (display->drm) {
+        CHK_ERR(display_add_poll_source(display, kms_fd(display->drm), &kms_source) == 0, NULL);
+    }
+#endif
+
+    while (1) {
+        int i, r;
+
+        /* ...wait for an event */
+        if ((r = epoll_wait(display->efd, event, DISPLAY_EVENTS_NUM, -1)) < 0) {
+            if (errno == EINTR) continue;
+            TRACE(ERROR, _x("epoll failed: %m"));
+            return (void *) (intptr_t) - errno;
+        }
+
+        /* ...process all signalled events (ignore result code) */
+        for (i = 0; i < r; i++) {
+            display_source_cb_t *dispatch = event[i].data.ptr;
+
+            dispatch->hook(display, dispatch, event[i].events);
+        }
+    }
+
+    return NULL;
+}
+
 /*******************************************************************************
  * Output device handling
  ******************************************************************************/
@@ -1223,6 +1766,65 @@ error:
 }
 #endif
 
+/*******************************************************************************
+ * Linux dma-buf interface
+ ******************************************************************************/
+
+#ifdef DISPLAY_PLANE_ENABLED
+/* ...record format/modifier pair accepted by compositor */
+static void display_dmabuf_add(display_data_t *display, u32 format, u64 modifier) {
+    int i = display->dmabuf_formats_num;
+
+    if (i == DISPLAY_DMABUF_FORMATS) {
+        TRACE(DEBUG, _b("dma-buf format %.4s/%llX ignored"), (char *)&format, (unsigned long long)modifier);
+        return;
+    }
+
+    display->dmabuf_formats[i].format = format;
+    display->dmabuf_formats[i].modifier = modifier;
+    display->dmabuf_formats_num = i + 1;
+}
+
+/* ...buffer format supported by compositor with implicit layout (version 2 only) */
+static void dmabuf_handle_format(void *data, struct zwp_linux_dmabuf_v1 *dmabuf, uint32_t format) {
+    display_data_t *display = data;
+
+    TRACE(DEBUG, _b("dma-buf format: %.4s"), (char *)&format);
+
+    /* ...version 3 announces every accepted layout through modifier events */
+    if (zwp_linux_dmabuf_v1_get_version(dmabuf) < 3) {
+        display_dmabuf_add(display, format, DRM_FORMAT_MOD_INVALID);
+    }
+}
+
+/* ...buffer format and layout modifier supported by compositor */
+static void dmabuf_handle_modifier(void *data, struct zwp_linux_dmabuf_v1 *dmabuf, uint32_t format,
+        uint32_t modifier_hi, uint32_t modifier_lo) {
+    display_data_t *display = data;
+    u64 modifier = ((u64)modifier_hi << 32) | modifier_lo;
+
+    TRACE(DEBUG, _b("dma-buf format: %.4s, modifier: %llX"), (char *)&format, (unsigned long long)modifier);
+
+    display_dmabuf_add(display, format, modifier);
+}
+
+static const struct zwp_linux_dmabuf_v1_listener dmabuf_listener = {
+    dmabuf_handle_format,
+    dmabuf_handle_modifier,
+};
+
+/* ...check if compositor accepts dma-buf format with given layout modifier */
+static int display_dmabuf_format(display_data_t *display, u32 format, u64 modifier) {
+    int i;
+
+    for (i = 0; i < display->dmabuf_formats_num; i++) {
+        if (display->dmabuf_formats[i].format == format && display->dmabuf_formats[i].modifier == modifier) return 1;
+    }
+
+    return 0;
+}
+#endif
+
 /*******************************************************************************
  * Registry listener callbacks
  ******************************************************************************/
@@ -1233,11 +1835,20 @@ static void global_registry_handler(void *data, struct wl_registry *registry, ui
     display_data_t *display = data;
 
     if (strcmp(interface, "wl_compositor") == 0) {
-        display->compositor = wl_registry_bind(registry, id, &wl_compositor_interface, 1);
+        /* ...version 2 is needed for wl_surface_set_buffer_transform (rotation offloaded to compositor) */
+        display->compositor = wl_registry_bind(registry, id, &wl_compositor_interface, (version < 2 ? version : 2));
     } else if (strcmp(interface, "wl_subcompositor") == 0) {
         display->subcompositor = wl_registry_bind(registry, id, &wl_subcompositor_interface, 1);
     } else if (strcmp(interface, "wl_shell") == 0) {
         display->shell = wl_registry_bind(registry, id, &wl_shell_interface, 1);
+#ifdef DISPLAY_PLANE_ENABLED
+    } else if (strcmp(interface, "zwp_linux_dmabuf_v1") == 0) {
+        /* ...bind up to version 3; format modifiers are announced since version 3 */
+        display->dmabuf = wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, (version < 3 ? version : 3));
+        zwp_linux_dmabuf_v1_add_listener(display->dmabuf, &dmabuf_listener, display);
+    } else if (strcmp(interface, "wp_viewporter") == 0) {
+        display->viewporter = wl_registry_bind(registry, id, &wp_viewporter_interface, 1);
+#endif
     } else if (strcmp(interface, "wl_output") == 0) {
         display_add_output(display, registry, id);
     } else if (strcmp(interface, "wl_seat") == 0) {
@@ -1296,15 +1907,33 @@ static const EGLint __egl_context_attribs[] = {
 
 /* ...destroy EGL context */
 static void fini_egl(display_data_t *display) {
+    /* ...worker threads hold shared contexts; stop them first */
+    widget_rasterizer_stop();
+    texture_upload_stop();
+
     eglTerminate(display->egl.dpy);
     eglReleaseThread();
 }
 
-/* ...initialize EGL */
-static int init_egl(display_data_t *display) {
-    /* ...EGL configuration attributes */
-    EGLint config_attribs[] = {
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+/* ...check if extension is present in the space-separated list */
+static int __egl_has_extension(const char *extensions, const char *name) {
+    int len = strlen(name);
+    const char *s;
+
+    for (s = extensions; (s = strstr(s, name)) != NULL; s += len) {
+        if ((s == extensions || s[-1] == ' ') && (s[len] == ' ' || s[len] == '\0')) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* ...initialize EGL */
+static int init_egl(display_data_t *display) {
+    /* ...EGL configuration attributes */
+    EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
         EGL_BUFFER_SIZE, 24,
         EGL_DEPTH_SIZE, 1,
         EGL_RED_SIZE, 1,
@@ -1319,8 +1948,20 @@ static int init_egl(display_data_t *display) {
     EGLDisplay dpy;
     const char *extensions;
 
-    /* ...get Wayland EGL display */
-    CHK_ERR(display->egl.dpy = dpy = eglGetDisplay(display->display), -ENOENT);
+    /* ...get EGL display of Wayland connection, GBM device or X server */
+#ifdef DISPLAY_DRM_ENABLED
+    if (display->drm) {
+        CHK_ERR(display->egl.dpy = dpy = eglGetDisplay((EGLNativeDisplayType) kms_gbm_device(display->drm)), -ENOENT);
+    } else
+#endif
+#ifdef DISPLAY_X11_ENABLED
+    if (display->x11) {
+        CHK_ERR(display->egl.dpy = dpy = eglGetDisplay((EGLNativeDisplayType) x11_native_display(display->x11)), -ENOENT);
+    } else
+#endif
+    {
+        CHK_ERR(display->egl.dpy = dpy = eglGetDisplay(display->display), -ENOENT);
+    }
 
     /* ...initialize EGL module? */
     if (!eglInitialize(dpy, &major, &minor)) {
@@ -1365,6 +2006,24 @@ static int init_egl(display_data_t *display) {
 
         TRACE(INFO, _b("config[%u of %u]: id=%X, size=%X"), i, n, id, size);
 
+#ifdef DISPLAY_X11_ENABLED
+        /* ...X11 window is created with the config visual; any depth will do */
+        if (display->x11) {
+            if (id == 0) continue;
+            display->egl.conf = configs[i];
+            goto found;
+        }
+#endif
+
+#ifdef DISPLAY_DRM_ENABLED
+        /* ...GBM surfaces use the config visual as scanout format */
+        if (display->drm) {
+            if (id != GBM_FORMAT_XRGB8888) continue;
+            display->egl.conf = configs[i];
+            goto found;
+        }
+#endif
+
         /* ...check if we have a 32-bit buffer size - tbd */
         if (size != 32) continue;
 
@@ -1390,6 +2049,17 @@ found:
     glDeleteVertexArraysOES = (void *) eglGetProcAddress("glDeleteVertexArraysOES");
     glGenVertexArraysOES = (void *) eglGetProcAddress("glGenVertexArraysOES");
     glIsVertexArrayOES = (void *) eglGetProcAddress("glIsVertexArrayOES");
+    glMapBufferRangeEXT = (void *) eglGetProcAddress("glMapBufferRangeEXT");
+    glMapBufferRange = (void *) eglGetProcAddress("glMapBufferRange");
+    glUnmapBuffer = (void *) eglGetProcAddress("glUnmapBuffer");
+    glGetProgramBinaryOES = (void *) eglGetProcAddress("glGetProgramBinaryOES");
+    glProgramBinaryOES = (void *) eglGetProcAddress("glProgramBinaryOES");
+    glGenQueriesEXT = (void *) eglGetProcAddress("glGenQueriesEXT");
+    glDeleteQueriesEXT = (void *) eglGetProcAddress("glDeleteQueriesEXT");
+    glBeginQueryEXT = (void *) eglGetProcAddress("glBeginQueryEXT");
+    glEndQueryEXT = (void *) eglGetProcAddress("glEndQueryEXT");
+    glGetQueryObjectuivEXT = (void *) eglGetProcAddress("glGetQueryObjectuivEXT");
+    glGetQueryObjectui64vEXT = (void *) eglGetProcAddress("glGetQueryObjectui64vEXT");
 
     eglCreateSyncKHR = (void *) eglGetProcAddress("eglCreateSyncKHR");
     eglDestroySyncKHR = (void *) eglGetProcAddress("eglDestroySyncKHR");
@@ -1401,6 +2071,17 @@ found:
     /* ...check for specific EGL extensions */
     if ((extensions = eglQueryString(display->egl.dpy, EGL_EXTENSIONS)) != NULL) {
         TRACE(INIT, _b("EGL extensions: %s"), extensions);
+
+        /* ...standard zero-copy import of DMA buffers */
+        (__egl_has_extension(extensions, "EGL_EXT_image_dma_buf_import") ? display->egl.ext |= EGL_DATA_EXT_DMABUF_IMPORT : 0);
+        (__egl_has_extension(extensions, "EGL_EXT_image_dma_buf_import_modifiers") ? display->egl.ext |= EGL_DATA_EXT_DMABUF_MODIFIERS : 0);
+
+        /* ...partial updates hint for a compositor */
+        (eglSwapBuffersWithDamageEXT && __egl_has_extension(extensions, "EGL_EXT_swap_buffers_with_damage") ? display->egl.ext |= EGL_DATA_EXT_SWAP_DAMAGE : 0);
+
+        TRACE(INIT, _b("dma-buf import: %s (modifiers: %s)"),
+              (display->egl.ext & EGL_DATA_EXT_DMABUF_IMPORT ? "yes" : "no"),
+              (display->egl.ext & EGL_DATA_EXT_DMABUF_MODIFIERS ? "yes" : "no"));
     }
 
     /* ...create display (shared?) EGL context */
@@ -1442,6 +2123,167 @@ error:
     return -1;
 }
 
+/*******************************************************************************
+ * Program binary cache
+ ******************************************************************************/
+
+/* ...cache directory (default is utest-adas in $XDG_CACHE_HOME or $XDG_RUNTIME_DIR; empty string disables cache) */
+const char *program_cache_dir;
+
+/* ...cache file header */
+typedef struct program_cache_hdr {
+    /* ...file signature */
+    u32 magic;
+
+    /* ...binary format and length */
+    u32 format, length;
+
+    /* ...program key (protects against hash-named file collisions) */
+    u64 key;
+
+} program_cache_hdr_t;
+
+#define PROGRAM_CACHE_MAGIC             0x43425055
+
+/* ...FNV-1a hash accumulation */
+static inline u64 __fnv1a(u64 h, const char *s) {
+    while (s && *s) {
+        h = (h ^ (u8)*s++) * 0x100000001B3ULL;
+    }
+
+    /* ...separate fields so that concatenations do not collide */
+    return (h ^ 0xFF) * 0x100000001B3ULL;
+}
+
+/* ...program key: driver identification and program sources */
+static u64 program_cache_key(const char *vs, const char *fs, const char * const *attribs) {
+    u64 h = 0xCBF29CE484222325ULL;
+
+    h = __fnv1a(h, (const char *) glGetString(GL_VENDOR));
+    h = __fnv1a(h, (const char *) glGetString(GL_RENDERER));
+    h = __fnv1a(h, (const char *) glGetString(GL_VERSION));
+    h = __fnv1a(h, vs);
+    h = __fnv1a(h, fs);
+
+    while (*attribs) {
+        h = __fnv1a(h, *attribs++);
+    }
+
+    return h;
+}
+
+/* ...get cache file name; returns 0 if caching is disabled */
+static int program_cache_path(char *path, size_t size, u64 key) {
+    const char *dir = program_cache_dir, *base;
+
+    if (!(__display.gl_ext & DISPLAY_GL_EXT_PROGRAM_BINARY) || (dir && !*dir)) {
+        return 0;
+    }
+
+    if (dir) {
+        mkdir(dir, 0700);
+        snprintf(path, size, "%s/%016llx.bin", dir, (unsigned long long)key);
+    } else if ((base = getenv("XDG_CACHE_HOME")) != NULL || (base = getenv("XDG_RUNTIME_DIR")) != NULL) {
+        snprintf(path, size, "%s/utest-adas", base), mkdir(path, 0700);
+        snprintf(path, size, "%s/utest-adas/%016llx.bin", base, (unsigned long long)key);
+    } else {
+        /* ...no private location; shared directories are not used */
+        return 0;
+    }
+
+    return 1;
+}
+
+/* ...load program binary from cache; returns GL_NONE on miss */
+static GLuint program_cache_load(const char *path, u64 key) {
+    program_cache_hdr_t hdr;
+    GLuint program = GL_NONE;
+    struct stat st;
+    GLint status;
+    void *data;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY | O_NOFOLLOW)) < 0) {
+        return GL_NONE;
+    }
+
+    if (read(fd, &hdr, sizeof (hdr)) != sizeof (hdr) || hdr.magic != PROGRAM_CACHE_MAGIC || hdr.key != key) {
+        TRACE(INFO, _b("program cache: stale entry '%s'"), path);
+        goto out;
+    }
+
+    /* ...binary length must match file size (truncated or corrupted entry is a miss) */
+    if (fstat(fd, &st) < 0 || hdr.length == 0 || (u64)st.st_size != sizeof (hdr) + (u64)hdr.length) {
+        TRACE(INFO, _b("program cache: corrupted entry '%s' (length=%u)"), path, hdr.length);
+        goto out;
+    }
+
+    if ((data = malloc(hdr.length)) == NULL) {
+        goto out;
+    }
+
+    if (read(fd, data, hdr.length) == (ssize_t)hdr.length) {
+        program = glCreateProgram();
+        glProgramBinaryOES(program, hdr.format, data, hdr.length);
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+        /* ...binary is rejected e.g. after driver update; rebuild from sources */
+        if (!status) {
+            TRACE(INFO, _b("program cache: binary rejected '%s'"), path);
+            glDeleteProgram(program), program = GL_NONE;
+        }
+    }
+
+    free(data);
+
+out:
+    close(fd);
+
+    /* ...drop unusable entry; it is rewritten after compilation */
+    (program == GL_NONE ? unlink(path) : 0);
+
+    return program;
+}
+
+/* ...store linked program binary in cache */
+static void program_cache_store(const char *path, GLuint program, u64 key) {
+    program_cache_hdr_t hdr = { .magic = PROGRAM_CACHE_MAGIC, .key = key };
+    char tmp[PATH_MAX];
+    GLint length = 0;
+    GLsizei size;
+    void *data;
+    int fd, r;
+
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0 || (data = malloc(length)) == NULL) {
+        return;
+    }
+
+    glGetProgramBinaryOES(program, length, &size, &hdr.format, data);
+    hdr.length = size;
+
+    /* ...write into exclusively created temporary file and rename it to keep entries consistent */
+    snprintf(tmp, sizeof (tmp), "%s.XXXXXX", path);
+    if ((fd = mkstemp(tmp)) < 0) {
+        TRACE(INFO, _b("program cache: cannot create '%s': %m"), tmp);
+        free(data);
+        return;
+    }
+
+    r = (write(fd, &hdr, sizeof (hdr)) == sizeof (hdr) && write(fd, data, size) == size);
+    close(fd);
+    free(data);
+
+    if (!r || rename(tmp, path) < 0) {
+        TRACE(INFO, _b("program cache: failed to store '%s': %m"), path);
+        unlink(tmp);
+    }
+}
+
+/*******************************************************************************
+ * Shaders compilation
+ ******************************************************************************/
+
 /* ...shader compilation code */
 static int compile_shader(GLenum type, int count, const char **sources) {
     GLuint s;
@@ -1466,10 +2308,27 @@ static int compile_shader(GLenum type, int count, const char **sources) {
     }
 }
 
-/* ...initialize shader code */
-static int shader_init(gl_shader_t *shader, const char *vertex_source, const char *fragment_source, int planes) {
-    char msg[512];
+/* ...build program from cache or sources (attributes are bound to their indices) */
+static int program_build(gl_shader_t *shader, const char *vertex_source, const char *fragment_source, const char * const *attribs) {
+    display_data_t *display = &__display;
+    char path[PATH_MAX], msg[512];
+    u32 t0 = __get_time_usec(), t1;
+    int cached;
     GLint status;
+    u64 key = 0;
+    int i;
+
+    /* ...try binary cache first */
+    if ((cached = program_cache_path(path, sizeof (path), key = program_cache_key(vertex_source, fragment_source, attribs))) != 0) {
+        if ((shader->program = program_cache_load(path, key)) != GL_NONE) {
+            shader->vertex_shader = shader->fragment_shader = GL_NONE;
+            t1 = __get_time_usec();
+            __sync_fetch_and_add(&display->pcache_hits, 1);
+            __sync_fetch_and_add(&display->pcache_load_us, t1 - t0);
+            TRACE(INIT, _b("program %016llx loaded from cache in %u us"), (unsigned long long)key, t1 - t0);
+            return 0;
+        }
+    }
 
     /* ...vertex shader compilation (single source) */
     shader->vertex_shader = compile_shader(GL_VERTEX_SHADER, 1, &vertex_source);
@@ -1485,8 +2344,9 @@ static int shader_init(gl_shader_t *shader, const char *vertex_source, const cha
     shader->program = glCreateProgram();
     glAttachShader(shader->program, shader->vertex_shader);
     glAttachShader(shader->program, shader->fragment_shader);
-    glBindAttribLocation(shader->program, 0, "position");
-    glBindAttribLocation(shader->program, 1, "texcoord");
+    for (i = 0; attribs[i]; i++) {
+        glBindAttribLocation(shader->program, i, attribs[i]);
+    }
     glLinkProgram(shader->program);
 
     glGetProgramiv(shader->program, GL_LINK_STATUS, &status);
@@ -1496,6 +2356,25 @@ static int shader_init(gl_shader_t *shader, const char *vertex_source, const cha
         return -EINVAL;
     }
 
+    /* ...save binary for next start */
+    if (cached) {
+        program_cache_store(path, shader->program, key);
+    }
+
+    t1 = __get_time_usec();
+    __sync_fetch_and_add(&display->pcache_misses, 1);
+    __sync_fetch_and_add(&display->pcache_build_us, t1 - t0);
+    TRACE(INIT, _b("program %016llx built from sources in %u us"), (unsigned long long)key, t1 - t0);
+
+    return 0;
+}
+
+/* ...initialize shader code */
+static int shader_init(gl_shader_t *shader, const char *vertex_source, const char *fragment_source, int planes) {
+    static const char * const attribs[] = { "position", "texcoord", NULL };
+
+    CHK_API(program_build(shader, vertex_source, fragment_source, attribs));
+
     shader->proj_uniform = glGetUniformLocation(shader->program, "proj");
     shader->tex_uniforms[0] = glGetUniformLocation(shader->program, "tex");
     shader->alpha_uniform = glGetUniformLocation(shader->program, "alpha");
@@ -1508,43 +2387,55 @@ static int shader_init(gl_shader_t *shader, const char *vertex_source, const cha
 
 /* ...VBO shader compilation */
 static int vbo_shader_init(gl_shader_t *shader, const char *vertex_source, const char *fragment_source) {
-    char msg[512];
-    GLint status;
+    static const char * const attribs[] = { "v", NULL };
 
-    /* ...vertex shader compilation (single source) */
-    shader->vertex_shader = compile_shader(GL_VERTEX_SHADER, 1, &vertex_source);
-    if (shader->vertex_shader == GL_NONE) {
-        TRACE(ERROR, _x("OpenGL error: %X"), glGetError());
-        return -EINVAL;
-    }
+    CHK_API(program_build(shader, vertex_source, fragment_source, attribs));
 
-    /* ...fragment shader compilation (single source) */
-    shader->fragment_shader = compile_shader(GL_FRAGMENT_SHADER, 1, &fragment_source);
-    CHK_ERR(shader->fragment_shader != GL_NONE, -EINVAL);
+    shader->proj_uniform = glGetUniformLocation(shader->program, "proj");
+    shader->width_uniform = glGetUniformLocation(shader->program, "maxdist");
 
-    shader->program = glCreateProgram();
-    glAttachShader(shader->program, shader->vertex_shader);
-    glAttachShader(shader->program, shader->fragment_shader);
-    glBindAttribLocation(shader->program, 0, "v");
-    glLinkProgram(shader->program);
+    TRACE(INIT, _b("vbo shader %p compiled (prog=%u, proj=%u, maxdist=%u)"), shader, shader->program, shader->proj_uniform, shader->width_uniform);
 
-    glGetProgramiv(shader->program, GL_LINK_STATUS, &status);
-    if (!status) {
-        glGetProgramInfoLog(shader->program, sizeof (msg), NULL, msg);
-        TRACE(ERROR, _x("program link error: %s"), msg);
-        return -EINVAL;
+    return 0;
+}
+
+/* ...batched textures shader compilation */
+static int batch_shader_init(gl_shader_t *shader, const char *vertex_source, const char *fragment_source) {
+    static const char * const attribs[] = { "position", "texcoord", "index", NULL };
+    static const char * const names[] = { "tex0", "tex1", "tex2", "tex3" };
+    int i;
+
+    CHK_API(program_build(shader, vertex_source, fragment_source, attribs));
+
+    shader->proj_uniform = glGetUniformLocation(shader->program, "proj");
+    shader->alpha_uniform = glGetUniformLocation(shader->program, "alpha");
+
+    for (i = 0; i < TEXTURE_BATCH_MAX; i++) {
+        shader->tex_uniforms[i] = glGetUniformLocation(shader->program, names[i]);
     }
 
+    TRACE(INIT, _b("batch shader %p compiled (prog=%d, proj=%d, alpha=%d)"), shader, shader->program, shader->proj_uniform, shader->alpha_uniform);
+
+    return 0;
+}
+
+/* ...text and overlay primitives shaders compilation */
+static int pixel_shader_init(gl_shader_t *shader, const char *vertex_source, const char *fragment_source, const char * const *attribs) {
+    CHK_API(program_build(shader, vertex_source, fragment_source, attribs));
+
     shader->proj_uniform = glGetUniformLocation(shader->program, "proj");
-    shader->width_uniform = glGetUniformLocation(shader->program, "maxdist");
+    shader->tex_uniforms[0] = glGetUniformLocation(shader->program, "tex");
 
-    TRACE(INIT, _b("vbo shader %p compiled (prog=%u, proj=%u, maxdist=%u)"), shader, shader->program, shader->proj_uniform, shader->width_uniform);
+    TRACE(INIT, _b("pixel shader %p compiled (prog=%d, proj=%d, tex=%d)"), shader, shader->program, shader->proj_uniform, shader->tex_uniforms[0]);
 
     return 0;
 }
 
 /* ...compile texture shader */
 static int compile_shaders(display_data_t *display) {
+    static const char * const text_attribs[] = { "position", "texcoord", "color", NULL };
+    static const char * const overlay_attribs[] = { "position", "color", NULL };
+
     /* ...external texture rendering shader */
     if (shader_init(&display->shader_ext, vertex_shader, texture_fragment_shader_ext, 1) < 0) {
         TRACE(ERROR, _x("EXT-shader compilation error"));
@@ -1557,8 +2448,37 @@ static int compile_shaders(display_data_t *display) {
         return -1;
     }
 
+    /* ...batched textures rendering shader */
+    if (batch_shader_init(&display->shader_batch, batch_vertex_shader, batch_fragment_shader_ext) < 0) {
+        TRACE(ERROR, _x("batch-shader compilation error"));
+        return -1;
+    }
+
+    /* ...widget layers composition shader */
+    if (shader_init(&display->shader_gui, vertex_shader, gui_fragment_shader, 1) < 0) {
+        TRACE(ERROR, _x("GUI-shader compilation error"));
+        return -1;
+    }
+
+    display->shader_gui.dim_uniform = glGetUniformLocation(display->shader_gui.program, "dim");
+
+    /* ...glyph-atlas text rendering shader */
+    if (pixel_shader_init(&display->shader_text, text_vertex_shader, text_fragment_shader, text_attribs) < 0) {
+        TRACE(ERROR, _x("text-shader compilation error"));
+        return -1;
+    }
+
+    /* ...overlay primitives rendering shader */
+    if (pixel_shader_init(&display->shader_overlay, overlay_vertex_shader, overlay_fragment_shader, overlay_attribs) < 0) {
+        TRACE(ERROR, _x("overlay-shader compilation error"));
+        return -1;
+    }
+
     TRACE(INIT, _b("shaders built: ext=%d"), display->shader_ext.program);
 
+    TRACE(INIT, _b("program cache: %u hits (%u us), %u misses (%u us)"),
+          display->pcache_hits, display->pcache_load_us, display->pcache_misses, display->pcache_build_us);
+
     return 0;
 }
 
@@ -1636,26 +2556,157 @@ EGLContext window_egl_context(window_data_t *window) {
     return window->user_egl_ctx;
 }
 
-/* ...get exclusive access to shared EGL context */
-static inline void display_egl_ctx_get(display_data_t *display)
-{
-    /* ...we should not call that function in user-window context */
-    BUG(eglGetCurrentContext() != EGL_NO_CONTEXT, _x("invalid egl context"));
+/*******************************************************************************
+ * Resource thread (GL objects creation and destruction)
+ ******************************************************************************/
+
+/* ...resource command function (executed with a shared context current) */
+typedef int (*resource_fn_t)(display_data_t *display, void *arg);
+
+/* ...command completion future */
+typedef struct resource_future {
+    /* ...completion lock and signalling variable */
+    pthread_mutex_t lock;
+    pthread_cond_t wait;
+
+    /* ...completion flag and command result */
+    int done, result;
 
-    /* ...get shared context lock */
-    pthread_mutex_lock(&display->lock);
+} resource_future_t;
+
+/* ...resource command */
+struct resource_cmd {
+    /* ...next command in a queue */
+    resource_cmd_t *next;
+
+    /* ...command function and argument */
+    resource_fn_t fn;
+    void *arg;
+
+    /* ...completion future (NULL for asynchronous commands) */
+    resource_future_t *future;
+};
+
+/* ...resource thread; the only user of the shared display context */
+static void * resource_thread(void *arg) {
+    display_data_t *display = arg;
+    resource_cmd_t *cmd;
+    resource_future_t *future;
+    int r;
 
     /* ...display context is shared with all windows; context is surfaceless */
     eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, display->egl.ctx);
+
+    pthread_mutex_lock(&display->resource_lock);
+
+    while (1) {
+        /* ...wait for a command */
+        while ((cmd = display->resource_head) == NULL) {
+            pthread_cond_wait(&display->resource_wait, &display->resource_lock);
+        }
+
+        /* ...dequeue command */
+        if ((display->resource_head = cmd->next) == NULL) {
+            display->resource_tail = &display->resource_head;
+        }
+
+        pthread_mutex_unlock(&display->resource_lock);
+
+        r = cmd->fn(display, cmd->arg);
+
+        if ((future = cmd->future) != NULL) {
+            /* ...make created objects visible to other contexts before completion */
+            glFinish();
+
+            /* ...command is owned by the caller; do not touch it after signalling */
+            pthread_mutex_lock(&future->lock);
+            future->result = r, future->done = 1;
+            pthread_cond_signal(&future->wait);
+            pthread_mutex_unlock(&future->lock);
+        } else {
+            free(cmd);
+        }
+
+        pthread_mutex_lock(&display->resource_lock);
+    }
+
+    return NULL;
 }
 
-/* ...release shared EGL context */
-static inline void display_egl_ctx_put(display_data_t *display) {
-    /* ...display context is shared with all windows; context is surfaceless */
-    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+/* ...place command into resource queue */
+static void resource_submit(display_data_t *display, resource_cmd_t *cmd) {
+    cmd->next = NULL;
+
+    pthread_mutex_lock(&display->resource_lock);
+    *display->resource_tail = cmd, display->resource_tail = &cmd->next;
+    pthread_cond_signal(&display->resource_wait);
+    pthread_mutex_unlock(&display->resource_lock);
+}
+
+/* ...execute command and wait for its result (inline if caller has a context) */
+static int resource_call(display_data_t *display, resource_fn_t fn, void *arg) {
+    resource_future_t future;
+    resource_cmd_t cmd;
+
+    /* ...objects are shared; current (window or resource) context can be used directly */
+    if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+        return fn(display, arg);
+    }
+
+    pthread_mutex_init(&future.lock, NULL);
+    pthread_cond_init(&future.wait, NULL);
+    future.done = 0;
+    cmd.fn = fn, cmd.arg = arg, cmd.future = &future;
+
+    resource_submit(display, &cmd);
+
+    /* ...wait for command completion */
+    pthread_mutex_lock(&future.lock);
+    while (!future.done) {
+        pthread_cond_wait(&future.wait, &future.lock);
+    }
+    pthread_mutex_unlock(&future.lock);
+
+    pthread_cond_destroy(&future.wait);
+    pthread_mutex_destroy(&future.lock);
+
+    return future.result;
+}
+
+/* ...execute command asynchronously (inline if caller has a context) */
+static int resource_post(display_data_t *display, resource_fn_t fn, void *arg) {
+    resource_cmd_t *cmd;
+
+    if (eglGetCurrentContext() != EGL_NO_CONTEXT) {
+        return fn(display, arg);
+    }
 
-    /* ...release shared context lock */
-    pthread_mutex_unlock(&display->lock);
+    /* ...command is freed by resource thread */
+    if ((cmd = malloc(sizeof (*cmd))) == NULL) {
+        TRACE(ERROR, _x("failed to allocate command; execute synchronously"));
+        return resource_call(display, fn, arg);
+    }
+
+    cmd->fn = fn, cmd->arg = arg, cmd->future = NULL;
+    resource_submit(display, cmd);
+
+    return 0;
+}
+
+/* ...start resource thread */
+static int resource_start(display_data_t *display) {
+    int r;
+
+    display->resource_head = NULL, display->resource_tail = &display->resource_head;
+    pthread_mutex_init(&display->resource_lock, NULL);
+    pthread_cond_init(&display->resource_wait, NULL);
+
+    if ((r = pthread_create(&display->resource_thread, NULL, resource_thread, display)) != 0) {
+        TRACE(ERROR, _x("failed to create resource thread: %d"), r);
+        return -(errno = r);
+    }
+
+    return 0;
 }
 
 /*******************************************************************************
@@ -1666,13 +2717,19 @@ static inline void display_egl_ctx_put(display_data_t *display) {
 static void * window_thread(void *arg) {
     window_data_t *window = arg;
     display_data_t *display = window->display;
+    u32 cpu;
+
+    /* ...window context is the only one current in this thread; shadow its state */
+    __gl_state = &window->gl;
+    gl_state_invalidate(&window->gl);
 
     while (1) {
         /* ...serialize access to window state */
         pthread_mutex_lock(&window->lock);
 
-        /* ...wait for a drawing command from an application */
-        while (!(window->flags & (WINDOW_FLAG_REDRAW | WINDOW_FLAG_TERMINATE | WINDOW_BV_REINIT))) {
+        /* ...wait for a drawing command from an application (redraw waits for a page flip) */
+        while (!(window->flags & (WINDOW_FLAG_TERMINATE | WINDOW_BV_REINIT)) &&
+               (window->flags & (WINDOW_FLAG_REDRAW | WINDOW_FLAG_FLIP_PENDING)) != WINDOW_FLAG_REDRAW) {
             TRACE(DEBUG, _b("window[%p] wait"), window);
             pthread_cond_wait(&window->wait, &window->lock);
         }
@@ -1695,7 +2752,9 @@ static void * window_thread(void *arg) {
             eglMakeCurrent(display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
 
             /* ...invoke user-supplied hook */
+            cpu = __get_thread_cpu_usec();
             window->info->redraw(display, window->cdata);
+            window_cpu_update(window, __get_thread_cpu_usec() - cpu);
         } else {
             /* Reinitialize bv in sv_engine */
             
@@ -1709,6 +2768,9 @@ static void * window_thread(void *arg) {
             
             /* ...invoke user-supplied hook */
             window->info->init_bv(display, window->cdata);
+
+            /* ...engine has reconfigured GL state on its own */
+            gl_state_invalidate(&window->gl);
         }
 
         /* ...realease window GL context (not needed, actually) */
@@ -1719,1048 +2781,3906 @@ static void * window_thread(void *arg) {
 
     /* ...release context eventually */
     eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    __gl_state = NULL;
 
     return NULL;
 }
 
 /*******************************************************************************
- * Internal helpers - getting messy - tbd
+ * GPU timing of render stages
  ******************************************************************************/
 
+/* ...number of frames in flight; results are read back that many frames later */
+#define WINDOW_GPU_FRAMES               4
 
+/* ...GPU stages timer */
+struct window_gpu_timer {
+    /* ...elapsed-time queries per frame slot and stage */
+    GLuint query[WINDOW_GPU_FRAMES][WINDOW_GPU_STAGES];
 
-/* ...check cairo device status */
-static inline int __check_device(cairo_device_t *cairo) {
-    cairo_status_t status;
+    /* ...stages issued in a slot and not yet collected */
+    u32 pending[WINDOW_GPU_FRAMES];
 
-    switch (status = cairo_device_status(cairo)) {
-        case CAIRO_STATUS_SUCCESS: return 0;
-        case CAIRO_STATUS_DEVICE_ERROR: errno = EINVAL;
-            break;
-        default: errno = ENOMEM;
-            break;
-    }
+    /* ...current frame slot and active stage */
+    u32 frame;
+    int stage;
 
-    TRACE(ERROR, _b("cairo device error: '%s'"), cairo_status_to_string(status));
+    /* ...frame is open (stages are being issued) / not instrumented */
+    int active, skip;
 
-    return -errno;
-}
+    /* ...accumulated statistics (protected by window lock) */
+    window_gpu_stats_t stats;
 
-/*******************************************************************************
- * Basic widgets support
- ******************************************************************************/
+    /* ...statistics snapshot taken at last report (window context) */
+    window_gpu_stats_t reported;
+};
 
-/* ...internal widget initialization function */
-int __widget_init(widget_data_t *widget, window_data_t *window, int W, int H, widget_info_t *info, void *cdata) {
-    cairo_device_t *cairo = window->cairo;
-    int w, h;
+/* ...global GPU timing enable flag */
+int window_gpu_timing;
 
-    /* ...set user-supplied data */
-    widget->info = info, widget->cdata = cdata;
+/* ...account single stage sample */
+static inline void __gpu_stage_account(window_gpu_stage_stats_t *st, u32 us) {
+    int i;
 
-    /* ...set pointer to the owning window */
-    widget->window = window;
+    for (i = 0; i < WINDOW_GPU_HIST_BUCKETS - 1 && us >= (50U << i); i++)
+        ;
 
-    /* ...if width/height are not specified, take them from window */
-    widget->width = w = (info && info->width ? info->width : W);
-    widget->height = h = (info && info->height ? info->height : H);
-    widget->top = (info ? info->top : 0);
-    widget->left = (info ? info->left : 0);
+    st->hist[i]++, st->count++, st->total += us;
+    (us > st->max ? st->max = us : 0);
+}
 
-    /* ...create cairo surface for a graphical content */
-    if (widget == &window->widget) {
-        widget->cs = cairo_gl_surface_create_for_egl(cairo, window->egl, w, h);
-    } else {
-        widget->cs = cairo_gl_surface_create(cairo, CAIRO_CONTENT_COLOR_ALPHA, w, h);
-    }
-    
-    /* Force context sanity after cairo calls */
-    eglMakeCurrent(window->display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
-    
-    if (__check_surface(widget->cs) != 0) {
-        TRACE(ERROR, _x("failed to create GL-surface [%u*%u]: %m"), w, h);
-        return -errno;
+/* ...collect results of a frame slot; returns 0 if not ready yet */
+static int __gpu_collect(window_data_t *window, window_gpu_timer_t *gpu, u32 slot) {
+    u32 pending = gpu->pending[slot];
+    GLuint64EXT ns[WINDOW_GPU_STAGES];
+    GLuint available;
+    GLint disjoint = 0;
+    int i;
+
+    /* ...queries complete in order; any unavailable result means slot is busy */
+    for (i = 0; i < WINDOW_GPU_STAGES; i++) {
+        if (pending & (1 << i)) {
+            glGetQueryObjectuivEXT(gpu->query[slot][i], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+            if (!available)     return 0;
+            glGetQueryObjectui64vEXT(gpu->query[slot][i], GL_QUERY_RESULT_EXT, &ns[i]);
+        }
     }
-    /* ...initialize widget controls as needed */
-    if (info && info->init) {
-        if (info->init(widget, cdata) < 0) {
-            TRACE(ERROR, _x("widget initialization failed: %m"));
-            goto error_cs;
+
+    gpu->pending[slot] = 0;
+
+    /* ...results are meaningless if timer has been disturbed */
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    pthread_mutex_lock(&window->lock);
+
+    if (disjoint) {
+        gpu->stats.disjoint++;
+    } else {
+        gpu->stats.frames++;
+        for (i = 0; i < WINDOW_GPU_STAGES; i++) {
+            if (pending & (1 << i)) {
+                __gpu_stage_account(&gpu->stats.stage[i], (u32)(ns[i] / 1000));
+            }
         }
-   
-        /* ...mark widget is dirty */
-        widget->dirty = 1;
+    }
+
+    pthread_mutex_unlock(&window->lock);
+
+    return 1;
+}
+
+/* ...open new frame (first stage switch after previous swap) */
+static void __gpu_frame_begin(window_data_t *window, window_gpu_timer_t *gpu) {
+    u32 slot = gpu->frame;
+
+    gpu->active = 1, gpu->stage = WINDOW_GPU_STAGE_NONE;
+
+    /* ...never wait for GPU; skip instrumentation if slot results are not ready */
+    if (gpu->pending[slot] && !__gpu_collect(window, gpu, slot)) {
+        gpu->skip = 1;
+        pthread_mutex_lock(&window->lock);
+        gpu->stats.skipped++;
+        pthread_mutex_unlock(&window->lock);
     } else {
-        /* ...clear dirty flag */
-        widget->dirty = 0;
+        gpu->skip = 0;
     }
+}
 
-    
-    
-    BUG(eglGetCurrentContext() != window->user_egl_ctx, _x("invalid egl context"));
-    BUG(eglGetCurrentSurface(EGL_READ) != window->egl, _x("invalid egl READ"));
-    BUG(eglGetCurrentSurface(EGL_DRAW) != window->egl, _x("invalid egl DRAW"));
-    
-    TRACE(INIT, _b("widget [%p] initialized"), widget);
+/* ...switch CPU accounting to the next stage */
+static inline void __cpu_stage_switch(window_data_t *window, int stage) {
+    u32 ts = __get_thread_cpu_usec();
 
-    return 0;
+    if (window->cpu_stage != WINDOW_GPU_STAGE_NONE) {
+        window->cpu_stage_acc[window->cpu_stage] += ts - window->cpu_stage_ts;
+    }
 
-error_cs:
-    /* ...destroy cairo surface */
-    cairo_surface_destroy(widget->cs);
+    window->cpu_stage = stage, window->cpu_stage_ts = ts;
+}
 
-    return -errno;
+/* ...close CPU accounting of a frame and publish results */
+static void window_cpu_frame_end(window_data_t *window, u32 swap) {
+    int i;
+
+    __cpu_stage_switch(window, WINDOW_GPU_STAGE_NONE);
+
+    pthread_mutex_lock(&window->lock);
+
+    for (i = 0; i < WINDOW_GPU_STAGES; i++) {
+        window->cpu_stats.stage[i] += window->cpu_stage_acc[i], window->cpu_stage_acc[i] = 0;
+    }
+
+    window->cpu_stats.swap += swap, window->cpu_stats.frames++;
+
+    pthread_mutex_unlock(&window->lock);
 }
 
-/*******************************************************************************
- * Window API
- ******************************************************************************/
+/* ...retrieve render-stage CPU time statistics */
+int window_get_cpu_stats(window_data_t *window, window_cpu_stats_t *stats) {
+    pthread_mutex_lock(&window->lock);
+    *stats = window->cpu_stats;
+    pthread_mutex_unlock(&window->lock);
 
-/* ...transformation matrix processing */
-static inline void window_set_transform_matrix(window_data_t *window, int *width, int *height, int fullscreen, u32 transform) {
-    cairo_matrix_t *m = &window->cmatrix;
-    int w = *width, h = *height;
+    return 0;
+}
 
-    if (fullscreen && transform) {
-        switch (transform) {
-            case 90:
-                m->xx = 0.0, m->xy = -1.0, m->x0 = w;
-                m->yx = 1.0, m->yy = 0.0, m->y0 = 0;
-                //*width = h, *height = w;
-                break;
+/* ...switch to the next stage */
+void window_gpu_stage(window_data_t *window, int stage) {
+    window_gpu_timer_t *gpu = window->gpu;
 
-            case 180:
-                m->xx = -1.0, m->xy = 0.0, m->x0 = w;
-                m->yx = 0.0, m->yy = -1.0, m->y0 = h;
-                break;
+    /* ...CPU time is accounted regardless of timer queries availability */
+    __cpu_stage_switch(window, stage);
 
-            case 270:
-                m->xx = 0.0, m->xy = 1.0, m->x0 = 0;
-                m->yx = -1.0, m->yy = 0.0, m->y0 = h;
-                //*width = h, *height = w;
-                break;
+    if (!window_gpu_timing || !(window->display->gl_ext & DISPLAY_GL_EXT_TIMER_QUERY)) {
+        return;
+    }
 
-            default:
-                BUG(1, _x("invalid transformation: %u"), transform);
+    /* ...queries are context objects; create them in window context on first use */
+    if (!gpu) {
+        if ((window->gpu = gpu = calloc(1, sizeof (*gpu))) == NULL) {
+            return;
         }
+        glGenQueriesEXT(WINDOW_GPU_FRAMES * WINDOW_GPU_STAGES, &gpu->query[0][0]);
+        gpu->stage = WINDOW_GPU_STAGE_NONE;
+    }
+
+    if (!gpu->active) {
+        if (stage == WINDOW_GPU_STAGE_NONE)     return;
+        __gpu_frame_begin(window, gpu);
+    }
+
+    if (gpu->skip || gpu->stage == stage) {
+        return;
+    }
+
+    /* ...close current stage; elapsed-time queries cannot be nested */
+    if (gpu->stage != WINDOW_GPU_STAGE_NONE) {
+        glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+    }
+
+    /* ...each stage is measured once per frame */
+    if (stage != WINDOW_GPU_STAGE_NONE && !(gpu->pending[gpu->frame] & (1 << stage))) {
+        glBeginQueryEXT(GL_TIME_ELAPSED_EXT, gpu->query[gpu->frame][stage]);
+        gpu->pending[gpu->frame] |= 1 << stage;
+        gpu->stage = stage;
     } else {
-        /* ...set identity transformation matrix */
-        cairo_matrix_init_identity(m);
+        gpu->stage = WINDOW_GPU_STAGE_NONE;
     }
 }
 
-/* ...create native window */
-window_data_t * window_create(display_data_t *display, window_info_t *info, widget_info_t *info2, void *cdata) {
-    int width = info->width;
-    int height = info->height;
-    output_data_t *output;
-    window_data_t *window;
-    struct wl_region *region;
-    pthread_attr_t attr;
-    int r;
+/* ...close frame after buffers swap */
+static void window_gpu_frame_end(window_data_t *window) {
+    window_gpu_timer_t *gpu = window->gpu;
 
-    /* ...make sure we have a valid output device */
-    if ((output = display_get_output(display, info->output)) == NULL) {
-        TRACE(ERROR, _b("invalid output device number: %u"), info->output);
-        errno = EINVAL;
-        return NULL;
+    if (gpu && gpu->active) {
+        window_gpu_stage(window, WINDOW_GPU_STAGE_NONE);
+        gpu->active = 0;
+        gpu->frame = (gpu->frame + 1) % WINDOW_GPU_FRAMES;
     }
+}
 
-    /* ...allocate a window data */
-    if ((window = malloc(sizeof (*window))) == NULL) {
-        TRACE(ERROR, _x("failed to allocate memory"));
-        errno = ENOMEM;
-        return NULL;
+/* ...destroy GPU timer (called in window context) */
+static void window_gpu_destroy(window_data_t *window) {
+    window_gpu_timer_t *gpu = window->gpu;
+
+    if (gpu) {
+        glDeleteQueriesEXT(WINDOW_GPU_FRAMES * WINDOW_GPU_STAGES, &gpu->query[0][0]);
+        free(gpu), window->gpu = NULL;
     }
+}
 
-    /* ...if width/height are not specified, use output device dimensions */
-    (!width ? width = output->width : 0), (!height ? height = output->height : 0);
+/* ...output GPU stage timings for the last report period (maximum is kept since creation) */
+static void window_gpu_report(window_data_t *window) {
+    static const char *names[WINDOW_GPU_STAGES] = { "clear", "scene", "overlay", "gui", "swap" };
+    window_gpu_timer_t *gpu = window->gpu;
+    window_gpu_stats_t stats, *last;
+    window_gpu_stage_stats_t *st, *prev;
+    u32 count;
+    int i;
+
+    if (!gpu || window_get_gpu_stats(window, &stats) < 0 || stats.frames == gpu->reported.frames) {
+        return;
+    }
 
-    /* ...initialize window data access lock */
-    pthread_mutex_init(&window->lock, NULL);
+    last = &gpu->reported;
 
-    /* ...initialize conditional variable for communication with rendering thread */
-    pthread_cond_init(&window->wait, NULL);
+    for (i = 0, st = stats.stage, prev = last->stage; i < WINDOW_GPU_STAGES; i++, st++, prev++) {
+        if ((count = st->count - prev->count) != 0) {
+            TRACE(INFO, _b("window[%p]: GPU %s: avg=%u us, max=%u us"), window, names[i], (u32)((st->total - prev->total) / count), st->max);
+        }
+    }
 
-    /* ...save display handle */
-    window->display = display;
+    TRACE(INFO, _b("window[%p]: GPU frames=%u, skipped=%u, disjoint=%u"), window, stats.frames - last->frames, stats.skipped - last->skipped, stats.disjoint - last->disjoint);
 
-    /* ...save window info data */
-    window->info = info, window->cdata = cdata;
+    *last = stats;
+}
 
-    /* ...clear window flags */
-    window->flags = 0;
+/* ...retrieve GPU timing statistics */
+int window_get_gpu_stats(window_data_t *window, window_gpu_stats_t *stats) {
+    pthread_mutex_lock(&window->lock);
 
-    /* ...reset frame-rate calculator */
-    window_frame_rate_reset(window);
+    if (window->gpu) {
+        *stats = window->gpu->stats;
+    } else {
+        memset(stats, 0, sizeof (*stats));
+    }
 
-    /* ...get wayland surface (subsurface maybe?) */
-    window->surface = wl_compositor_create_surface(display->compositor);
+    pthread_mutex_unlock(&window->lock);
 
-    /* ...specify window has the only opaque region */
-    region = wl_compositor_create_region(display->compositor);
-    wl_region_add(region, 0, 0, width, height);
-    wl_surface_set_opaque_region(window->surface, region);
-    wl_region_destroy(region);
+    return (window->gpu ? 0 : -(errno = ENODEV));
+}
 
-    /* ...get desktop shell surface handle */
-    window->shell = wl_shell_get_shell_surface(display->shell, window->surface);
-    wl_shell_surface_add_listener(window->shell, &shell_surface_listener, window);
-    (info->title ? wl_shell_surface_set_title(window->shell, info->title) : 0);
-    wl_shell_surface_set_toplevel(window->shell);
-    (info->fullscreen ? wl_shell_surface_set_fullscreen(window->shell, WL_SHELL_SURFACE_FULLSCREEN_METHOD_DEFAULT, 0, output->output) : 0);
+/*******************************************************************************
+ * Internal helpers - getting messy - tbd
+ ******************************************************************************/
 
-    /* ...set private data poitner */
-    wl_surface_set_user_data(window->surface, window);
 
-    /* ...create native window */
-    window->native = wl_egl_window_create(window->surface, width, height);
-    window->egl = eglCreateWindowSurface(display->egl.dpy, display->egl.conf, window->native, NULL);
 
-    /* ...create window user EGL context (share textures with everything else?)*/
-    window->user_egl_ctx = eglCreateContext(display->egl.dpy, display->egl.conf, display->egl.ctx, __egl_context_attribs);
+/* ...check cairo device status */
+static inline int __check_device(cairo_device_t *cairo) {
+    cairo_status_t status;
 
-    /* ...create cairo context */
-    window->cairo = cairo_egl_device_create(display->egl.dpy, window->user_egl_ctx);
-    if (__check_device(window->cairo) != 0) {
-        TRACE(ERROR, _x("failed to create cairo device: %m"));
-        goto error;
+    switch (status = cairo_device_status(cairo)) {
+        case CAIRO_STATUS_SUCCESS: return 0;
+        case CAIRO_STATUS_DEVICE_ERROR: errno = EINVAL;
+            break;
+        default: errno = ENOMEM;
+            break;
     }
 
-    /* ...make it simple - we are handling thread context ourselves */
-    cairo_gl_device_set_thread_aware(window->cairo, FALSE);
+    TRACE(ERROR, _b("cairo device error: '%s'"), cairo_status_to_string(status));
 
-    /* ...reset cairo program */
-    window->cprog = 0;
+    return -errno;
+}
 
-    /* ...set cairo transformation matrix */
-    window_set_transform_matrix(window, &width, &height, info->fullscreen, info->transform);
+/*******************************************************************************
+ * Asynchronous widget layers rasterization
+ ******************************************************************************/
 
-    /* ...set window EGL context */
-    eglMakeCurrent(display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
+/* ...widget layer data */
+struct widget_layer {
+    /* ...owning widget */
+    widget_data_t *widget;
 
-    /* ...initialize root widget data */
-    if (__widget_init(&window->widget, window, width, height, info2, cdata) < 0) {
-        TRACE(INIT, _b("widget initialization failed: %m"));
-        goto error;
-    }
+    /* ...double-buffered layer textures (cairo ARGB32 content) */
+    GLuint tex[2];
 
-    /* ...clear surface to flush all textures loading etc.. - looks a bit strange */
-    if (1) {
-        cairo_t *cr = cairo_create(window->widget.cs);
-        cairo_set_source_rgb(cr, 0, 0, 0);
-        cairo_paint(cr);
-        cairo_destroy(cr);
-    }
+    /* ...render thread reads completion fences (texture may be overwritten when signalled) */
+    EGLSyncKHR read[2];
 
-    /* ...release window EGL context */
-    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    /* ...texture composed by render thread and published one (-1 if none) */
+    int front, ready;
 
-    /* ...initialize thread attributes (joinable, default stack size) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    /* ...rasterization request is queued */
+    int pending;
 
-    /* ...create rendering thread */
-    r = pthread_create(&window->thread, &attr, window_thread, window);
-    pthread_attr_destroy(&attr);
-    if (r != 0) {
-        TRACE(ERROR, _x("thread creation failed: %m"));
-        goto error;
-    }
+    /* ...next layer in rasterizer queue */
+    widget_layer_t *next;
+};
 
-    /* ...add window to global display list */
-    wl_list_insert(display->windows.prev, &window->link);
+/* ...rasterizer data */
+struct widget_rasterizer {
+    /* ...rasterization thread handle */
+    pthread_t thread;
 
-    TRACE(INFO, _b("window created: %p:%p, %u * %u, output: %u"), window, window->egl, width, height, info->output);
+    /* ...queue and layers state access lock and signalling variable */
+    pthread_mutex_t lock;
+    pthread_cond_t wait;
 
-    return window;
+    /* ...layers pending rasterization */
+    widget_layer_t *head, **tail;
 
-error:
-    /* ...destroy window memory */
-    free(window);
-    return NULL;
-}
+    /* ...layer being rasterized */
+    widget_layer_t *busy;
 
-static void __destroy_callback(void *data, struct wl_callback *callback, uint32_t serial) {
-    pthread_mutex_t *wait_lock = data;
+    /* ...termination request */
+    int stop;
 
-    TRACE(DEBUG, _b("release wait lock"));
+    /* ...dedicated shared context */
+    EGLContext ctx;
+};
 
-    /* ...release mutex */
-    pthread_mutex_unlock(wait_lock);
+/* ...rasterize widget into image surface and upload it into a layer texture (current context) */
+static void __widget_layer_raster(widget_layer_t *layer, int i) {
+    widget_data_t *widget = layer->widget;
 
-    wl_callback_destroy(callback);
+    /* ...draw widget content with cairo image backend */
+    widget_update(widget, 1);
+    cairo_surface_flush(widget->cs);
+
+    /* ...ARGB32 stride is always four bytes per pixel; swizzling is done by composing shader */
+    glBindTexture(GL_TEXTURE_2D, layer->tex[i]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, widget->width, widget->height, GL_RGBA, GL_UNSIGNED_BYTE, cairo_image_surface_get_data(widget->cs));
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-static const struct wl_callback_listener __destroy_listener = {
-    __destroy_callback,
-};
+/* ...rasterization thread */
+static void * widget_raster_thread(void *arg) {
+    widget_rasterizer_t *rasterizer = arg;
+    display_data_t *display = &__display;
+    widget_layer_t *layer;
+    EGLSyncKHR sync;
+    int i;
 
-/* ...destroy a window */
-void window_destroy(window_data_t *window) {
-    display_data_t *display = window->display;
-    EGLDisplay dpy = display->egl.dpy;
-    const window_info_t *info = window->info;
-    const widget_info_t *info2 = window->widget.info;
-    struct wl_callback *callback;
+    /* ...make dedicated shared context current (surfaceless) */
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, rasterizer->ctx);
 
-    /* ...terminate window rendering thread */
-    pthread_mutex_lock(&window->lock);
-    window->flags |= WINDOW_FLAG_TERMINATE;
-    pthread_cond_signal(&window->wait);
-    pthread_mutex_unlock(&window->lock);
+    TRACE(INIT, _b("widget rasterizer started"));
 
-    /* ...wait until thread completes */
-    pthread_join(window->thread, NULL);
+    pthread_mutex_lock(&rasterizer->lock);
 
-    TRACE(DEBUG, _b("window[%p] thread joined"), window);
+    while (1) {
+        /* ...wait for a request */
+        while ((layer = rasterizer->head) == NULL && !rasterizer->stop) {
+            pthread_cond_wait(&rasterizer->wait, &rasterizer->lock);
+        }
 
-    /* ...remove window from global display list */
-    wl_list_remove(&window->link);
+        /* ...queued requests are dropped; layers are updated by render thread afterwards */
+        if (rasterizer->stop) {
+            break;
+        }
 
-    /* ...acquire window context before doing anything */
-    eglMakeCurrent(dpy, window->egl, window->egl, window->user_egl_ctx);
+        /* ...dequeue layer; requests posted meanwhile queue it again */
+        if ((rasterizer->head = layer->next) == NULL) {
+            rasterizer->tail = &rasterizer->head;
+        }
 
-    /* ...invoke custom widget destructor function as needed */
-    (info2 && info2->destroy ? info2->destroy(&window->widget, window->cdata) : 0);
+        layer->pending = 0, rasterizer->busy = layer;
 
-    /* ...destroy root widget cairo surface */
-    cairo_surface_destroy(window->widget.cs);
+        /* ...render into the texture not composed by render thread; withdraw it if published */
+        i = (layer->front == 0 ? 1 : 0);
+        (layer->ready == i ? layer->ready = -1 : 0);
+        sync = layer->read[i], layer->read[i] = EGL_NO_SYNC_KHR;
 
-    /* ...invoke custom window destructor function as needed */
-    (info && info->destroy ? info->destroy(window, window->cdata) : 0);
+        pthread_mutex_unlock(&rasterizer->lock);
 
-    /* ...destroy cairo device */
-    cairo_device_destroy(window->cairo);
+        /* ...previous composition from this texture must be complete */
+        if (sync != EGL_NO_SYNC_KHR) {
+            eglClientWaitSyncKHR(display->egl.dpy, sync, 0, EGL_FOREVER_KHR);
+            eglDestroySyncKHR(display->egl.dpy, sync);
+        }
 
-    /* ...release EGL context before destruction */
+        __widget_layer_raster(layer, i);
+
+        /* ...wait for upload completion; render thread gets only finished layers */
+        sync = eglCreateSyncKHR(display->egl.dpy, EGL_SYNC_FENCE_KHR, NULL);
+        eglClientWaitSyncKHR(display->egl.dpy, sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+        eglDestroySyncKHR(display->egl.dpy, sync);
+
+        /* ...publish layer and request window update */
+        pthread_mutex_lock(&rasterizer->lock);
+        layer->ready = i, rasterizer->busy = NULL;
+        pthread_cond_broadcast(&rasterizer->wait);
+        window_schedule_redraw(layer->widget->window);
+    }
+
+    pthread_mutex_unlock(&rasterizer->lock);
+
+    /* ...release context so that it can be destroyed */
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+
+    TRACE(INIT, _b("widget rasterizer terminated"));
+
+    return NULL;
+}
+
+/* ...start rasterization thread */
+static widget_rasterizer_t * widget_rasterizer_start(display_data_t *display) {
+    widget_rasterizer_t *rasterizer;
+    pthread_attr_t attr;
+    int r;
+
+    CHK_ERR(rasterizer = calloc(1, sizeof (*rasterizer)), (errno = ENOMEM, NULL));
+
+    /* ...fences are mandatory for layers handover */
+    if (!(eglCreateSyncKHR && eglClientWaitSyncKHR && eglDestroySyncKHR)) {
+        TRACE(ERROR, _x("EGL_KHR_fence_sync is not supported"));
+        errno = ENOTSUP;
+        goto error;
+    }
+
+    /* ...create dedicated context sharing objects with display */
+    if ((rasterizer->ctx = eglCreateContext(display->egl.dpy, display->egl.conf, display->egl.ctx, __egl_context_attribs)) == EGL_NO_CONTEXT) {
+        TRACE(ERROR, _x("failed to create rasterizer context: %X"), eglGetError());
+        errno = ENODEV;
+        goto error;
+    }
+
+    rasterizer->head = NULL, rasterizer->tail = &rasterizer->head;
+    pthread_mutex_init(&rasterizer->lock, NULL);
+    pthread_cond_init(&rasterizer->wait, NULL);
+
+    /* ...start rasterization thread */
+    pthread_attr_init(&attr);
+    r = pthread_create(&rasterizer->thread, &attr, widget_raster_thread, rasterizer);
+    pthread_attr_destroy(&attr);
+    if (r != 0) {
+        TRACE(ERROR, _x("failed to create rasterizer thread: %d"), r);
+        eglDestroyContext(display->egl.dpy, rasterizer->ctx);
+        errno = r;
+        goto error;
+    }
+
+    return rasterizer;
+
+error:
+    free(rasterizer);
+    return NULL;
+}
+
+/* ...terminate rasterization thread (layers are rasterized by render thread afterwards) */
+void widget_rasterizer_stop(void) {
+    display_data_t *display = &__display;
+    widget_rasterizer_t *rasterizer = display->rasterizer;
+    widget_layer_t *layer;
+
+    if (!rasterizer) {
+        return;
+    }
+
+    pthread_mutex_lock(&rasterizer->lock);
+    rasterizer->stop = 1;
+    pthread_cond_signal(&rasterizer->wait);
+    pthread_mutex_unlock(&rasterizer->lock);
+
+    pthread_join(rasterizer->thread, NULL);
+    display->rasterizer = NULL;
+
+    /* ...withdrawn requests may be posted again */
+    for (layer = rasterizer->head; layer; layer = layer->next) {
+        layer->pending = 0;
+    }
+
+    pthread_cond_destroy(&rasterizer->wait);
+    pthread_mutex_destroy(&rasterizer->lock);
+    eglDestroyContext(display->egl.dpy, rasterizer->ctx);
+    free(rasterizer);
+}
+
+/* ...create widget layer textures (window context) */
+static widget_layer_t * widget_layer_create(widget_data_t *widget) {
+    display_data_t *display = widget->window->display;
+    widget_layer_t *layer;
+    int i;
+
+    /* ...start rasterizer on first use; layer gets rasterized by render thread otherwise */
+    if (!display->rasterizer && !display->rasterizer_failed && (display->rasterizer = widget_rasterizer_start(display)) == NULL) {
+        TRACE(ERROR, _x("asynchronous rasterization disabled: %m"));
+        display->rasterizer_failed = 1;
+    }
+
+    CHK_ERR(layer = calloc(1, sizeof (*layer)), (errno = ENOMEM, NULL));
+
+    layer->widget = widget, layer->front = layer->ready = -1;
+
+    glGenTextures(2, layer->tex);
+    for (i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, layer->tex[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, widget->width, widget->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        layer->read[i] = EGL_NO_SYNC_KHR;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    /* ...make sure objects are visible to the rasterizer context */
+    glFinish();
+
+    return layer;
+}
+
+/* ...destroy widget layer (window context) */
+static void widget_layer_destroy(widget_layer_t *layer) {
+    display_data_t *display = layer->widget->window->display;
+    widget_rasterizer_t *rasterizer = display->rasterizer;
+    widget_layer_t **p;
+    int i;
+
+    /* ...withdraw pending request and wait until layer is not processed */
+    if (rasterizer) {
+        pthread_mutex_lock(&rasterizer->lock);
+
+        for (p = &rasterizer->head; *p; p = &(*p)->next) {
+            if (*p == layer) {
+                ((*p = layer->next) == NULL ? rasterizer->tail = p : 0);
+                break;
+            }
+        }
+
+        while (rasterizer->busy == layer) {
+            pthread_cond_wait(&rasterizer->wait, &rasterizer->lock);
+        }
+
+        pthread_mutex_unlock(&rasterizer->lock);
+    }
+
+    for (i = 0; i < 2; i++) {
+        (layer->read[i] != EGL_NO_SYNC_KHR ? eglDestroySyncKHR(display->egl.dpy, layer->read[i]) : 0);
+    }
+
+    glDeleteTextures(2, layer->tex);
+    gl_state_deleted();
+
+    free(layer);
+}
+
+/* ...request asynchronous rasterization of a layered widget */
+void __widget_layer_schedule(widget_data_t *widget) {
+    widget_rasterizer_t *rasterizer = widget->window->display->rasterizer;
+    widget_layer_t *layer = widget->layer;
+
+    /* ...without rasterizer thread the layer is updated by render thread */
+    if (!rasterizer) {
+        window_schedule_redraw(widget->window);
+        return;
+    }
+
+    pthread_mutex_lock(&rasterizer->lock);
+
+    if (!layer->pending) {
+        layer->pending = 1, layer->next = NULL;
+        *rasterizer->tail = layer, rasterizer->tail = &layer->next;
+        pthread_cond_signal(&rasterizer->wait);
+    }
+
+    pthread_mutex_unlock(&rasterizer->lock);
+}
+
+/*******************************************************************************
+ * Basic widgets support
+ ******************************************************************************/
+
+/* ...internal widget initialization function */
+int __widget_init(widget_data_t *widget, window_data_t *window, int W, int H, widget_info_t *info, void *cdata) {
+    cairo_device_t *cairo = window->cairo;
+    int w, h;
+
+    /* ...set user-supplied data */
+    widget->info = info, widget->cdata = cdata;
+
+    /* ...set pointer to the owning window */
+    widget->window = window;
+
+    /* ...if width/height are not specified, take them from window */
+    widget->width = w = (info && info->width ? info->width : W);
+    widget->height = h = (info && info->height ? info->height : H);
+    widget->top = (info ? info->top : 0);
+    widget->left = (info ? info->left : 0);
+
+    /* ...create cairo surface for a graphical content */
+    if (widget == &window->widget) {
+        widget->cs = cairo_gl_surface_create_for_egl(cairo, window->egl, w, h);
+        widget->layer = NULL;
+    } else {
+        /* ...content is rasterized off the render thread and composed from a texture */
+        widget->cs = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+        eglMakeCurrent(window->display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
+        if ((widget->layer = widget_layer_create(widget)) == NULL) {
+            TRACE(ERROR, _x("failed to create widget layer: %m"));
+            cairo_surface_destroy(widget->cs);
+            return -errno;
+        }
+    }
+    
+    /* Force context sanity after cairo calls */
+    eglMakeCurrent(window->display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
+    
+    if (__check_surface(widget->cs) != 0) {
+        TRACE(ERROR, _x("failed to create GL-surface [%u*%u]: %m"), w, h);
+        __widget_fini(widget);
+        return -errno;
+    }
+    /* ...initialize widget controls as needed */
+    if (info && info->init) {
+        if (info->init(widget, cdata) < 0) {
+            TRACE(ERROR, _x("widget initialization failed: %m"));
+            goto error_cs;
+        }
+   
+        /* ...mark widget is dirty; layer content is prepared in background */
+        widget->dirty = 1;
+        if (widget->layer) {
+            __widget_layer_schedule(widget);
+        }
+    } else {
+        /* ...clear dirty flag */
+        widget->dirty = 0;
+    }
+
+    
+    
+    BUG(eglGetCurrentContext() != window->user_egl_ctx, _x("invalid egl context"));
+    BUG(eglGetCurrentSurface(EGL_READ) != window->egl, _x("invalid egl READ"));
+    BUG(eglGetCurrentSurface(EGL_DRAW) != window->egl, _x("invalid egl DRAW"));
+    
+    TRACE(INIT, _b("widget [%p] initialized"), widget);
+
+    return 0;
+
+error_cs:
+    /* ...destroy cairo surface and its backing texture */
+    __widget_fini(widget);
+
+    return -errno;
+}
+
+/* ...release widget graphical resources (window context must be current) */
+void __widget_fini(widget_data_t *widget) {
+    /* ...destroy cairo surface */
+    cairo_surface_destroy(widget->cs);
+
+    /* ...destroy layer textures */
+    if (widget->layer) {
+        widget_layer_destroy(widget->layer);
+    }
+}
+
+/* ...compose cached widget layer over the window content with a single quad */
+void widget_compose(widget_data_t *widget, cairo_t *cr, float dim, float alpha) {
+    window_data_t *window = widget->window;
+    display_data_t *display = window->display;
+    widget_rasterizer_t *rasterizer = display->rasterizer;
+    widget_layer_t *layer = widget->layer;
+    gl_shader_t *shader = &display->shader_gui;
+    texture_view_t view;
+    texture_crop_t crop;
+    int W, H, i;
+
+    BUG(!layer, _x("widget[%p] has no layer"), widget);
+
+    /* ...submit pending drawing on a target; cairo has modified GL state meanwhile */
+    cairo_surface_flush(cairo_get_target(cr));
+    gl_state_leave_cairo(&window->gl);
+
+    if (rasterizer) {
+        /* ...switch to the latest finished layer; keep composing previous one otherwise */
+        pthread_mutex_lock(&rasterizer->lock);
+        (layer->ready >= 0 ? layer->front = layer->ready, layer->ready = -1 : 0);
+        i = layer->front;
+        pthread_mutex_unlock(&rasterizer->lock);
+    } else {
+        /* ...no rasterizer thread; update layer in place if widget is dirty */
+        if (widget->dirty || layer->front < 0) {
+            __widget_layer_raster(layer, 0);
+            layer->front = 0;
+        }
+        i = layer->front;
+    }
+
+    /* ...quad covers whole viewable area; widget texture is mapped into its rectangle */
+    window_get_viewport(window, &W, &H);
+    texture_set_view(&view, 0, 0, 1, 1);
+    texture_transform_view(&view, window_get_transform(window) / 90);
+    texture_set_crop(&crop,
+                     (float)-widget->left / widget->width, (float)-widget->top / widget->height,
+                     (float)(W - widget->left) / widget->width, (float)(H - widget->top) / widget->height);
+
+    /* ...set current precompiled shader */
+    gl_state_use_program(shader->program);
+
+    /* ...prepare shader uniforms */
+    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, __gl_identity);
+    glUniform1i(shader->tex_uniforms[0], 0);
+    glUniform1f(shader->alpha_uniform, (i >= 0 ? alpha : 0));
+    glUniform1f(shader->dim_uniform, dim);
+
+    /* ...bind layer texture (external texture binding of unit #0 is not affected) */
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, (i >= 0 ? layer->tex[i] : 0));
+
+    /* ...vertices are passed in client arrays */
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, view);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, crop);
+    glEnableVertexAttribArray(1);
+
+    /* ...blend premultiplied layer over the scene */
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    /* ...cleanup GL state */
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    /* ...rasterizer must not overwrite the texture until GPU has read it */
+    if (rasterizer && i >= 0) {
+        pthread_mutex_lock(&rasterizer->lock);
+        (layer->read[i] != EGL_NO_SYNC_KHR ? eglDestroySyncKHR(display->egl.dpy, layer->read[i]) : 0);
+        layer->read[i] = eglCreateSyncKHR(display->egl.dpy, EGL_SYNC_FENCE_KHR, NULL);
+        pthread_mutex_unlock(&rasterizer->lock);
+    }
+
+    /* ...hand context back to cairo */
+    gl_state_enter_cairo(&window->gl);
+}
+
+/*******************************************************************************
+ * Window API
+ ******************************************************************************/
+
+/* ...transformation matrix processing */
+static inline void window_set_transform_matrix(window_data_t *window, int *width, int *height, int fullscreen, u32 transform) {
+    cairo_matrix_t *m = &window->cmatrix;
+    int w = *width, h = *height;
+
+    if (fullscreen && transform) {
+        switch (transform) {
+            case 90:
+                m->xx = 0.0, m->xy = -1.0, m->x0 = w;
+                m->yx = 1.0, m->yy = 0.0, m->y0 = 0;
+                //*width = h, *height = w;
+                break;
+
+            case 180:
+                m->xx = -1.0, m->xy = 0.0, m->x0 = w;
+                m->yx = 0.0, m->yy = -1.0, m->y0 = h;
+                break;
+
+            case 270:
+                m->xx = 0.0, m->xy = 1.0, m->x0 = 0;
+                m->yx = -1.0, m->yy = 0.0, m->y0 = h;
+                //*width = h, *height = w;
+                break;
+
+            default:
+                BUG(1, _x("invalid transformation: %u"), transform);
+        }
+    } else {
+        /* ...set identity transformation matrix */
+        cairo_matrix_init_identity(m);
+    }
+}
+
+/* ...compositor-side rotation of window buffer */
+int window_buffer_transform;
+
+/* ...map rotation angle into Wayland buffer transformation */
+static inline int __wl_transform(u32 transform) {
+    switch (transform) {
+        case 90:
+            return WL_OUTPUT_TRANSFORM_90;
+        case 180:
+            return WL_OUTPUT_TRANSFORM_180;
+        case 270:
+            return WL_OUTPUT_TRANSFORM_270;
+        default:
+            return WL_OUTPUT_TRANSFORM_NORMAL;
+    }
+}
+
+/* ...select rotation path for a window; adjust buffer dimensions */
+static inline void window_set_buffer_transform(window_data_t *window, int *width, int *height, int fullscreen, u32 transform) {
+    int w = *width, h = *height;
+
+    /* ...rotation is applied only to fullscreen windows */
+    window->transform = (fullscreen ? transform : 0);
+
+    if (!window_buffer_transform || !window->transform) {
+        return;
+    } else if (wl_surface_get_version(window->surface) < WL_SURFACE_SET_BUFFER_TRANSFORM_SINCE_VERSION) {
+        TRACE(INFO, _b("compositor does not support buffer transformation; rotating in application"));
+        return;
+    }
+
+    /* ...buffer content is rotated by compositor; render it unrotated */
+    wl_surface_set_buffer_transform(window->surface, __wl_transform(window->transform));
+
+    /* ...buffer has output dimensions swapped for a quarter-turn */
+    if (window->transform == 90 || window->transform == 270) {
+        *width = h, *height = w;
+    }
+
+    TRACE(INIT, _b("window[%p]: rotation %u offloaded to compositor"), window, window->transform);
+
+    window->transform = 0;
+}
+
+/* ...verify direct scanout eligibility of window buffer */
+static void window_scanout_check(window_data_t *window, output_data_t *output, int width, int height) {
+    int transform = (window_buffer_transform ? __wl_transform(window->info->transform) : WL_OUTPUT_TRANSFORM_NORMAL);
+    const char *reason = NULL;
+    EGLint alpha = 0;
+    u32 w, h;
+
+    /* ...compositor may bypass composition only for a plane-compatible buffer covering whole output */
+    eglGetConfigAttrib(window->display->egl.dpy, window->display->egl.conf, EGL_ALPHA_SIZE, &alpha);
+
+    /* ...output mode dimensions in buffer orientation (swapped for a quarter-turn) */
+    (transform & 1 ? (w = output->height, h = output->width) : (w = output->width, h = output->height));
+
+    if (!window->info->fullscreen) {
+        reason = "not fullscreen";
+    } else if ((u32)width != w || (u32)height != h) {
+        reason = "buffer does not match output mode";
+    } else if (transform != (int)output->transform) {
+        reason = "buffer transformation differs from output";
+    } else if (window->transform) {
+        reason = "rotation is applied in application";
+    }
+
+    window->scanout = (reason == NULL);
+
+    /* ...alpha channel is ignored due to full-surface opaque region */
+    TRACE(INFO, _b("window[%p]: direct scanout %s%s (%d*%d, alpha=%d, output transform=%u)"), window,
+          (reason ? "not possible: " : "eligible"), (reason ? : ""), width, height, alpha, output->transform);
+}
+
+#ifdef DISPLAY_DRM_ENABLED
+/* ...DRM device for direct KMS output (Wayland compositor is used if not set) */
+const char *display_drm_device;
+#endif
+
+#ifdef DISPLAY_X11_ENABLED
+/* ...X display name (empty string - default display; Wayland is used if not set) */
+const char *display_x11_name;
+
+/* ...X11 input event (display dispatch thread) */
+static void __window_x11_event(void *cdata, widget_event_t *event) {
+    window_data_t *window = cdata;
+    widget_data_t **focus, *widget;
+    widget_info_t *info;
+
+    /* ...pointer and keyboard focus are tracked separately */
+    focus = (WIDGET_EVENT_TYPE(event->type) == WIDGET_EVENT_MOUSE ? &window->pointer_focus : &window->keyboard_focus);
+
+    /* ...entrance sets focus to root widget */
+    if (event->type == WIDGET_EVENT_MOUSE_ENTER || event->type == WIDGET_EVENT_KEY_ENTER) {
+        *focus = &window->widget;
+    }
+
+    /* ...drop event if no focus or processing hook is set */
+    if (!(widget = *focus) || !(info = widget->info) || !info->event) return;
+
+    /* ...pass event to current widget and latch new focus */
+    *focus = info->event(widget, widget->cdata, event);
+}
+#endif
+
+#ifdef DISPLAY_DRM_ENABLED
+/* ...page flip completion (display dispatch thread) */
+static void __window_flip_done(void *cdata) {
+    window_data_t *window = cdata;
+
+    pthread_mutex_lock(&window->lock);
+
+    /* ...next frame may be presented; kick thread if redraw is deferred */
+    window->flags &= ~WINDOW_FLAG_FLIP_PENDING;
+    pthread_cond_broadcast(&window->wait);
+
+    pthread_mutex_unlock(&window->lock);
+}
+#endif
+
+/* ...create native window */
+window_data_t * window_create(display_data_t *display, window_info_t *info, widget_info_t *info2, void *cdata) {
+    int width = info->width;
+    int height = info->height;
+    output_data_t *output = NULL;
+    window_data_t *window;
+    struct wl_region *region;
+    pthread_attr_t attr;
+    int r;
+
+    /* ...make sure we have a valid output device (KMS outputs are probed later) */
+    if (!__display_native(display) && (output = display_get_output(display, info->output)) == NULL) {
+        TRACE(ERROR, _b("invalid output device number: %u"), info->output);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    /* ...allocate a window data */
+    if ((window = malloc(sizeof (*window))) == NULL) {
+        TRACE(ERROR, _x("failed to allocate memory"));
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    /* ...if width/height are not specified, use output device dimensions */
+    (output && !width ? width = output->width : 0), (output && !height ? height = output->height : 0);
+
+    /* ...initialize window data access lock */
+    pthread_mutex_init(&window->lock, NULL);
+
+    /* ...initialize conditional variable for communication with rendering thread */
+    pthread_cond_init(&window->wait, NULL);
+
+    /* ...save display handle */
+    window->display = display;
+
+    /* ...save window info data */
+    window->info = info, window->cdata = cdata;
+
+    /* ...clear window flags */
+    window->flags = 0;
+
+    /* ...no damage hint collected yet */
+    window->damaged = 0;
+
+    /* ...camera plane is created on first use */
+    window->plane_surface = NULL, window->plane_sub = NULL, window->plane_viewport = NULL;
+    window->plane_x = window->plane_y = window->plane_w = window->plane_h = 0;
+    window->plane_attached = 0;
+
+    /* ...reset frame-rate calculator */
+    window_frame_rate_reset(window);
+
+    /* ...reset rendering thread CPU time accounting */
+    window->cpu_ts = window->cpu_acc = window->cpu_max = window->cpu_frames = 0;
+    window->cpu_stage = WINDOW_GPU_STAGE_NONE;
+    memset(window->cpu_stage_acc, 0, sizeof(window->cpu_stage_acc));
+    memset(&window->cpu_stats, 0, sizeof(window->cpu_stats));
+
+    /* ...GPU stages timer is created on first use */
+    window->gpu = NULL;
+
+#ifdef DISPLAY_DRM_ENABLED
+    /* ...KMS output is created for direct output only */
+    window->kms_output = NULL;
+
+    /* ...direct output window covers whole CRTC; rotation stays in application */
+    if (display->drm) {
+        window->surface = NULL, window->shell = NULL, window->native = NULL;
+
+        if ((window->kms_output = kms_output_create(display->drm, info->output, GBM_FORMAT_XRGB8888, __window_flip_done, window, &width, &height)) == NULL) {
+            TRACE(ERROR, _x("failed to create KMS output %u: %m"), info->output);
+            goto error;
+        }
+
+        window->transform = (info->fullscreen ? info->transform : 0);
+        window->scanout = 1;
+        window->egl = eglCreateWindowSurface(display->egl.dpy, display->egl.conf, (EGLNativeWindowType) kms_output_surface(window->kms_output), NULL);
+    } else
+#endif
+#ifdef DISPLAY_X11_ENABLED
+    if (display->x11) {
+        EGLint visual = 0;
+
+        window->surface = NULL, window->shell = NULL, window->native = NULL;
+        window->pointer_focus = window->keyboard_focus = NULL;
+
+        /* ...X window must use visual of EGL configuration */
+        eglGetConfigAttrib(display->egl.dpy, display->egl.conf, EGL_NATIVE_VISUAL_ID, &visual);
+        if ((window->x11_window = x11_window_create(display->x11, visual, info->title, info->fullscreen, __window_x11_event, window, &width, &height)) == NULL) {
+            TRACE(ERROR, _x("failed to create X window: %m"));
+            goto error;
+        }
+
+        /* ...no compositor offload; rotation stays in application */
+        window->transform = (info->fullscreen ? info->transform : 0);
+        window->scanout = 0;
+        window->egl = eglCreateWindowSurface(display->egl.dpy, display->egl.conf, (EGLNativeWindowType) x11_window_native(window->x11_window), NULL);
+    } else
+#endif
+    {
+        /* ...get wayland surface (subsurface maybe?) */
+        window->surface = wl_compositor_create_surface(display->compositor);
+
+        /* ...specify window has the only opaque region */
+        region = wl_compositor_create_region(display->compositor);
+        wl_region_add(region, 0, 0, width, height);
+        wl_surface_set_opaque_region(window->surface, region);
+        wl_region_destroy(region);
+
+        /* ...hand rotation over to compositor if requested (rendering is not rotated then) */
+        window_set_buffer_transform(window, &width, &height, info->fullscreen, info->transform);
+
+        /* ...get desktop shell surface handle */
+        window->shell = wl_shell_get_shell_surface(display->shell, window->surface);
+        wl_shell_surface_add_listener(window->shell, &shell_surface_listener, window);
+        (info->title ? wl_shell_surface_set_title(window->shell, info->title) : 0);
+        wl_shell_surface_set_toplevel(window->shell);
+        (info->fullscreen ? wl_shell_surface_set_fullscreen(window->shell, WL_SHELL_SURFACE_FULLSCREEN_METHOD_DEFAULT, 0, output->output) : 0);
+
+        /* ...set private data poitner */
+        wl_surface_set_user_data(window->surface, window);
+
+        /* ...create native window */
+        window->native = wl_egl_window_create(window->surface, width, height);
+        window->egl = eglCreateWindowSurface(display->egl.dpy, display->egl.conf, window->native, NULL);
+
+        /* ...check if compositor may put window buffer directly on a plane */
+        window_scanout_check(window, output, width, height);
+    }
+
+    /* ...create window user EGL context (share textures with everything else?)*/
+    window->user_egl_ctx = eglCreateContext(display->egl.dpy, display->egl.conf, display->egl.ctx, __egl_context_attribs);
+
+    /* ...create cairo context */
+    window->cairo = cairo_egl_device_create(display->egl.dpy, window->user_egl_ctx);
+    if (__check_device(window->cairo) != 0) {
+        TRACE(ERROR, _x("failed to create cairo device: %m"));
+        goto error;
+    }
+
+    /* ...make it simple - we are handling thread context ourselves */
+    cairo_gl_device_set_thread_aware(window->cairo, FALSE);
+
+    /* ...reset shadowed GL state; batch vertex buffer is created on first use */
+    gl_state_invalidate(&window->gl);
+    window->gl.batch_vbo = 0;
+
+    /* ...set cairo transformation matrix */
+    window_set_transform_matrix(window, &width, &height, info->fullscreen, window->transform);
+
+    /* ...set window EGL context */
+    eglMakeCurrent(display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
+
+    /* ...initialize root widget data */
+    if (__widget_init(&window->widget, window, width, height, info2, cdata) < 0) {
+        TRACE(INIT, _b("widget initialization failed: %m"));
+        goto error;
+    }
+
+    /* ...clear surface to flush all textures loading etc.. - looks a bit strange */
+    if (1) {
+        cairo_t *cr = cairo_create(window->widget.cs);
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+    }
+
+    /* ...release window EGL context */
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    /* ...initialize thread attributes (joinable, default stack size) */
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    /* ...create rendering thread */
+    r = pthread_create(&window->thread, &attr, window_thread, window);
+    pthread_attr_destroy(&attr);
+    if (r != 0) {
+        TRACE(ERROR, _x("thread creation failed: %m"));
+        goto error;
+    }
+
+    /* ...add window to global display list */
+    wl_list_insert(display->windows.prev, &window->link);
+
+    TRACE(INFO, _b("window created: %p:%p, %u * %u, output: %u"), window, window->egl, width, height, info->output);
+
+    return window;
+
+error:
+    /* ...destroy window memory */
+    free(window);
+    return NULL;
+}
+
+static void __destroy_callback(void *data, struct wl_callback *callback, uint32_t serial) {
+    pthread_mutex_t *wait_lock = data;
+
+    TRACE(DEBUG, _b("release wait lock"));
+
+    /* ...release mutex */
+    pthread_mutex_unlock(wait_lock);
+
+    wl_callback_destroy(callback);
+}
+
+static const struct wl_callback_listener __destroy_listener = {
+    __destroy_callback,
+};
+
+/* ...destroy a window */
+void window_destroy(window_data_t *window) {
+    display_data_t *display = window->display;
+    EGLDisplay dpy = display->egl.dpy;
+    const window_info_t *info = window->info;
+    const widget_info_t *info2 = window->widget.info;
+    struct wl_callback *callback;
+
+    /* ...terminate window rendering thread */
+    pthread_mutex_lock(&window->lock);
+    window->flags |= WINDOW_FLAG_TERMINATE;
+    pthread_cond_signal(&window->wait);
+    pthread_mutex_unlock(&window->lock);
+
+    /* ...wait until thread completes */
+    pthread_join(window->thread, NULL);
+
+    TRACE(DEBUG, _b("window[%p] thread joined"), window);
+
+    /* ...remove window from global display list */
+    wl_list_remove(&window->link);
+
+    /* ...acquire window context before doing anything */
+    eglMakeCurrent(dpy, window->egl, window->egl, window->user_egl_ctx);
+
+    /* ...destroy GPU timer queries */
+    window_gpu_destroy(window);
+
+    /* ...destroy batched drawing vertex buffer */
+    if (window->gl.batch_vbo) {
+        glDeleteBuffers(1, &window->gl.batch_vbo);
+        gl_state_deleted();
+    }
+
+    /* ...invoke custom widget destructor function as needed */
+    (info2 && info2->destroy ? info2->destroy(&window->widget, window->cdata) : 0);
+
+    /* ...destroy root widget cairo surface */
+    cairo_surface_destroy(window->widget.cs);
+
+    /* ...invoke custom window destructor function as needed */
+    (info && info->destroy ? info->destroy(window, window->cdata) : 0);
+
+    /* ...destroy cairo device */
+    cairo_device_destroy(window->cairo);
+
+    /* ...release EGL context before destruction */
     eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
-    /* ...destroy context */
-    eglDestroyContext(dpy, window->user_egl_ctx);
+    /* ...destroy context */
+    eglDestroyContext(dpy, window->user_egl_ctx);
+
+    /* ...destroy EGL surface */
+    eglDestroySurface(display->egl.dpy, window->egl);
+
+#ifdef DISPLAY_DRM_ENABLED
+    /* ...direct output has no compositor objects */
+    if (window->kms_output) {
+        /* ...flip completion must not reach destroyed window */
+        pthread_mutex_lock(&window->lock);
+        while (window->flags & WINDOW_FLAG_FLIP_PENDING) {
+            pthread_cond_wait(&window->wait, &window->lock);
+        }
+        pthread_mutex_unlock(&window->lock);
+
+        kms_output_destroy(window->kms_output);
+    } else
+#endif
+#ifdef DISPLAY_X11_ENABLED
+    if (display->x11) {
+        /* ...stop events delivery and destroy X window */
+        x11_window_destroy(window->x11_window);
+    } else
+#endif
+    {
+#ifdef DISPLAY_PLANE_ENABLED
+        /* ...destroy camera plane (compositor releases attached buffer) */
+        if (window->plane_surface) {
+            wp_viewport_destroy(window->plane_viewport);
+            wl_subsurface_destroy(window->plane_sub);
+            wl_surface_destroy(window->plane_surface);
+        }
+#endif
+
+        /* ...destroy native window */
+        wl_egl_window_destroy(window->native);
+
+        /* ...destroy shell surface */
+        wl_shell_surface_destroy(window->shell);
+
+        /* ....destroy wayland surface (shell surface gets destroyed automatically) */
+        wl_surface_destroy(window->surface);
+
+        /* ...make sure function is complete before we actually proceed */
+        if (1 && (callback = wl_display_sync(display->display)) != NULL) {
+            pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+
+            pthread_mutex_lock(&wait_lock);
+            wl_callback_add_listener(callback, &__destroy_listener, &wait_lock);
+
+            wl_display_flush(display->display);
+
+            /* ...mutex will be released in callback function executed from display thread context */
+            pthread_mutex_lock(&wait_lock);
+        }
+    }
+
+    /* ...destroy window lock */
+    pthread_mutex_destroy(&window->lock);
+
+    /* ...destroy rendering thread conditional variable */
+    pthread_cond_destroy(&window->wait);
+
+    /* ...destroy object */
+    free(window);
+
+    TRACE(INFO, _b("window[%p] destroyed"), window);
+}
+
+/* ...return current window width */
+int window_get_width(window_data_t *window) {
+    return window->widget.width;
+}
+
+/* ...return current window height */
+int window_get_height(window_data_t *window) {
+    return window->widget.height;
+}
+
+widget_data_t *window_get_widget(window_data_t *window) {
+    return &window->widget;
+}
+
+const window_info_t *window_get_info(window_data_t *window) {
+    return window->info;
+}
+
+cairo_device_t * window_get_cairo_device(window_data_t *window) {
+    return window->cairo;
+}
+
+cairo_matrix_t * window_get_cmatrix(window_data_t *window) {
+    return &window->cmatrix;
+}
+
+/* ...rotation applied by application to window content */
+u32 window_get_transform(window_data_t *window) {
+    return window->transform;
+}
+
+/* ...direct scanout eligibility of window buffer */
+int window_get_scanout(window_data_t *window) {
+    return window->scanout;
+}
+
+/* ...schedule redrawal of the window */
+void window_schedule_redraw(window_data_t *window) {
+    /* ...acquire window lock */
+    pthread_mutex_lock(&window->lock);
+
+    /* ...check if we don't have a flag already */
+    if ((window->flags & WINDOW_FLAG_REDRAW) == 0) {
+        /* ...set a flag */
+        window->flags |= WINDOW_FLAG_REDRAW;
+
+        /* ...and kick processing thread */
+        pthread_cond_signal(&window->wait);
+
+        TRACE(DEBUG, _b("schedule window[%p] redraw"), window);
+    }
+
+    /* ...release window access lock */
+    pthread_mutex_unlock(&window->lock);
+}
+
+void window_reinit_bv(window_data_t *window) {
+    /* ...acquire window lock */
+    
+    TRACE(INIT, _b("window[%p]: surround view bv reinitialize"), window);
+    pthread_mutex_lock(&window->lock);
+
+    /* ...check if we don't have a flag already */
+    if ((window->flags & WINDOW_BV_REINIT) == 0) {
+        /* ...set a flag */
+        window->flags |= WINDOW_BV_REINIT;
+
+        /* ...and kick processing thread */
+        pthread_cond_signal(&window->wait);
+
+        TRACE(DEBUG, _b("window[%p]: surround view bv reinitialize"), window);
+    }
+
+    /* ...release window access lock */
+    pthread_mutex_unlock(&window->lock);
+}
+
+/* ...submit window to a renderer */
+void window_draw(window_data_t *window) {
+    u32 t0, t1, ts;
+
+    t0 = __get_cpu_cycles();
+
+    /* ...swap includes flushing of deferred cairo drawing */
+    window_gpu_stage(window, WINDOW_GPU_STAGE_SWAP);
+    ts = __get_time_usec();
+
+    /* ...swap buffers (finalize any pending 2D-drawing); pass damage hint if known */
+    if (window->damaged && (window->display->egl.ext & EGL_DATA_EXT_SWAP_DAMAGE)) {
+        cairo_surface_flush(window->widget.cs);
+        eglSwapBuffersWithDamageEXT(window->display->egl.dpy, window->egl, window->damage, 1);
+    } else {
+        cairo_gl_surface_swapbuffers(window->widget.cs);
+    }
+
+    /* ...damage is collected per frame */
+    window->damaged = 0;
+
+    window_gpu_frame_end(window);
+    window_cpu_frame_end(window, __get_time_usec() - ts);
+
+#ifdef DISPLAY_DRM_ENABLED
+    /* ...present buffer on KMS output; only one flip may be in flight */
+    if (window->kms_output) {
+        pthread_mutex_lock(&window->lock);
+        while (window->flags & WINDOW_FLAG_FLIP_PENDING) {
+            pthread_cond_wait(&window->wait, &window->lock);
+        }
+        (kms_output_commit(window->kms_output) == 0 ? window->flags |= WINDOW_FLAG_FLIP_PENDING : 0);
+        pthread_mutex_unlock(&window->lock);
+    }
+#endif
+
+    /* ...make sure everything is correct */
+    BUG(cairo_surface_status(window->widget.cs) != CAIRO_STATUS_SUCCESS, _x("bad status: %s"), cairo_status_to_string(cairo_surface_status(window->widget.cs)));
+
+    t1 = __get_cpu_cycles();
+
+    TRACE(DEBUG, _b("swap[%p]: %u (error=%X)"), window, t1 - t0, eglGetError());
+}
+
+/* ...mark window area (in viewport coordinates) as changed in current frame */
+void window_add_damage(window_data_t *window, int x, int y, int w, int h) {
+    double x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+    int H = window_get_height(window);
+    EGLint *d = window->damage;
+    EGLint r[4];
+
+    /* ...map corners into buffer coordinates (rotation may swap them) */
+    cairo_matrix_transform_point(&window->cmatrix, &x0, &y0);
+    cairo_matrix_transform_point(&window->cmatrix, &x1, &y1);
+
+    /* ...EGL rectangles have origin in lower-left corner */
+    r[0] = (EGLint)floor(MIN(x0, x1)), r[2] = (EGLint)ceil(MAX(x0, x1)) - r[0];
+    r[1] = H - (EGLint)ceil(MAX(y0, y1)), r[3] = (EGLint)ceil(MAX(y0, y1)) - (EGLint)floor(MIN(y0, y1));
+
+    if (!window->damaged) {
+        memcpy(d, r, sizeof(r)), window->damaged = 1;
+    } else {
+        /* ...accumulate bounding box */
+        int x2 = MAX(d[0] + d[2], r[0] + r[2]), y2 = MAX(d[1] + d[3], r[1] + r[3]);
+
+        d[0] = MIN(d[0], r[0]), d[1] = MIN(d[1], r[1]);
+        d[2] = x2 - d[0], d[3] = y2 - d[1];
+    }
+}
+
+/* ...retrieve associated cairo surface */
+cairo_t * window_get_cairo(window_data_t *window) {
+    cairo_t *cr;
+
+    /* ...it is a bug if we lost a context */
+    BUG(eglGetCurrentContext() != window->user_egl_ctx, _x("invalid GL context"));
+
+    /* ...restore original cairo program if it has been switched */
+    gl_state_enter_cairo(&window->gl);
+
+    /* ...create new drawing context */
+    cr = cairo_create(window->widget.cs);
+
+    /* ...set transformation matrix */
+    cairo_set_matrix(cr, &window->cmatrix);
+
+    /* ...make it a bug for a moment */
+    BUG(cairo_status(cr) != CAIRO_STATUS_SUCCESS, _x("invalid status: (%d) - %s"), cairo_status(cr), cairo_status_to_string(cairo_status(cr)));
+
+    return cr;
+}
+
+/* ...release associated cairo surface */
+void window_put_cairo(window_data_t *window, cairo_t *cr) {
+    /* ...destroy cairo drawing interface */
+    cairo_destroy(cr);
+
+    /* ...re-acquire window GL context */
+    eglMakeCurrent(window->display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
+
+    /* ...cairo program is retrieved lazily, only if another program gets used */
+    gl_state_leave_cairo(&window->gl);
+}
+
+/*******************************************************************************
+ * Display module initialization
+ ******************************************************************************/
+
+/* ...create display data */
+display_data_t * display_create(void) {
+    display_data_t *display = &__display;
+    pthread_attr_t attr;
+    int r;
+
+    /* ...reset display data */
+    memset(display, 0, sizeof (*display));
+
+    /* ...open KMS device for direct output, X server, or connect to Wayland display */
+#ifdef DISPLAY_DRM_ENABLED
+    if (display_drm_device) {
+        if ((display->drm = kms_open(display_drm_device)) == NULL) {
+            TRACE(ERROR, _x("failed to open KMS device: %m"));
+            goto error;
+        }
+    } else
+#endif
+#ifdef DISPLAY_X11_ENABLED
+    if (display_x11_name) {
+        if ((display->x11 = x11_open(*display_x11_name ? display_x11_name : NULL)) == NULL) {
+            TRACE(ERROR, _x("failed to open X display: %m"));
+            goto error;
+        }
+    } else
+#endif
+    if ((display->display = wl_display_connect(NULL)) == NULL) {
+        TRACE(ERROR, _x("failed to connect to Wayland: %m"));
+        errno = EBADFD;
+        goto error;
+    } else if ((display->registry = wl_display_get_registry(display->display)) == NULL) {
+        TRACE(ERROR, _x("failed to get registry: %m"));
+        errno = EBADFD;
+        goto error_disp;
+    } else {
+        /* ...set global registry listener */
+        wl_registry_add_listener(display->registry, &registry_listener, display);
+    }
+
+    /* ...initialize inputs/outputs lists */
+    wl_list_init(&display->outputs);
+    wl_list_init(&display->inputs);
+
+    /* ...initialize windows list */
+    wl_list_init(&display->windows);
+
+    /* ...create polling structure */
+    if ((display->efd = epoll_create(DISPLAY_EVENTS_NUM)) < 0) {
+        TRACE(ERROR, _x("failed to create epoll: %m"));
+        goto error_disp;
+    }
+
+    /* ...pre-initialize global Wayland interfaces */
+    if (!__display_native(display)) {
+        do {
+            display->pending = 0, wl_display_roundtrip(display->display);
+        } while (display->pending);
+    }
+
+    /* ...initialize EGL */
+    if (init_egl(display) < 0) {
+        TRACE(ERROR, _x("EGL initialization failed: %m"));
+        goto error_disp;
+    }
+
+    /* ...make current display context */
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, display->egl.ctx);
+
+    /* ...dump available GL extensions */
+    TRACE(INIT, _b("GL version: %s"), (char *) glGetString(GL_VERSION));
+    TRACE(INIT, _b("GL extension: %s"), (char *) glGetString(GL_EXTENSIONS));
+
+    /* ...probe optional GL extensions */
+    if (glMapBufferRangeEXT && __egl_has_extension((const char *) glGetString(GL_EXTENSIONS), "GL_EXT_map_buffer_range")) {
+        display->gl_ext |= DISPLAY_GL_EXT_MAP_BUFFER_RANGE;
+    }
+
+    if (glGetProgramBinaryOES && glProgramBinaryOES && __egl_has_extension((const char *) glGetString(GL_EXTENSIONS), "GL_OES_get_program_binary")) {
+        GLint formats = 0;
+
+        /* ...extension may be exposed with no binary formats supported */
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+        (formats > 0 ? display->gl_ext |= DISPLAY_GL_EXT_PROGRAM_BINARY : 0);
+    }
+
+    if (glGenQueriesEXT && glGetQueryObjectui64vEXT && __egl_has_extension((const char *) glGetString(GL_EXTENSIONS), "GL_EXT_disjoint_timer_query")) {
+        display->gl_ext |= DISPLAY_GL_EXT_TIMER_QUERY;
+    }
+
+    /* ...compile default shaders */
+    if (compile_shaders(display) < 0) {
+        TRACE(ERROR, _x("default shaders compilation failed"));
+        goto error_egl;
+    }
+
+    /* ...release display EGL context */
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    /* ...pass display context to resource thread */
+    if (resource_start(display) < 0) {
+        TRACE(ERROR, _x("resource thread start failed: %m"));
+        goto error_egl;
+    }
+
+#ifdef ENABLE_OBJDET
+    /* ...initialize global CL-context */
+    if (init_cl(display) < 0) {
+        TRACE(ERROR, _x("failed to initialize CL context"));
+        goto error_egl;
+    }
+#endif
+    
+    /* ...initialize thread attributes (joinable, default stack size) */
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    /* ...create Wayland (or DRM events) dispatch thread */
+    r = pthread_create(&display->thread, &attr, (__display_native(display) ? dispatch_thread_epoll : dispatch_thread), display);
+    pthread_attr_destroy(&attr);
+    if (r != 0) {
+        TRACE(ERROR, _x("thread creation failed: %m"));
+#ifdef ENABLE_OBJDET
+        goto error_cl;
+#else
+        goto error_egl;
+#endif
+    }
+
+    /* ...wait until display thread starts? */
+    TRACE(INIT, _b("%s display interface initialized"), __display_backend(display));
+
+#ifdef SPACENAV_ENABLED
+    /* ...initialize extra input devices */
+    input_spacenav_init(display);
+
+    /* ...joystick device requires start-up events generation (should be window-specific) */
+    input_joystick_init(display, joystick_dev_name);
+#endif
+
+    /* ...doesn't look good, actually - don't want to start thread right here */
+    return display;
+
+#ifdef ENABLE_OBJDET
+error_cl:
+    /* ...destroy CL context */
+    fini_cl(display);
+#endif
+
+error_egl:
+    /* ...destroy EGL context */
+    fini_egl(display);
+
+error_disp:
+    /* ...disconnect display */
+#ifdef DISPLAY_DRM_ENABLED
+    if (display->drm) {
+        kms_close(display->drm);
+    } else
+#endif
+#ifdef DISPLAY_X11_ENABLED
+    if (display->x11) {
+        x11_close(display->x11);
+    } else
+#endif
+    {
+        wl_display_flush(display->display);
+        wl_display_disconnect(display->display);
+    }
+
+error:
+    return NULL;
+}
+
+/*******************************************************************************
+ * Textures handling
+ ******************************************************************************/
+
+/* ...draw external texture in given view-port */
+void texture_draw(texture_data_t *texture, texture_view_t *view, texture_crop_t *crop, GLfloat alpha) {
+    display_data_t *display = &__display;
+    gl_shader_t *shader = &display->shader_ext;
+
+    /* ...vertices coordinates */
+    static const GLfloat verts[] = {
+        -1, -1,
+        1, -1,
+        -1, 1,
+        -1, 1,
+        1, -1,
+        1, 1,
+    };
+
+    /* ...triangle coordinates */
+    static const GLfloat texcoords[] = {
+        0, 1,
+        1, 1,
+        0, 0,
+        0, 0,
+        1, 1,
+        1, 0,
+    };
+
+    if (view) {
+        int i;
+        GLfloat *p = *view;
+
+        for (i = 0; i < 12; i += 2, p += 2) {
+            TRACE(0, _b("view[%d] = (%.2f, %.2f)"), i / 2, p[0], p[1]);
+        }
+    }
+
+    if (crop) {
+        int i;
+        GLfloat *p = *crop;
+
+        for (i = 0; i < 12; i += 2, p += 2) {
+            TRACE(0, _b("crop[%d] = (%.2f, %.2f)"), i / 2, p[0], p[1]);
+        }
+    }
+
+    /* ...set current precompiled shader (cairo program is restored on demand) */
+    gl_state_use_program(shader->program);
+
+    /* ...prepare shader uniforms */
+    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, __gl_identity);
+    glUniform1i(shader->tex_uniforms[0], 0);
+    glUniform1f(shader->alpha_uniform, alpha);
+
+    /* ...bind textures */
+    glActiveTexture(GL_TEXTURE0);
+    gl_state_bind_texture_ext(texture->tex);
+
+    /* ...vertices are passed in client arrays (VBO may be left bound by previous draw) */
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+    /* ...set vertices array attribute */
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (view ? *view : verts));
+    glEnableVertexAttribArray(0);
+
+    /* ...set vertex coordinates attribute */
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (crop ? *crop : texcoords));
+    glEnableVertexAttribArray(1);
+
+    /* ...render triangles on the surface */
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    /* ...disable generic attributes arrays */
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+}
+
+/* ...draw several external textures with a single call per TEXTURE_BATCH_MAX textures */
+void texture_draw_batch(int n, texture_data_t **textures, texture_view_t *views, texture_crop_t *crops, GLfloat alpha) {
+    display_data_t *display = &__display;
+    gl_shader_t *shader = &display->shader_batch;
+    gl_state_t *gl = __gl_state;
+    GLfloat data[TEXTURE_BATCH_MAX * 6 * 5];
+    const GLvoid *base;
+    int i, j, k;
+
+    /* ...default texture coordinates */
+    static const GLfloat texcoords[] = {
+        0, 1,
+        1, 1,
+        0, 0,
+        0, 0,
+        1, 1,
+        1, 0,
+    };
+
+    /* ...set current precompiled shader (cairo program is restored on demand) */
+    gl_state_use_program(shader->program);
+
+    /* ...prepare shader uniforms */
+    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, __gl_identity);
+    glUniform1f(shader->alpha_uniform, alpha);
+    for (i = 0; i < TEXTURE_BATCH_MAX; i++) {
+        glUniform1i(shader->tex_uniforms[i], i);
+    }
+
+    /* ...vertices are streamed through a per-context buffer when state is tracked */
+    if (gl && !gl->batch_vbo) {
+        glGenBuffers(1, &gl->batch_vbo);
+    }
+
+    for (i = 0; i < n; i += k) {
+        GLfloat *p = data;
+
+        /* ...bind chunk textures to consecutive units (unit #0 binding is shadowed) */
+        for (k = 0; k < TEXTURE_BATCH_MAX && i + k < n; k++) {
+            const GLfloat *v = views[i + k];
+            const GLfloat *t = (crops ? crops[i + k] : texcoords);
+
+            glActiveTexture(GL_TEXTURE0 + k);
+            if (k == 0) {
+                gl_state_bind_texture_ext(textures[i]->tex);
+            } else {
+                glBindTexture(GL_TEXTURE_EXTERNAL_OES, textures[i + k]->tex);
+            }
+
+            /* ...interleave position, texture coordinates and unit index */
+            for (j = 0; j < 6; j++, v += 2, t += 2) {
+                *p++ = v[0], *p++ = v[1], *p++ = t[0], *p++ = t[1], *p++ = (GLfloat)k;
+            }
+        }
+
+        if (gl) {
+            /* ...orphan previous storage to avoid waiting for pending draws */
+            gl_state_bind_buffer(GL_ARRAY_BUFFER, gl->batch_vbo);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(data), NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (p - data) * sizeof(GLfloat), data);
+            base = NULL;
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            base = data;
+        }
+
+        /* ...set interleaved attributes */
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), base);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (const GLfloat *)base + 2);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (const GLfloat *)base + 4);
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+
+        /* ...render whole chunk with a single call */
+        glDrawArrays(GL_TRIANGLES, 0, 6 * k);
+    }
+
+    /* ...disable generic attributes arrays */
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glDisableVertexAttribArray(2);
+
+    /* ...leave unit #0 active as other drawing functions assume */
+    glActiveTexture(GL_TEXTURE0);
+
+    /* ...other drawing functions source client arrays; release streaming buffer binding */
+    if (gl) {
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+#define EGL_NATIVE_PIXFORMAT_NV16_REL 12
+
+/* ...translate V4L2 pixel-format into EGL-format */
+static inline int __pixfmt_gst_to_egl(int format) {
+    switch (format) {
+        case GST_VIDEO_FORMAT_NV12: return EGL_NATIVE_PIXFORMAT_NV12_REL;
+        case GST_VIDEO_FORMAT_UYVY: return EGL_NATIVE_PIXFORMAT_UYVY_REL;
+        case GST_VIDEO_FORMAT_NV16: return EGL_NATIVE_PIXFORMAT_NV16_REL;
+        default: return TRACE(ERROR, _x("unsupported format: %d"), format), -1;
+    }
+}
+
+/* ...bind external texture to EGL image (in current context) */
+static void __texture_bind_image(texture_data_t *texture, EGLImageKHR image) {
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture->tex);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, image);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+
+    /* ...active unit is not known here; binding may be executed in window context */
+    gl_state_forget(GL_STATE_TEXTURE_EXT);
+}
+
+/*******************************************************************************
+ * Asynchronous texture upload (for buffers without zero-copy wrapping)
+ ******************************************************************************/
+
+/* ...maximal number of source planes */
+#define TEXTURE_UPLOAD_PLANES           2
+
+/* ...number of pixel-buffer objects in upload ring */
+#define TEXTURE_UPLOAD_RING             3
+
+/* ...maximal number of pending upload requests */
+#define TEXTURE_UPLOAD_QUEUE            16
+
+/* ...statistics reporting period (in microseconds) */
+#define TEXTURE_UPLOAD_REPORT           5000000
+
+/* ...copy-upload texture data */
+struct texture_upload {
+    /* ...image dimensions and format */
+    int w, h, format;
+
+    /* ...source planes strides (zero if tightly packed) */
+    int stride[TEXTURE_UPLOAD_PLANES];
+
+    /* ...plane textures (GL_TEXTURE_2D) */
+    GLuint planes[TEXTURE_UPLOAD_PLANES];
+
+    /* ...RGBA render target exported as EGL image */
+    GLuint target;
+};
+
+/* ...upload request */
+typedef struct upload_request {
+    /* ...texture to update */
+    texture_data_t *texture;
+
+    /* ...completion callback */
+    void (*cb)(texture_data_t *, void *);
+    void *cdata;
+
+    /* ...submission timestamp */
+    u32 ts;
+
+} upload_request_t;
+
+/* ...upload ring slot */
+typedef struct upload_slot {
+    /* ...pixel-buffer object */
+    GLuint pbo;
+
+    /* ...allocated PBO size */
+    u32 size;
+
+    /* ...GPU completion fence */
+    EGLSyncKHR sync;
+
+    /* ...request in flight */
+    upload_request_t req;
+
+} upload_slot_t;
+
+/* ...uploader data */
+struct texture_uploader {
+    /* ...upload thread handle */
+    pthread_t thread;
+
+    /* ...requests queue access lock and signalling variable */
+    pthread_mutex_t lock;
+    pthread_cond_t wait;
+
+    /* ...requests queue */
+    upload_request_t queue[TEXTURE_UPLOAD_QUEUE];
+    int head, count;
+
+    /* ...thread start-up completion and result */
+    int ready, status;
+
+    /* ...termination request */
+    int stop;
+
+    /* ...dedicated shared context */
+    EGLContext ctx;
+
+    /* ...pixel-buffer objects available (GLES3 context) */
+    int pbo;
+
+    /* ...PBO ring and next slot index */
+    upload_slot_t ring[TEXTURE_UPLOAD_RING];
+    int slot;
+
+    /* ...conversion shaders (semi-planar YUV and packed UYVY) */
+    gl_shader_t shader_yuv, shader_uyvy;
+
+    /* ...render-target framebuffer */
+    GLuint fbo;
+
+    /* ...statistics: uploaded frames and bytes, latency in microseconds */
+    u32 frames, latency_max, ts;
+    u64 bytes, latency_acc;
+};
+
+/* ...conversion vertex shader (full-screen quad) */
+static const char upload_vertex_shader[] =
+        "attribute vec2 position;\n"
+        "varying vec2 v_texcoord;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = vec4(position, 0.0, 1.0);\n"
+        "   v_texcoord = position * 0.5 + 0.5;\n"
+        "}\n";
+
+/* ...semi-planar YUV (NV12/NV16) to RGB conversion */
+static const char upload_fragment_shader_yuv[] =
+        "precision mediump float;\n"
+        "varying vec2 v_texcoord;\n"
+        "uniform sampler2D tex;\n"
+        "uniform sampler2D tex_uv;\n"
+        "void main()\n"
+        "{\n"
+        "   float y = 1.1643 * (texture2D(tex, v_texcoord).r - 0.0625);\n"
+        "   vec2 uv = texture2D(tex_uv, v_texcoord).ra - 0.5;\n"
+        "   gl_FragColor = vec4(y + 1.5958 * uv.y, y - 0.39173 * uv.x - 0.8129 * uv.y, y + 2.017 * uv.x, 1.0);\n"
+        "}\n";
+
+/* ...packed UYVY to RGB conversion (two pixels per RGBA texel) */
+static const char upload_fragment_shader_uyvy[] =
+        "precision mediump float;\n"
+        "varying vec2 v_texcoord;\n"
+        "uniform sampler2D tex;\n"
+        "uniform float width;\n"
+        "void main()\n"
+        "{\n"
+        "   vec4 p = texture2D(tex, v_texcoord);\n"
+        "   float y = 1.1643 * (mix(p.g, p.a, step(0.5, fract(v_texcoord.x * width * 0.5))) - 0.0625);\n"
+        "   vec2 uv = p.rb - 0.5;\n"
+        "   gl_FragColor = vec4(y + 1.5958 * uv.y, y - 0.39173 * uv.x - 0.8129 * uv.y, y + 2.017 * uv.x, 1.0);\n"
+        "}\n";
+
+/* ...upload context attributes (PBO requires GLES3) */
+static const EGLint __egl_upload_context_attribs[] = {
+    EGL_CONTEXT_CLIENT_VERSION, 3,
+    EGL_NONE
+};
+
+/* ...plane layout of supported formats */
+static inline int __upload_plane(int format, int w, int h, int i, int *pw, int *ph, GLenum *fmt) {
+    switch (format) {
+        case GST_VIDEO_FORMAT_NV12:
+            return (i == 0 ? (*pw = w, *ph = h, *fmt = GL_LUMINANCE, w * h) : (*pw = w / 2, *ph = h / 2, *fmt = GL_LUMINANCE_ALPHA, w * h / 2));
+        case GST_VIDEO_FORMAT_NV16:
+            return (i == 0 ? (*pw = w, *ph = h, *fmt = GL_LUMINANCE, w * h) : (*pw = w / 2, *ph = h, *fmt = GL_LUMINANCE_ALPHA, w * h));
+        case GST_VIDEO_FORMAT_UYVY:
+            return (i == 0 ? (*pw = w / 2, *ph = h, *fmt = GL_RGBA, w * h * 2) : 0);
+        default:
+            return 0;
+    }
+}
+
+/* ...copy plane rows into staging memory (source plane may be padded) */
+static inline void __upload_copy(u8 *dst, const u8 *src, int row, int stride, int rows) {
+    if (stride == row) {
+        memcpy(dst, src, row * rows);
+    } else {
+        for (; rows > 0; rows--, dst += row, src += stride) {
+            memcpy(dst, src, row);
+        }
+    }
+}
+
+/* ...complete upload in a ring slot (blocks upload thread only) */
+static void __upload_complete(texture_uploader_t *uploader, upload_slot_t *slot) {
+    display_data_t *display = &__display;
+    upload_request_t *req = &slot->req;
+    u32 now, delta;
+
+    /* ...wait for GPU completion of the copy and conversion */
+    eglClientWaitSyncKHR(display->egl.dpy, slot->sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+    eglDestroySyncKHR(display->egl.dpy, slot->sync);
+    slot->sync = EGL_NO_SYNC_KHR;
+
+    /* ...update latency statistics */
+    now = __get_time_usec(), delta = now - req->ts;
+    uploader->latency_acc += delta;
+    (uploader->latency_max < delta ? uploader->latency_max = delta : 0);
+
+    uploader->frames++;
+
+    /* ...report bandwidth and latency periodically */
+    if (now - uploader->ts >= TEXTURE_UPLOAD_REPORT) {
+        float k = 1e+06 / (now - uploader->ts);
+
+        TRACE(INFO, _b("upload: %.1f fps, %.1f MB/s, latency avg=%u us, max=%u us"),
+              uploader->frames * k, uploader->bytes * k / (1 << 20),
+              (u32)(uploader->latency_acc / uploader->frames), uploader->latency_max);
+
+        uploader->frames = 0, uploader->bytes = 0, uploader->latency_acc = 0, uploader->latency_max = 0;
+        uploader->ts = now;
+    }
+
+    /* ...notify requester texture content is ready */
+    req->cb(req->texture, req->cdata);
+}
+
+/* ...copy planes into textures and convert them into render target */
+static void __upload_submit(texture_uploader_t *uploader, upload_slot_t *slot, upload_request_t *req) {
+    display_data_t *display = &__display;
+    texture_upload_t *upload = req->texture->upload;
+    static const GLfloat quad[] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+    gl_shader_t *shader;
+    u32 size = __pixfmt_image_size(upload->w, upload->h, upload->format);
+    u8 *p = NULL;
+    int i, j, pw, ph, offset;
+    GLenum fmt;
+
+    /* ...stage planes in a pixel-buffer object; orphan storage to avoid implicit sync */
+    if (uploader->pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        slot->size = size;
+        p = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT_EXT | GL_MAP_INVALIDATE_BUFFER_BIT_EXT);
+    }
+
+    for (i = offset = 0; i < TEXTURE_UPLOAD_PLANES; i++) {
+        int n = __upload_plane(upload->format, upload->w, upload->h, i, &pw, &ph, &fmt);
+        const u8 *src = req->texture->data[i];
+        int row, stride;
+
+        if (n == 0) break;
+
+        row = n / ph, stride = (upload->stride[i] ? : row);
+
+        glBindTexture(GL_TEXTURE_2D, upload->planes[i]);
+
+        if (p) {
+            /* ...copy into mapped PBO; texture update is sourced from GPU-visible memory */
+            __upload_copy(p + offset, src, row, stride, ph);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pw, ph, fmt, GL_UNSIGNED_BYTE, (void *)(uintptr_t)offset);
+        } else if (stride == row) {
+            /* ...no PBO support; copy from client memory (still off the render thread) */
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pw, ph, fmt, GL_UNSIGNED_BYTE, src);
+        } else {
+            /* ...GLES2 has no unpack row length; padded plane is updated row by row */
+            for (j = 0; j < ph; j++) {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, j, pw, 1, fmt, GL_UNSIGNED_BYTE, src + j * stride);
+            }
+        }
+
+        offset += n;
+    }
+
+    if (p) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    uploader->bytes += offset;
+
+    /* ...convert planes into RGBA render target */
+    shader = (upload->format == GST_VIDEO_FORMAT_UYVY ? &uploader->shader_uyvy : &uploader->shader_yuv);
+    glBindFramebuffer(GL_FRAMEBUFFER, uploader->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, upload->target, 0);
+    glViewport(0, 0, upload->w, upload->h);
+    glUseProgram(shader->program);
+    glUniform1i(shader->tex_uniforms[0], 0);
+    glUniform1i(shader->tex_uniforms[1], 1);
+    glUniform1f(shader->width_uniform, upload->w);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, upload->planes[0]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, upload->planes[1]);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    /* ...insert completion fence and kick GPU */
+    slot->sync = eglCreateSyncKHR(display->egl.dpy, EGL_SYNC_FENCE_KHR, NULL);
+    slot->req = *req;
+    glFlush();
+}
+
+/* ...upload thread */
+static void * texture_upload_thread(void *arg) {
+    texture_uploader_t *uploader = arg;
+    display_data_t *display = &__display;
+    upload_request_t req;
+    upload_slot_t *slot;
+    int i, r = 0;
+
+    /* ...make dedicated shared context current (surfaceless) */
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, uploader->ctx);
+
+    /* ...prepare conversion resources; report start-up result to the creator */
+    if (shader_init(&uploader->shader_yuv, upload_vertex_shader, upload_fragment_shader_yuv, 2) < 0 ||
+        shader_init(&uploader->shader_uyvy, upload_vertex_shader, upload_fragment_shader_uyvy, 1) < 0) {
+        TRACE(ERROR, _x("upload shaders compilation failed"));
+        r = -(errno ? : EINVAL);
+    }
+
+    pthread_mutex_lock(&uploader->lock);
+    uploader->ready = 1, uploader->status = r;
+    pthread_cond_broadcast(&uploader->wait);
+    pthread_mutex_unlock(&uploader->lock);
+
+    if (r < 0) {
+        goto out;
+    }
+
+    uploader->shader_yuv.tex_uniforms[1] = glGetUniformLocation(uploader->shader_yuv.program, "tex_uv");
+    uploader->shader_uyvy.tex_uniforms[1] = -1;
+    uploader->shader_yuv.width_uniform = -1;
+    uploader->shader_uyvy.width_uniform = glGetUniformLocation(uploader->shader_uyvy.program, "width");
+    glGenFramebuffers(1, &uploader->fbo);
+    for (i = 0; i < TEXTURE_UPLOAD_RING; i++) {
+        if (uploader->pbo) {
+            glGenBuffers(1, &uploader->ring[i].pbo);
+        }
+        uploader->ring[i].sync = EGL_NO_SYNC_KHR;
+    }
+
+    uploader->ts = __get_time_usec();
+
+    TRACE(INIT, _b("texture upload thread started (pbo=%d)"), uploader->pbo);
+
+    pthread_mutex_lock(&uploader->lock);
+
+    while (1) {
+        /* ...retire all uploads in flight if there is nothing more to submit */
+        while (uploader->count == 0) {
+            for (i = 0; i < TEXTURE_UPLOAD_RING; i++) {
+                slot = &uploader->ring[(uploader->slot + i) % TEXTURE_UPLOAD_RING];
+
+                if (slot->sync != EGL_NO_SYNC_KHR) {
+                    pthread_mutex_unlock(&uploader->lock);
+                    __upload_complete(uploader, slot);
+                    pthread_mutex_lock(&uploader->lock);
+                }
+            }
+
+            if (uploader->count > 0) {
+                break;
+            } else if (uploader->stop) {
+                /* ...all requests are completed; terminate */
+                pthread_mutex_unlock(&uploader->lock);
+                goto out;
+            }
+
+            pthread_cond_wait(&uploader->wait, &uploader->lock);
+        }
+
+        /* ...dequeue request */
+        req = uploader->queue[uploader->head];
+        uploader->head = (uploader->head + 1) % TEXTURE_UPLOAD_QUEUE, uploader->count--;
+        pthread_mutex_unlock(&uploader->lock);
+
+        /* ...reuse oldest ring slot; wait for its previous upload if still in flight */
+        slot = &uploader->ring[uploader->slot];
+        uploader->slot = (uploader->slot + 1) % TEXTURE_UPLOAD_RING;
+        if (slot->sync != EGL_NO_SYNC_KHR) {
+            __upload_complete(uploader, slot);
+        }
+
+        __upload_submit(uploader, slot, &req);
+
+        pthread_mutex_lock(&uploader->lock);
+    }
+
+out:
+    /* ...release conversion resources */
+    for (i = 0; i < TEXTURE_UPLOAD_RING; i++) {
+        glDeleteBuffers(1, &uploader->ring[i].pbo);
+    }
+    glDeleteFramebuffers(1, &uploader->fbo);
+    glDeleteProgram(uploader->shader_yuv.program);
+    glDeleteProgram(uploader->shader_uyvy.program);
+
+    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+
+    TRACE(INIT, _b("texture upload thread terminated"));
+
+    return NULL;
+}
+
+/* ...start upload thread (called from resource context) */
+static texture_uploader_t * texture_uploader_start(display_data_t *display) {
+    texture_uploader_t *uploader;
+    EGLDisplay dpy = display->egl.dpy;
+    pthread_attr_t attr;
+    int r;
+
+    CHK_ERR(uploader = calloc(1, sizeof (*uploader)), (errno = ENOMEM, NULL));
+
+    /* ...fences are mandatory for completion tracking */
+    if (!(eglCreateSyncKHR && eglClientWaitSyncKHR && eglDestroySyncKHR)) {
+        TRACE(ERROR, _x("EGL_KHR_fence_sync is not supported"));
+        errno = ENOTSUP;
+        goto error;
+    }
+
+    /* ...create dedicated context sharing objects with display; prefer GLES3 for PBOs */
+    if ((uploader->ctx = eglCreateContext(dpy, display->egl.conf, display->egl.ctx, __egl_upload_context_attribs)) != EGL_NO_CONTEXT) {
+        uploader->pbo = (glMapBufferRange && glUnmapBuffer);
+    } else if ((uploader->ctx = eglCreateContext(dpy, display->egl.conf, display->egl.ctx, __egl_context_attribs)) == EGL_NO_CONTEXT) {
+        TRACE(ERROR, _x("failed to create upload context: %X"), eglGetError());
+        errno = ENODEV;
+        goto error;
+    }
+
+    pthread_mutex_init(&uploader->lock, NULL);
+    pthread_cond_init(&uploader->wait, NULL);
+
+    /* ...start upload thread */
+    pthread_attr_init(&attr);
+    r = pthread_create(&uploader->thread, &attr, texture_upload_thread, uploader);
+    pthread_attr_destroy(&attr);
+    if (r != 0) {
+        TRACE(ERROR, _x("failed to create upload thread: %d"), r);
+        errno = r;
+        goto error_ctx;
+    }
+
+    /* ...wait until conversion resources are prepared */
+    pthread_mutex_lock(&uploader->lock);
+    while (!uploader->ready) {
+        pthread_cond_wait(&uploader->wait, &uploader->lock);
+    }
+    pthread_mutex_unlock(&uploader->lock);
+
+    if (uploader->status < 0) {
+        pthread_join(uploader->thread, NULL);
+        errno = -uploader->status;
+        goto error_ctx;
+    }
+
+    return uploader;
+
+error_ctx:
+    pthread_cond_destroy(&uploader->wait);
+    pthread_mutex_destroy(&uploader->lock);
+    eglDestroyContext(dpy, uploader->ctx);
+
+error:
+    free(uploader);
+    return NULL;
+}
+
+/* ...complete pending uploads and terminate upload thread (no new requests may be submitted) */
+void texture_upload_stop(void) {
+    display_data_t *display = &__display;
+    texture_uploader_t *uploader = display->uploader;
+
+    if (!uploader) {
+        return;
+    }
+
+    pthread_mutex_lock(&uploader->lock);
+    uploader->stop = 1;
+    pthread_cond_signal(&uploader->wait);
+    pthread_mutex_unlock(&uploader->lock);
+
+    pthread_join(uploader->thread, NULL);
+    display->uploader = NULL;
+
+    /* ...copy-upload textures stay valid; new uploader is started on next creation */
+    pthread_cond_destroy(&uploader->wait);
+    pthread_mutex_destroy(&uploader->lock);
+    eglDestroyContext(display->egl.dpy, uploader->ctx);
+    free(uploader);
+}
+
+/* ...create copy-upload texture objects (resource context) */
+static int __texture_create_upload(display_data_t *display, void *arg) {
+    texture_data_t *texture = arg;
+    texture_upload_t *upload = texture->upload;
+    int w = upload->w, h = upload->h, format = upload->format;
+    int i, pw, ph;
+    GLenum fmt;
+
+    /* ...start upload thread on first use (resource thread is the only caller) */
+    if (!display->uploader && (display->uploader = texture_uploader_start(display)) == NULL) {
+        return -errno;
+    }
+
+    /* ...allocate plane textures */
+    glGenTextures(TEXTURE_UPLOAD_PLANES, upload->planes);
+    for (i = 0; i < TEXTURE_UPLOAD_PLANES && __upload_plane(format, w, h, i, &pw, &ph, &fmt); i++) {
+        glBindTexture(GL_TEXTURE_2D, upload->planes[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, fmt, pw, ph, 0, fmt, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    /* ...allocate RGBA render target */
+    glGenTextures(1, &upload->target);
+    glBindTexture(GL_TEXTURE_2D, upload->target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    /* ...export render target as EGL image; consumers keep sampling external texture */
+    texture->pdata = eglCreateImageKHR(display->egl.dpy, eglGetCurrentContext(), EGL_GL_TEXTURE_2D_KHR, (EGLClientBuffer)(uintptr_t)upload->target, NULL);
+    if (texture->pdata == EGL_NO_IMAGE_KHR) {
+        TRACE(ERROR, _x("failed to export render target: %X"), eglGetError());
+        glDeleteTextures(TEXTURE_UPLOAD_PLANES, upload->planes);
+        glDeleteTextures(1, &upload->target);
+        return -ENOTSUP;
+    }
+
+    glGenTextures(1, &texture->tex);
+    __texture_bind_image(texture, texture->pdata);
+
+    /* ...make sure objects are visible to the upload context */
+    glFinish();
+
+    TRACE(INFO, _b("upload texture %d*%d: tex=%u, target=%u"), w, h, texture->tex, upload->target);
+
+    return 0;
+}
+
+/* ...create texture updated by copy-upload */
+static texture_data_t * texture_create_upload(int w, int h, void **data, int *stride, int format) {
+    display_data_t *display = &__display;
+    texture_data_t *texture;
+    texture_upload_t *upload;
+    int pw, ph, r;
+    GLenum fmt;
+
+    CHK_ERR(__upload_plane(format, w, h, 0, &pw, &ph, &fmt), (errno = EINVAL, NULL));
+    CHK_ERR(texture = calloc(1, sizeof (*texture)), (errno = ENOMEM, NULL));
+    CHK_ERR(texture->upload = upload = calloc(1, sizeof (*upload)), (free(texture), errno = ENOMEM, NULL));
+
+    memcpy(texture->data, data, sizeof (texture->data));
+    texture->size[0] = __pixfmt_image_size(w, h, format);
+    upload->w = w, upload->h = h, upload->format = format;
+    (stride ? memcpy(upload->stride, stride, sizeof (upload->stride)) : NULL);
+
+    /* ...create GL objects in resource context */
+    if ((r = resource_call(display, __texture_create_upload, texture)) < 0) {
+        free(upload);
+        free(texture);
+        errno = -r;
+        return NULL;
+    }
+
+    return texture;
+}
+
+/* ...schedule texture content update from CPU planes; callback invoked when GPU copy completes */
+int texture_upload(texture_data_t *texture, void (*cb)(texture_data_t *, void *), void *cdata) {
+    texture_uploader_t *uploader = __display.uploader;
+    upload_request_t *req;
+
+    CHK_ERR(texture->upload && uploader, -EINVAL);
+
+    pthread_mutex_lock(&uploader->lock);
+
+    /* ...reject request if upload thread cannot keep up */
+    if (uploader->count == TEXTURE_UPLOAD_QUEUE) {
+        pthread_mutex_unlock(&uploader->lock);
+        TRACE(DEBUG, _b("upload queue overflow"));
+        return -EBUSY;
+    }
+
+    req = &uploader->queue[(uploader->head + uploader->count++) % TEXTURE_UPLOAD_QUEUE];
+    req->texture = texture, req->cb = cb, req->cdata = cdata, req->ts = __get_time_usec();
+
+    pthread_cond_signal(&uploader->wait);
+    pthread_mutex_unlock(&uploader->lock);
+
+    return 0;
+}
+
+/* ...pixmap wrapping command arguments */
+typedef struct texture_pixmap_cmd {
+    /* ...texture being created */
+    texture_data_t *texture;
+
+    /* ...vendor pixmap descriptor */
+    EGLNativePixmapTypeREL pixmap;
+
+} texture_pixmap_cmd_t;
+
+/* ...wrap vendor pixmap into external texture (resource context) */
+static int __texture_create_pixmap(display_data_t *display, void *arg) {
+    texture_pixmap_cmd_t *cmd = arg;
+    texture_data_t *texture = cmd->texture;
+    EGLImageKHR image;
+
+    /* ...create EGL surface for a pixmap */
+    image = eglCreateImageKHR(display->egl.dpy, NULL, EGL_NATIVE_PIXMAP_KHR, &cmd->pixmap, NULL);
+    if (image == EGL_NO_IMAGE_KHR) {
+        TRACE(INFO, _b("pixmap wrapping failed (%X); use upload path"), eglGetError());
+        return -ENOTSUP;
+    }
+
+    /* ...allocate texture and bind it to the output device */
+    texture->pdata = image;
+    glGenTextures(1, &texture->tex);
+    __texture_bind_image(texture, image);
+    TRACE(INFO, _b("plane #0: image=%p, tex=%u, data=%p"), image, texture->tex, texture->data[0]);
+
+    return 0;
+}
+
+/* ...bind EGL image to a new external texture (resource context) */
+static int __texture_create_image(display_data_t *display, void *arg) {
+    texture_data_t *texture = arg;
+    GLenum err;
+
+    /* ...reset error flag; binding failure is reported by GL only */
+    glGetError();
+
+    glGenTextures(1, &texture->tex);
+    __texture_bind_image(texture, texture->pdata);
+
+    if ((err = glGetError()) != GL_NO_ERROR) {
+        TRACE(ERROR, _x("failed to bind image %p: %X"), texture->pdata, err);
+        glDeleteTextures(1, &texture->tex);
+        return -ENOTSUP;
+    }
+
+    return 0;
+}
+
+/* ...texture creation (GL objects are created by resource thread) */
+texture_data_t * texture_create(int w, int h, void **data, int format) {
+    display_data_t *display = &__display;
+    texture_pixmap_cmd_t cmd;
+    texture_data_t *texture;
+
+    /* ...map format to the internal value */
+    CHK_ERR(cmd.pixmap.format = __pixfmt_gst_to_egl(format), (errno = EINVAL, NULL));
+
+    /* ...allocate texture data */
+    CHK_ERR(texture = malloc(sizeof (*texture)), (errno = ENOMEM, NULL));
+
+    /* ...save planes buffers pointers */
+    memcpy(texture->data, data, sizeof (texture->data));
+    texture->size[0] = __pixfmt_image_size(w, h, format);
+    texture->upload = NULL;
+
+    /* ...pixmap descriptor */
+    cmd.texture = texture;
+    cmd.pixmap.width = w;
+    cmd.pixmap.height = h;
+    cmd.pixmap.stride = w;
+    cmd.pixmap.usage = 0;
+    cmd.pixmap.pixelData = texture->data[0];
+
+    /* ...no zero-copy wrapping available; switch to copy-upload path */
+    if (resource_call(display, __texture_create_pixmap, &cmd) < 0) {
+        free(texture);
+        return texture_create_upload(w, h, data, NULL, format);
+    }
+
+    return texture;
+}
+
+/* ...translate GStreamer pixel-format into DRM fourcc */
+static inline u32 __pixfmt_gst_to_drm(int format, int *planes) {
+    switch (format) {
+        case GST_VIDEO_FORMAT_NV12: return *planes = 2, DRM_FORMAT_NV12;
+        case GST_VIDEO_FORMAT_UYVY: return *planes = 1, DRM_FORMAT_UYVY;
+        case GST_VIDEO_FORMAT_NV16: return *planes = 2, DRM_FORMAT_NV16;
+        default: return 0;
+    }
+}
+
+/* ...tightly packed plane pitch of DMA-buffer formats */
+static inline int __pixfmt_plane_pitch(int w, int format) {
+    return (format == GST_VIDEO_FORMAT_UYVY ? w * 2 : w);
+}
+
+/* ...texture creation from planes memory (padded planes are copy-uploaded) */
+static texture_data_t * __texture_create_memory(int w, int h, void **data, int *stride, int format) {
+    int pitch = __pixfmt_plane_pitch(w, format);
+    int i, n;
+
+    /* ...memory wrapping assumes planes are not padded and follow each other */
+    if (__pixfmt_gst_to_drm(format, &n) == 0) {
+        n = 1;
+    }
+
+    for (i = 0; i < n; i++) {
+        if ((stride && stride[i] && stride[i] != pitch) ||
+            (i > 0 && data && data[i] && (u8 *)data[i] != (u8 *)data[0] + pitch * h)) {
+            TRACE(INFO, _b("plane #%d is padded (stride=%d, width=%d); use upload path"), i, (stride ? stride[i] : 0), w);
+            return texture_create_upload(w, h, data, stride, format);
+        }
+    }
+
+    return texture_create(w, h, data, format);
+}
+
+/* ...descriptor, offset and pitch of dma-buf plane; zero stride means tightly packed */
+static void __dmabuf_plane_layout(int w, int h, int *fd, int *stride, int *offset, int format, int i, int *pfd, int *poffset, int *pitch) {
+    *pfd = (i > 0 && fd[i] < 0 ? fd[0] : fd[i]);
+    *pitch = (stride && stride[i] ? stride[i] : __pixfmt_plane_pitch(w, format));
+    *poffset = (offset ? offset[i] : 0);
+
+    /* ...chroma plane with unknown offset follows luma plane sharing the descriptor */
+    if (i > 0 && *pfd == fd[0] && *poffset == 0) {
+        *poffset = (offset ? offset[0] : 0) + (stride && stride[0] ? stride[0] : __pixfmt_plane_pitch(w, format)) * h;
+    }
+}
+
+/* ...texture creation from DMA buffers (standard import path with vendor-pixmap fallback) */
+texture_data_t * texture_create_dmabuf(int w, int h, void **data, int *fd, int *stride, int *offset, u64 modifier, int format) {
+    static const EGLint plane_attr[3][5] = {
+        { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+          EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT,
+#endif
+        },
+        { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+          EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT,
+#endif
+        },
+        { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+          EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT,
+#endif
+        },
+    };
+    display_data_t *display = &__display;
+    EGLDisplay dpy = display->egl.dpy;
+    texture_data_t *texture;
+    EGLImageKHR image;
+    EGLint attr[64], *a = attr;
+    u32 fourcc;
+    int i, n, r;
+
+    /* ...use vendor pixmap path if standard import is not available */
+    if (!(display->egl.ext & EGL_DATA_EXT_DMABUF_IMPORT) || !fd || fd[0] < 0) {
+        return __texture_create_memory(w, h, data, stride, format);
+    }
+
+    /* ...map format to DRM fourcc */
+    if ((fourcc = __pixfmt_gst_to_drm(format, &n)) == 0) {
+        TRACE(ERROR, _x("unsupported format: %d"), format);
+        return __texture_create_memory(w, h, data, stride, format);
+    }
+
+    /* ...explicit layout modifier can be passed only if driver accepts modifiers */
+    if (modifier != DRM_FORMAT_MOD_INVALID && !(display->egl.ext & EGL_DATA_EXT_DMABUF_MODIFIERS)) {
+        TRACE(ERROR, _x("modifier %llX cannot be imported"), (unsigned long long)modifier);
+        return __texture_create_memory(w, h, data, stride, format);
+    }
+
+    /* ...image attributes */
+    *a++ = EGL_WIDTH, *a++ = w;
+    *a++ = EGL_HEIGHT, *a++ = h;
+    *a++ = EGL_LINUX_DRM_FOURCC_EXT, *a++ = fourcc;
+    *a++ = EGL_YUV_COLOR_SPACE_HINT_EXT, *a++ = EGL_ITU_REC601_EXT;
+    *a++ = EGL_SAMPLE_RANGE_HINT_EXT, *a++ = EGL_YUV_NARROW_RANGE_EXT;
+
+    /* ...planes layout as described by buffer */
+    for (i = 0; i < n; i++) {
+        int pfd, poffset, pitch;
+
+        __dmabuf_plane_layout(w, h, fd, stride, offset, format, i, &pfd, &poffset, &pitch);
+
+        *a++ = plane_attr[i][0], *a++ = pfd;
+        *a++ = plane_attr[i][1], *a++ = poffset;
+        *a++ = plane_attr[i][2], *a++ = pitch;
+
+#ifdef EGL_EXT_image_dma_buf_import_modifiers
+        /* ...explicit layout modifier; implicit layout is driver-defined */
+        if (modifier != DRM_FORMAT_MOD_INVALID) {
+            *a++ = plane_attr[i][3], *a++ = (EGLint)(modifier & 0xFFFFFFFF);
+            *a++ = plane_attr[i][4], *a++ = (EGLint)(modifier >> 32);
+        }
+#endif
+    }
+
+    *a = EGL_NONE;
+
+    /* ...create EGL image (no context needed for dma-buf import) */
+    if ((image = eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, attr)) == EGL_NO_IMAGE_KHR) {
+        TRACE(ERROR, _x("dma-buf import failed (fd=%d): %X"), fd[0], eglGetError());
+        return __texture_create_memory(w, h, data, stride, format);
+    }
+
+    /* ...allocate texture data */
+    if ((texture = malloc(sizeof (*texture))) == NULL) {
+        eglDestroyImageKHR(dpy, image);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    /* ...save planes buffers pointers (may be absent for pure dma-buf) */
+    (data ? memcpy(texture->data, data, sizeof (texture->data)) : memset(texture->data, 0, sizeof (texture->data)));
+    texture->size[0] = __pixfmt_image_size(w, h, format);
+    texture->pdata = image;
+    texture->upload = NULL;
+
+    /* ...allocate texture and bind it to the image */
+    if ((r = resource_call(display, __texture_create_image, texture)) < 0) {
+        TRACE(ERROR, _x("dma-buf #%d: texture creation failed: %d"), fd[0], r);
+        eglDestroyImageKHR(dpy, image);
+        free(texture);
+        return __texture_create_memory(w, h, data, stride, format);
+    }
+
+    TRACE(INFO, _b("dma-buf #%d: image=%p, tex=%u, fourcc=%.4s"), fd[0], image, texture->tex, (char *)&fourcc);
+
+    return texture;
+}
+
+/*******************************************************************************
+ * Camera planes (compositor-presented buffers)
+ ******************************************************************************/
+
+#ifdef DISPLAY_PLANE_ENABLED
+/* ...compositor buffer wrapping DMA buffer */
+struct plane_buffer {
+    /* ...Wayland buffer handle */
+    struct wl_buffer *buffer;
+
+    /* ...buffer creation status (positive - created, negative - rejected) */
+    int status;
+
+    /* ...release notification of currently presented buffer */
+    void (*release)(void *cookie);
+    void *cookie;
+};
+
+/* ...buffer is not used by compositor anymore (display dispatch thread) */
+static void plane_buffer_release(void *data, struct wl_buffer *wl_buffer) {
+    plane_buffer_t *buffer = data;
+    void (*release)(void *) = buffer->release;
+
+    TRACE(DEBUG, _b("plane buffer %p released"), buffer);
+
+    buffer->release = NULL;
+
+    if (release) {
+        release(buffer->cookie);
+    }
+}
+
+static const struct wl_buffer_listener plane_buffer_listener = {
+    plane_buffer_release,
+};
+
+/* ...buffer is imported by compositor (private queue of creating thread) */
+static void plane_params_created(void *data, struct zwp_linux_buffer_params_v1 *params, struct wl_buffer *wl_buffer) {
+    plane_buffer_t *buffer = data;
+
+    buffer->buffer = wl_buffer, buffer->status = 1;
+}
+
+/* ...compositor failed to import buffer */
+static void plane_params_failed(void *data, struct zwp_linux_buffer_params_v1 *params) {
+    plane_buffer_t *buffer = data;
+
+    buffer->status = -1;
+}
+
+static const struct zwp_linux_buffer_params_v1_listener plane_params_listener = {
+    plane_params_created,
+    plane_params_failed,
+};
+
+/* ...wrap DMA buffer into compositor buffer */
+plane_buffer_t * plane_buffer_create(int w, int h, int *fd, int *stride, int *offset, u64 modifier, int format) {
+    display_data_t *display = &__display;
+    struct zwp_linux_buffer_params_v1 *params;
+    struct wl_event_queue *queue;
+    plane_buffer_t *buffer;
+    u32 fourcc;
+    int i, n;
+
+    /* ...compositor must advertise both format and layout modifier of the buffer */
+    if (!display->dmabuf || !display->viewporter || !fd || fd[0] < 0) {
+        errno = ENOTSUP;
+        return NULL;
+    } else if ((fourcc = __pixfmt_gst_to_drm(format, &n)) == 0 || !display_dmabuf_format(display, fourcc, modifier)) {
+        TRACE(INFO, _b("format %d (modifier %llX) is not supported by compositor"), format, (unsigned long long)modifier);
+        errno = ENOTSUP;
+        return NULL;
+    }
+
+    CHK_ERR(buffer = calloc(1, sizeof (*buffer)), (errno = ENOMEM, NULL));
+
+    /* ...creation result is delivered to the private queue of calling thread */
+    CHK_ERR(queue = wl_display_create_queue(display->display), (free(buffer), errno = ENOMEM, NULL));
+    params = zwp_linux_dmabuf_v1_create_params(display->dmabuf);
+    wl_proxy_set_queue((struct wl_proxy *)params, queue);
+    zwp_linux_buffer_params_v1_add_listener(params, &plane_params_listener, buffer);
+
+    /* ...planes layout is the same as for texture import */
+    for (i = 0; i < n; i++) {
+        int pfd, poffset, pitch;
+
+        __dmabuf_plane_layout(w, h, fd, stride, offset, format, i, &pfd, &poffset, &pitch);
+
+        zwp_linux_buffer_params_v1_add(params, pfd, i, poffset, pitch, (u32)(modifier >> 32), (u32)(modifier & 0xFFFFFFFF));
+    }
+
+    /* ...wait for compositor verdict; rejected buffers are drawn with GL */
+    zwp_linux_buffer_params_v1_create(params, w, h, fourcc, 0);
+
+    while (buffer->status == 0) {
+        if (wl_display_dispatch_queue(display->display, queue) < 0) break;
+    }
+
+    zwp_linux_buffer_params_v1_destroy(params);
+
+    if (buffer->status <= 0) {
+        TRACE(INFO, _b("dma-buf #%d: compositor import failed"), fd[0]);
+        wl_event_queue_destroy(queue);
+        free(buffer);
+        errno = ENOTSUP;
+        return NULL;
+    }
+
+    /* ...release events are processed by display dispatch thread */
+    wl_proxy_set_queue((struct wl_proxy *)buffer->buffer, NULL);
+    wl_event_queue_destroy(queue);
+    wl_buffer_add_listener(buffer->buffer, &plane_buffer_listener, buffer);
+
+    TRACE(INFO, _b("plane buffer %p: dma-buf #%d, %d*%d, fourcc=%.4s"), buffer, fd[0], w, h, (char *)&fourcc);
+
+    return buffer;
+}
+
+/* ...destroy compositor buffer (must not be presented) */
+void plane_buffer_destroy(plane_buffer_t *buffer) {
+    wl_buffer_destroy(buffer->buffer);
+    free(buffer);
+}
+
+/* ...create plane subsurface below window surface */
+static int window_plane_init(window_data_t *window) {
+    display_data_t *display = window->display;
+    const window_info_t *info = window->info;
+    struct wl_region *region;
+
+    /* ...plane requires Wayland surface scaling; rotated windows are not supported */
+    if (!window->surface || !display->subcompositor || !display->viewporter) {
+        return -(errno = ENOTSUP);
+    } else if (info->fullscreen && info->transform) {
+        TRACE(INFO, _b("window[%p]: camera plane is not available for rotated window"), window);
+        return -(errno = ENOTSUP);
+    }
+
+    window->plane_surface = wl_compositor_create_surface(display->compositor);
+    window->plane_sub = wl_subcompositor_get_subsurface(display->subcompositor, window->plane_surface, window->surface);
+    window->plane_viewport = wp_viewporter_get_viewport(display->viewporter, window->plane_surface);
+
+    /* ...plane is shown through transparent window areas; input goes to window */
+    wl_subsurface_place_below(window->plane_sub, window->surface);
+    region = wl_compositor_create_region(display->compositor);
+    wl_surface_set_input_region(window->plane_surface, region);
+    wl_region_destroy(region);
+
+    /* ...window surface is not opaque anymore (applied with next buffer swap) */
+    wl_surface_set_opaque_region(window->surface, NULL);
+
+    TRACE(INIT, _b("window[%p]: camera plane created"), window);
+
+    return 0;
+}
+
+/* ...present buffer on window plane at given rectangle (render thread) */
+int window_plane_present(window_data_t *window, plane_buffer_t *buffer, int x, int y, int w, int h, void (*release)(void *), void *cookie) {
+    /* ...create plane on first use */
+    if (!window->plane_surface) {
+        CHK_API(window_plane_init(window));
+    }
+
+    /* ...update destination rectangle as needed */
+    if (x != window->plane_x || y != window->plane_y) {
+        wl_subsurface_set_position(window->plane_sub, x, y);
+        window->plane_x = x, window->plane_y = y;
+    }
+
+    if (w != window->plane_w || h != window->plane_h) {
+        wp_viewport_set_destination(window->plane_viewport, w, h);
+        window->plane_w = w, window->plane_h = h;
+    }
+
+    /* ...buffer is returned through release callback once compositor is done with it */
+    buffer->release = release, buffer->cookie = cookie;
+    wl_surface_attach(window->plane_surface, buffer->buffer, 0, 0);
+    wl_surface_damage(window->plane_surface, 0, 0, w, h);
+
+    /* ...subsurface is synchronized; state is applied along with window buffer swap */
+    wl_surface_commit(window->plane_surface);
+    window->plane_attached = 1;
+
+    return 0;
+}
+
+/* ...detach buffer from window plane (render thread) */
+void window_plane_hide(window_data_t *window) {
+    if (!window->plane_attached) return;
+
+    wl_surface_attach(window->plane_surface, NULL, 0, 0);
+    wl_surface_commit(window->plane_surface);
+
+    /* ...apply cached subsurface state without waiting for next frame */
+    wl_surface_commit(window->surface);
+    wl_display_flush(window->display->display);
+
+    window->plane_attached = 0;
+
+    TRACE(DEBUG, _b("window[%p]: camera plane hidden"), window);
+}
+#else
+/* ...camera planes require linux-dmabuf and viewporter protocols */
+plane_buffer_t * plane_buffer_create(int w, int h, int *fd, int *stride, int *offset, u64 modifier, int format) {
+    errno = ENOTSUP;
+    return NULL;
+}
+
+void plane_buffer_destroy(plane_buffer_t *buffer) {
+}
+
+int window_plane_present(window_data_t *window, plane_buffer_t *buffer, int x, int y, int w, int h, void (*release)(void *), void *cookie) {
+    return -(errno = ENOTSUP);
+}
+
+void window_plane_hide(window_data_t *window) {
+}
+#endif
+
+
+#ifdef ENABLE_OBJDET
+/* ...texture mapping command arguments */
+typedef struct texture_map_cmd {
+    texture_data_t *texture;
+    cl_mem_flags flags;
+    cl_mem buf;
+
+} texture_map_cmd_t;
+
+/* ...create CL buffer from texture image (resource context) */
+static int __texture_map(display_data_t *display, void *arg) {
+    texture_map_cmd_t *cmd = arg;
+    texture_data_t *texture = cmd->texture;
+    cl_int r;
+
+    //buf = clCreateBufferFromEGLImageKHR(display->cl.ctx, display->egl.dpy, texture->pdata, flags, NULL, &r);
+    cmd->buf = _clCreateFromEGLImageKHR(display->cl.ctx, display->egl.dpy, texture->pdata, cmd->flags, NULL, &r);
+    //buf = clCreateBuffer(display->cl.ctx, CL_MEM_USE_HOST_PTR, texture->size[0], texture->data[0], &r);
+
+    TRACE(1, _b("mapped buffer %p (image: %p, data: %p, size: %u): %d"), cmd->buf, texture->pdata, texture->data[0], texture->size[0], r);
+
+    return 0;
+}
+
+/* ...map texture data */
+cl_mem texture_map(texture_data_t *texture, cl_mem_flags flags) {
+    texture_map_cmd_t cmd = { .texture = texture, .flags = flags, .buf = NULL };
+
+    /* ...EGL context is needed to assure the image is accessible */
+    resource_call(&__display, __texture_map, &cmd);
+
+    return cmd.buf;
+}
+
+/* ...unmap CL-buffer */
+void texture_unmap(cl_mem buf) {
+    cl_int r;
+
+    /* ...set current CL context - tbd - do I need that at all? */
+    r = clReleaseMemObject(buf);
+
+    TRACE(DEBUG, _b("buffer %p released: %d"), buf, r);
+}
+#endif
+
+/* ...destroy texture objects (resource or current context) */
+static int __texture_destroy(display_data_t *display, void *arg) {
+    texture_data_t *texture = arg;
+
+    /* ...destroy textures */
+    glDeleteTextures(1, &texture->tex);
+
+    /* ...destroy EGL image */
+    eglDestroyImageKHR(display->egl.dpy, texture->pdata);
+
+    /* ...destroy copy-upload planes and render target */
+    if (texture->upload) {
+        glDeleteTextures(TEXTURE_UPLOAD_PLANES, texture->upload->planes);
+        glDeleteTextures(1, &texture->upload->target);
+        free(texture->upload);
+    }
+
+    /* ...deleted names may be reused; do not trust shadowed bindings */
+    gl_state_deleted();
+
+    /* ...destroy texture structure */
+    free(texture);
+
+    return 0;
+}
+
+/* ...destroy texture data (caller does not wait for completion) */
+void texture_destroy(texture_data_t *texture) {
+    resource_post(&__display, __texture_destroy, texture);
+}
+
+/*******************************************************************************
+ * VBO support
+ ******************************************************************************/
+
+/* ...VBO creation command arguments */
+typedef struct vbo_create_cmd {
+    vbo_data_t *vbo;
+    u32 v_size, v_number, i_size, i_number;
+
+} vbo_create_cmd_t;
+
+/* ...GL usage hint for a streaming mode */
+static inline GLenum __vbo_usage(vbo_data_t *vbo) {
+    return (vbo->mode == VBO_MODE_SINGLE ? GL_STREAM_DRAW : GL_DYNAMIC_DRAW);
+}
+
+/* ...create VBO objects (resource context) */
+static int __vbo_create(display_data_t *display, void *arg) {
+    vbo_create_cmd_t *cmd = arg;
+    vbo_data_t *vbo = cmd->vbo;
+    u32 v_size = cmd->v_size, v_number = cmd->v_number;
+    u32 i_size = cmd->i_size, i_number = cmd->i_number;
+    GLenum error;
+    u32 t0, t1, t2;
+
+    /* ...bindings are modified directly; drop shadowed state if in window context */
+    gl_state_forget(GL_STATE_ARRAY_BUFFER | GL_STATE_ELEMENT_BUFFER);
+
+    t0 = __get_cpu_cycles();
+
+    /* ...generate buffer-object */
+    glGenBuffers(1, &vbo->vbo);
+    if ((error = glGetError()) != GL_NO_ERROR) {
+        TRACE(ERROR, _x("failed to create VBO: %X"), error);
+        return -ENOMEM;
+    }
+
+    /* ...allocate vertex buffer memory (all ring segments) */
+    glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
+    glBufferData(GL_ARRAY_BUFFER, vbo->v_segment * vbo->segments, NULL, __vbo_usage(vbo));
+    error = glGetError();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (error != GL_NO_ERROR) {
+        TRACE(ERROR, _x("failed to allocate VBO memory (%u * %u): %X"), v_size, v_number, error);
+        goto error_vbo;
+    }
+
+    t1 = __get_cpu_cycles();
+
+    /* ...allocate index buffer object */
+    glGenBuffers(1, &vbo->ibo);
+    if ((error = glGetError()) != GL_NO_ERROR) {
+        TRACE(ERROR, _x("failed to allocate IBO: %X"), error);
+        goto error_vbo;
+    }
+
+    /* ...allocate indices buffer memory */
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, vbo->i_segment * vbo->segments, NULL, __vbo_usage(vbo));
+    error = glGetError();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (error != GL_NO_ERROR) {
+        TRACE(ERROR, _x("failed to allocate IBO memory (%u * %u): %X"), i_size, i_number, error);
+        goto error_ibo;
+    }
+
+    t2 = __get_cpu_cycles();
+
+    /* ...do we need to set any parameters here? guess no */
+    TRACE(DEBUG, _b("VBO=%u(%u*%u)/IBO=%u(%u*%u) allocated[%p] (%u / %u)"), vbo->vbo, v_size, v_number, vbo->ibo, i_size, i_number, vbo, t1 - t0, t2 - t1);
+
+    return 0;
+
+error_ibo:
+    /* ...destroy index buffer object (deallocate memory as needed) */
+    glDeleteBuffers(1, &vbo->ibo);
+
+error_vbo:
+    /* ...destroy buffer object (deallocate memory as needed) */
+    glDeleteBuffers(1, &vbo->vbo);
+
+    return -ENOMEM;
+}
+
+/* ...create streaming VBO with given number of segments (GL objects are created by resource thread) */
+vbo_data_t * vbo_ring_create(u32 v_size, u32 v_number, u32 i_size, u32 i_number, u32 segments) {
+    display_data_t *display = &__display;
+    vbo_create_cmd_t cmd = { .v_size = v_size, .v_number = v_number, .i_size = i_size, .i_number = i_number };
+    vbo_data_t *vbo;
+    int r;
+
+    /* ...allocate VBO handle */
+    CHK_ERR(cmd.vbo = vbo = calloc(1, sizeof (*vbo)), (errno = ENOMEM, NULL));
+
+    vbo->v_segment = v_size * v_number;
+    vbo->i_segment = i_size * i_number;
+
+    /* ...select streaming mode; ring needs unsynchronized range mapping */
+    if (segments <= 1) {
+        vbo->mode = VBO_MODE_SINGLE, vbo->segments = 1;
+    } else if (!(display->gl_ext & DISPLAY_GL_EXT_MAP_BUFFER_RANGE)) {
+        TRACE(INIT, _b("range mapping not supported; use buffer orphaning"));
+        vbo->mode = VBO_MODE_ORPHAN, vbo->segments = 1;
+    } else if ((vbo->fence = calloc(segments, sizeof (*vbo->fence))) == NULL) {
+        free(vbo);
+        errno = ENOMEM;
+        return NULL;
+    } else {
+        vbo->mode = VBO_MODE_RING, vbo->segments = segments;
+    }
+
+    /* ...first mapping selects segment #0 */
+    vbo->segment = vbo->segments - 1;
+
+    if ((r = resource_call(display, __vbo_create, &cmd)) < 0) {
+        /* ...destroy data handle */
+        free(vbo->fence);
+        free(vbo);
+        errno = -r;
+        return NULL;
+    }
+
+    return vbo;
+}
+
+/* ...create VBO object */
+vbo_data_t * vbo_create(u32 v_size, u32 v_number, u32 i_size, u32 i_number) {
+    return vbo_ring_create(v_size, v_number, i_size, i_number, 1);
+}
+
+/* ...VBO mapping command arguments */
+typedef struct vbo_map_cmd {
+    vbo_data_t *vbo;
+    int buffer, index;
+
+} vbo_map_cmd_t;
+
+/* ...wait until GPU has finished reading a ring segment */
+static void __vbo_segment_wait(display_data_t *display, vbo_data_t *vbo, u32 segment) {
+    EGLSyncKHR sync = vbo->fence[segment];
+
+    if (sync == EGL_NO_SYNC_KHR) {
+        return;
+    }
+
+    /* ...normally the fence has long been signalled; count real waits */
+    if (eglClientWaitSyncKHR(display->egl.dpy, sync, 0, 0) == EGL_TIMEOUT_EXPIRED_KHR) {
+        vbo->stalls++;
+        eglClientWaitSyncKHR(display->egl.dpy, sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+    }
+
+    eglDestroySyncKHR(display->egl.dpy, sync);
+    vbo->fence[segment] = EGL_NO_SYNC_KHR;
+}
+
+/* ...map buffer for writing according to streaming mode */
+static void * __vbo_map_buffer(vbo_data_t *vbo, GLenum target, u32 size, u32 offset) {
+    switch (vbo->mode) {
+    case VBO_MODE_RING:
+        /* ...segment is not used by GPU anymore; no need for driver synchronization */
+        return glMapBufferRangeEXT(target, offset, size, GL_MAP_WRITE_BIT_EXT | GL_MAP_INVALIDATE_RANGE_BIT_EXT | GL_MAP_UNSYNCHRONIZED_BIT_EXT);
+
+    case VBO_MODE_ORPHAN:
+        /* ...detach storage that may still be in use and get a fresh one */
+        glBufferData(target, size, NULL, GL_DYNAMIC_DRAW);
+        return glMapBufferOES(target, GL_WRITE_ONLY_OES);
+
+    default:
+        return glMapBufferOES(target, GL_WRITE_ONLY_OES);
+    }
+}
+
+/* ...map VBO buffers (resource or current context) */
+static int __vbo_map(display_data_t *display, void *arg) {
+    vbo_map_cmd_t *cmd = arg;
+    vbo_data_t *vbo = cmd->vbo;
+    int buffer = cmd->buffer, index = cmd->index;
+    u32 t0, t1, t2;
+    GLenum err;
+
+    /* ...advance to the next ring segment */
+    if (vbo->mode == VBO_MODE_RING) {
+        vbo->segment = (vbo->segment + 1) % vbo->segments;
+        __vbo_segment_wait(display, vbo, vbo->segment);
+    }
+
+    vbo->v_offset = vbo->segment * vbo->v_segment;
+    vbo->i_offset = vbo->segment * vbo->i_segment;
+
+    t0 = __get_cpu_cycles();
+
+    /* ...map vertex buffer if requested (error is queried only if mapping fails) */
+    if (buffer) {
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo->vbo);
+        vbo->buffer = __vbo_map_buffer(vbo, GL_ARRAY_BUFFER, vbo->v_segment, vbo->v_offset);
+        BUG(!vbo->buffer && (err = glGetError()) != GL_NO_ERROR, _x("error=%X (vbo=%u)"), err, vbo->vbo);
+    }
+
+    t1 = __get_cpu_cycles();
+
+    /* ...map index buffer if requested */
+    if (index) {
+        gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, vbo->ibo);
+        vbo->index = __vbo_map_buffer(vbo, GL_ELEMENT_ARRAY_BUFFER, vbo->i_segment, vbo->i_offset);
+        BUG(!vbo->index && (err = glGetError()) != GL_NO_ERROR, _x("error=%X (ibo=%u)"), err, vbo->ibo);
+    }
+
+    t2 = __get_cpu_cycles();
+
+    TRACE(DEBUG, _b("VBO[%u]/IBO[%u] mapped: %p/%p (%u/%u)"), vbo->vbo, vbo->ibo, vbo->buffer, vbo->index, t1 - t0, t2 - t1);
+
+    return 0;
+}
+
+/* ...get writable data pointer to the VBO */
+int vbo_map(vbo_data_t *vbo, int buffer, int index) {
+    vbo_map_cmd_t cmd = { .vbo = vbo, .buffer = buffer, .index = index };
+
+    return resource_call(&__display, __vbo_map, &cmd);
+}
+
+/* ...unmap VBO buffers (resource or current context) */
+static int __vbo_unmap(display_data_t *display, void *arg) {
+    vbo_data_t *vbo = arg;
+    u32 t0, t1, t2;
+
+    t0 = __get_cpu_cycles();
+
+    /* ...unmap buffer array if needed */
+    if (vbo->buffer) {
+        gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo->vbo);
+        glUnmapBufferOES(GL_ARRAY_BUFFER);
+        vbo->buffer = NULL;
+    }
+
+    t1 = __get_cpu_cycles();
 
-    /* ...destroy EGL surface */
-    eglDestroySurface(display->egl.dpy, window->egl);
+    /* ...unmap index array if needed */
+    if (vbo->index) {
+        gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, vbo->ibo);
+        glUnmapBufferOES(GL_ELEMENT_ARRAY_BUFFER);
+        vbo->index = NULL;
+    }
 
-    /* ...destroy native window */
-    wl_egl_window_destroy(window->native);
+    t2 = __get_cpu_cycles();
 
-    /* ...destroy shell surface */
-    wl_shell_surface_destroy(window->shell);
+    TRACE(DEBUG, _b("VBO[%u]/IBO[%u] unmapped (%u/%u)"), vbo->vbo, vbo->ibo, t1 - t0, t2 - t1);
 
-    /* ....destroy wayland surface (shell surface gets destroyed automatically) */
-    wl_surface_destroy(window->surface);
+    return 0;
+}
 
-    /* ...make sure function is complete before we actually proceed */
-    if (1 && (callback = wl_display_sync(display->display)) != NULL) {
-        pthread_mutex_t wait_lock = PTHREAD_MUTEX_INITIALIZER;
+/* ...unmap buffer data */
+void vbo_unmap(vbo_data_t *vbo) {
+    resource_call(&__display, __vbo_unmap, vbo);
+}
 
-        pthread_mutex_lock(&wait_lock);
-        wl_callback_add_listener(callback, &__destroy_listener, &wait_lock);
+/* ...visualize VBO segment as an array of points */
+void vbo_draw_segment(vbo_data_t *vbo, u32 segment, int offset, int stride, int number, GLfloat *pvm) {
+    display_data_t *display = &__display;
+    gl_shader_t *shader = &display->shader_vbo;
+    GLint cprog = 0;
 
-        wl_display_flush(display->display);
+    TRACE(DEBUG, _b("draw vbo: %u"), vbo->vbo);
 
-        /* ...mutex will be released in callback function executed from display thread context */
-        pthread_mutex_lock(&wait_lock);
+    /* ...caller program is remembered by the tracker; query it if context is not tracked */
+    if (!__gl_state) {
+        glGetIntegerv(GL_CURRENT_PROGRAM, &cprog);
     }
 
-    /* ...destroy window lock */
-    pthread_mutex_destroy(&window->lock);
+    /* ...set current precompiled shader (cairo program is restored on demand) */
+    gl_state_use_program(shader->program);
 
-    /* ...destroy rendering thread conditional variable */
-    pthread_cond_destroy(&window->wait);
+    /* ...prepare shader uniforms */
+    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, (pvm ? : __gl_identity));
 
-    /* ...destroy object */
-    free(window);
+    /* ...prepare shader uniforms */
+    glUniform1f(shader->width_uniform, 5.0);
 
-    TRACE(INFO, _b("window[%p] destroyed"), window);
-}
+    /* ...bind VBO */
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo->vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *) (intptr_t) (segment * vbo->v_segment + offset));
 
-/* ...return current window width */
-int window_get_width(window_data_t *window) {
-    return window->widget.width;
-}
+    /* ...draw VBOs in current viewport */
+    glDrawArrays(GL_POINTS, 0, number);
 
-/* ...return current window height */
-int window_get_height(window_data_t *window) {
-    return window->widget.height;
-}
+    /* ...cleanup GL state; caller may draw from client arrays with its own program */
+    glDisableVertexAttribArray(0);
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
 
-widget_data_t *window_get_widget(window_data_t *window) {
-    return &window->widget;
-}
+    if (__gl_state) {
+        gl_state_enter_cairo(__gl_state);
+    } else {
+        glUseProgram((GLuint)cprog);
+    }
 
-const window_info_t *window_get_info(window_data_t *window) {
-    return window->info;
+    /* ...segment may be rewritten only when GPU has finished reading it */
+    if (vbo->mode == VBO_MODE_RING) {
+        (vbo->fence[segment] != EGL_NO_SYNC_KHR ? eglDestroySyncKHR(display->egl.dpy, vbo->fence[segment]) : 0);
+        vbo->fence[segment] = eglCreateSyncKHR(display->egl.dpy, EGL_SYNC_FENCE_KHR, NULL);
+    }
 }
 
-cairo_device_t * window_get_cairo_device(window_data_t *window) {
-    return window->cairo;
+/* ...visualize most recently mapped VBO segment as an array of points */
+void vbo_draw(vbo_data_t *vbo, int offset, int stride, int number, GLfloat *pvm) {
+    vbo_draw_segment(vbo, vbo->segment, offset, stride, number, pvm);
 }
 
-cairo_matrix_t * window_get_cmatrix(window_data_t *window) {
-    return &window->cmatrix;
-}
+/* ...destroy VBO objects (resource or current context) */
+static int __vbo_destroy(display_data_t *display, void *arg) {
+    vbo_data_t *vbo = arg;
+    u32 i;
 
-/* ...schedule redrawal of the window */
-void window_schedule_redraw(window_data_t *window) {
-    /* ...acquire window lock */
-    pthread_mutex_lock(&window->lock);
+    /* ...destroy ring fences (buffer deletion is deferred by GL if still in use) */
+    for (i = 0; vbo->fence && i < vbo->segments; i++) {
+        (vbo->fence[i] != EGL_NO_SYNC_KHR ? eglDestroySyncKHR(display->egl.dpy, vbo->fence[i]) : 0);
+    }
 
-    /* ...check if we don't have a flag already */
-    if ((window->flags & WINDOW_FLAG_REDRAW) == 0) {
-        /* ...set a flag */
-        window->flags |= WINDOW_FLAG_REDRAW;
+    /* ...delete buffer-object */
+    glDeleteBuffers(1, &vbo->vbo);
 
-        /* ...and kick processing thread */
-        pthread_cond_signal(&window->wait);
+    /* ...delete index-buffer object */
+    glDeleteBuffers(1, &vbo->ibo);
 
-        TRACE(DEBUG, _b("schedule window[%p] redraw"), window);
-    }
+    /* ...deleted names may be reused; do not trust shadowed bindings */
+    gl_state_deleted();
 
-    /* ...release window access lock */
-    pthread_mutex_unlock(&window->lock);
+    /* ...allocate memory (do not pass any data yet) */
+    TRACE(INIT, _b("VBO[%u]/IBO[%u] object destroyed (%u stalls)"), vbo->vbo, vbo->ibo, vbo->stalls);
+
+    /* ...destroy VBO handle */
+    free(vbo->fence);
+    free(vbo);
+
+    return 0;
 }
 
-void window_reinit_bv(window_data_t *window) {
-    /* ...acquire window lock */
-    
-    TRACE(INIT, _b("window[%p]: surround view bv reinitialize"), window);
-    pthread_mutex_lock(&window->lock);
+/* ...destroy buffer-object (caller does not wait for completion) */
+void vbo_destroy(vbo_data_t *vbo) {
+    resource_post(&__display, __vbo_destroy, vbo);
+}
 
-    /* ...check if we don't have a flag already */
-    if ((window->flags & WINDOW_BV_REINIT) == 0) {
-        /* ...set a flag */
-        window->flags |= WINDOW_BV_REINIT;
+/*******************************************************************************
+ * Glyph-atlas text rendering
+ ******************************************************************************/
 
-        /* ...and kick processing thread */
-        pthread_cond_signal(&window->wait);
+/* ...range of rasterized characters (printable ASCII) */
+#define TEXT_GLYPH_FIRST                32
+#define TEXT_GLYPH_LAST                 126
 
-        TRACE(DEBUG, _b("window[%p]: surround view bv reinitialize"), window);
-    }
+/* ...atlas width (height depends on font size) */
+#define TEXT_ATLAS_WIDTH                512
 
-    /* ...release window access lock */
-    pthread_mutex_unlock(&window->lock);
-}
+/* ...solid cell in the upper-left corner of the atlas (boxes drawing) */
+#define TEXT_ATLAS_SOLID                4
 
-/* ...submit window to a renderer */
-void window_draw(window_data_t *window) {
-    u32 t0, t1;
+/* ...number of floats per vertex: position, texture coordinates, color */
+#define TEXT_VERTEX_SIZE                8
 
-    t0 = __get_cpu_cycles();
+/* ...single glyph data */
+typedef struct text_glyph {
+    /* ...atlas texture coordinates */
+    GLfloat u0, v0, u1, v1;
 
-    /* ...swap buffers (finalize any pending 2D-drawing) */
-    cairo_gl_surface_swapbuffers(window->widget.cs);
+    /* ...glyph box offset from pen position on a baseline, and dimensions */
+    GLfloat x, y, w, h;
 
-    /* ...make sure everything is correct */
-    BUG(cairo_surface_status(window->widget.cs) != CAIRO_STATUS_SUCCESS, _x("bad status: %s"), cairo_status_to_string(cairo_surface_status(window->widget.cs)));
+    /* ...pen advance */
+    GLfloat advance;
 
-    t1 = __get_cpu_cycles();
+} text_glyph_t;
 
-    TRACE(DEBUG, _b("swap[%p]: %u (error=%X)"), window, t1 - t0, eglGetError());
-}
+/* ...rasterized font */
+struct text_font {
+    /* ...atlas texture (alpha) */
+    GLuint tex;
 
-/* ...retrieve associated cairo surface */
-cairo_t * window_get_cairo(window_data_t *window) {
-    cairo_t *cr;
+    /* ...atlas dimensions and image data (valid until upload) */
+    int w, h;
+    const u8 *data;
 
-    /* ...it is a bug if we lost a context */
-    BUG(eglGetCurrentContext() != window->user_egl_ctx, _x("invalid GL context"));
+    /* ...line height */
+    int height;
 
-    /* ...restore original cairo program */
-    glUseProgram(window->cprog);
+    /* ...texture coordinates of solid cell center */
+    GLfloat su, sv;
 
-    /* ...create new drawing context */
-    cr = cairo_create(window->widget.cs);
+    /* ...glyphs map */
+    text_glyph_t glyph[TEXT_GLYPH_LAST - TEXT_GLYPH_FIRST + 1];
+};
 
-    /* ...set transformation matrix */
-    cairo_set_matrix(cr, &window->cmatrix);
+/* ...text batch (quads accumulated on CPU, drawn with a single call) */
+struct text_batch {
+    /* ...font used for glyphs */
+    text_font_t *font;
 
-    /* ...make it a bug for a moment */
-    BUG(cairo_status(cr) != CAIRO_STATUS_SUCCESS, _x("invalid status: (%d) - %s"), cairo_status(cr), cairo_status_to_string(cairo_status(cr)));
+    /* ...vertex data, capacity and number of quads */
+    GLfloat *v;
+    int size, num;
+};
 
-    return cr;
+/* ...upload atlas into texture (resource or current context) */
+static int __text_font_upload(display_data_t *display, void *arg) {
+    text_font_t *font = arg;
+
+    glGenTextures(1, &font->tex);
+    glBindTexture(GL_TEXTURE_2D, font->tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, font->w, font->h, 0, GL_ALPHA, GL_UNSIGNED_BYTE, font->data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return (glGetError() == GL_NO_ERROR ? 0 : -ENOMEM);
 }
 
-/* ...release associated cairo surface */
-void window_put_cairo(window_data_t *window, cairo_t *cr) {
-    /* ...destroy cairo drawing interface */
-    cairo_destroy(cr);
+/* ...delete atlas texture (resource or current context) */
+static int __text_font_delete(display_data_t *display, void *arg) {
+    text_font_t *font = arg;
 
-    /* ...re-acquire window GL context */
-    eglMakeCurrent(window->display->egl.dpy, window->egl, window->egl, window->user_egl_ctx);
+    glDeleteTextures(1, &font->tex);
+    gl_state_deleted();
 
-    /* ...save cairo program */
-    glGetIntegerv(GL_CURRENT_PROGRAM, &window->cprog);
+    return 0;
 }
 
-/*******************************************************************************
- * Display module initialization
- ******************************************************************************/
-
-/* ...create display data */
-display_data_t * display_create(void) {
+/* ...rasterize printable characters of a font into an atlas texture */
+text_font_t * text_font_create(const char *face, int size) {
     display_data_t *display = &__display;
-    pthread_attr_t attr;
-    int r;
+    cairo_font_extents_t fe;
+    cairo_text_extents_t te;
+    cairo_surface_t *cs;
+    cairo_t *cr;
+    text_font_t *font;
+    char str[2] = { 0, 0 };
+    int c, x, y, row, r;
+
+    CHK_ERR(font = calloc(1, sizeof (*font)), (errno = ENOMEM, NULL));
+
+    /* ...measure glyphs with a scratch context and pack them in rows */
+    cs = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+    cr = cairo_create(cs);
+    cairo_select_font_face(cr, face, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, size);
+    cairo_font_extents(cr, &fe);
+    font->height = (int)ceil(fe.height);
+
+    for (c = TEXT_GLYPH_FIRST, x = TEXT_ATLAS_SOLID + 1, y = 1, row = TEXT_ATLAS_SOLID; c <= TEXT_GLYPH_LAST; c++) {
+        text_glyph_t *g = &font->glyph[c - TEXT_GLYPH_FIRST];
+        int w, h;
+
+        str[0] = (char)c;
+        cairo_text_extents(cr, str, &te);
+        w = (int)ceil(te.width) + 1, h = (int)ceil(te.height) + 1;
+
+        /* ...start new row if glyph does not fit */
+        if (x + w + 1 > TEXT_ATLAS_WIDTH) {
+            x = 1, y += row + 1, row = 0;
+        }
 
-    /* ...reset display data */
-    memset(display, 0, sizeof (*display));
+        g->x = (GLfloat)floor(te.x_bearing), g->y = (GLfloat)floor(te.y_bearing);
+        g->w = w, g->h = h, g->advance = te.x_advance;
+        g->u0 = x, g->v0 = y, g->u1 = x + w, g->v1 = y + h;
 
-    /* ...connect to Wayland display */
-    if ((display->display = wl_display_connect(NULL)) == NULL) {
-        TRACE(ERROR, _x("failed to connect to Wayland: %m"));
-        errno = EBADFD;
-        goto error;
-    } else if ((display->registry = wl_display_get_registry(display->display)) == NULL) {
-        TRACE(ERROR, _x("failed to get registry: %m"));
-        errno = EBADFD;
-        goto error_disp;
-    } else {
-        /* ...set global registry listener */
-        wl_registry_add_listener(display->registry, &registry_listener, display);
+        x += w + 1, (h > row ? row = h : 0);
     }
 
-    /* ...initialize inputs/outputs lists */
-    wl_list_init(&display->outputs);
-    wl_list_init(&display->inputs);
+    cairo_destroy(cr);
+    cairo_surface_destroy(cs);
 
-    /* ...initialize windows list */
-    wl_list_init(&display->windows);
+    font->w = TEXT_ATLAS_WIDTH, font->h = y + row + 1;
 
-    /* ...create a display command/response lock */
-    pthread_mutex_init(&display->lock, NULL);
+    /* ...render glyphs into atlas image; stride equals width for A8 format of that width */
+    cs = cairo_image_surface_create(CAIRO_FORMAT_A8, font->w, font->h);
+    cr = cairo_create(cs);
+    cairo_rectangle(cr, 0, 0, TEXT_ATLAS_SOLID, TEXT_ATLAS_SOLID);
+    cairo_fill(cr);
+    cairo_select_font_face(cr, face, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, size);
 
-    /* ...create polling structure */
-    if ((display->efd = epoll_create(DISPLAY_EVENTS_NUM)) < 0) {
-        TRACE(ERROR, _x("failed to create epoll: %m"));
-        goto error_disp;
-    }
+    for (c = TEXT_GLYPH_FIRST; c <= TEXT_GLYPH_LAST; c++) {
+        text_glyph_t *g = &font->glyph[c - TEXT_GLYPH_FIRST];
 
-    /* ...pre-initialize global Wayland interfaces */
-    do {
-        display->pending = 0, wl_display_roundtrip(display->display);
-    } while (display->pending);
+        str[0] = (char)c;
+        cairo_move_to(cr, g->u0 - g->x, g->v0 - g->y);
+        cairo_show_text(cr, str);
 
-    /* ...initialize EGL */
-    if (init_egl(display) < 0) {
-        TRACE(ERROR, _x("EGL initialization failed: %m"));
-        goto error_disp;
+        /* ...convert pixel positions into texture coordinates */
+        g->u0 /= font->w, g->u1 /= font->w, g->v0 /= font->h, g->v1 /= font->h;
     }
 
-    /* ...make current display context */
-    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, display->egl.ctx);
-
-    /* ...dump available GL extensions */
-    TRACE(INIT, _b("GL version: %s"), (char *) glGetString(GL_VERSION));
-    TRACE(INIT, _b("GL extension: %s"), (char *) glGetString(GL_EXTENSIONS));
+    cairo_destroy(cr);
+    cairo_surface_flush(cs);
 
-    /* ...compile default shaders */
-    if (compile_shaders(display) < 0) {
-        TRACE(ERROR, _x("default shaders compilation failed"));
-        goto error_egl;
-    }
+    font->su = (GLfloat)(TEXT_ATLAS_SOLID / 2) / font->w, font->sv = (GLfloat)(TEXT_ATLAS_SOLID / 2) / font->h;
 
-    /* ...release display EGL context */
-    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    /* ...create texture in a context sharing objects with windows */
+    font->data = cairo_image_surface_get_data(cs);
+    r = resource_call(display, __text_font_upload, font);
+    font->data = NULL;
+    cairo_surface_destroy(cs);
 
-#ifdef ENABLE_OBJDET
-    /* ...initialize global CL-context */
-    if (init_cl(display) < 0) {
-        TRACE(ERROR, _x("failed to initialize CL context"));
-        goto error_egl;
+    if (r < 0) {
+        TRACE(ERROR, _x("failed to upload font atlas: %d"), r);
+        free(font);
+        errno = -r;
+        return NULL;
     }
-#endif
-    
-    /* ...initialize thread attributes (joinable, default stack size) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
-    /* ...create Wayland dispatch thread */
-    r = pthread_create(&display->thread, &attr, dispatch_thread, display);
-    pthread_attr_destroy(&attr);
-    if (r != 0) {
-        TRACE(ERROR, _x("thread creation failed: %m"));
-#ifdef ENABLE_OBJDET
-        goto error_cl;
-#else
-        goto error_egl;
-#endif
-    }
+    TRACE(INIT, _b("font '%s' (%d) rasterized: atlas %d*%d, tex=%u"), face, size, font->w, font->h, font->tex);
 
-    /* ...wait until display thread starts? */
-    TRACE(INIT, _b("Wayland display interface initialized"));
+    return font;
+}
 
-#ifdef SPACENAV_ENABLED
-    /* ...initialize extra input devices */
-    input_spacenav_init(display);
+/* ...destroy font */
+void text_font_destroy(text_font_t *font) {
+    resource_call(&__display, __text_font_delete, font);
+    free(font);
+}
 
-    /* ...joystick device requires start-up events generation (should be window-specific) */
-    input_joystick_init(display, joystick_dev_name);
-#endif
+/* ...get font line height */
+int text_font_height(text_font_t *font) {
+    return font->height;
+}
 
-    /* ...doesn't look good, actually - don't want to start thread right here */
-    return display;
+/* ...create text batch for a given number of quads */
+text_batch_t * text_batch_create(text_font_t *font, int size) {
+    text_batch_t *batch;
 
-#ifdef ENABLE_OBJDET
-error_cl:
-    /* ...destroy CL context */
-    fini_cl(display);
-#endif
+    CHK_ERR(batch = malloc(sizeof (*batch)), (errno = ENOMEM, NULL));
+    CHK_ERR(batch->v = malloc(size * 6 * TEXT_VERTEX_SIZE * sizeof (GLfloat)), (free(batch), errno = ENOMEM, NULL));
 
-error_egl:
-    /* ...destroy EGL context */
-    fini_egl(display);
+    batch->font = font, batch->size = size, batch->num = 0;
 
-error_disp:
-    /* ...disconnect display */
-    wl_display_flush(display->display);
-    wl_display_disconnect(display->display);
+    return batch;
+}
 
-error:
-    return NULL;
+/* ...destroy text batch */
+void text_batch_destroy(text_batch_t *batch) {
+    free(batch->v);
+    free(batch);
 }
 
-/*******************************************************************************
- * Textures handling
- ******************************************************************************/
+/* ...discard accumulated quads */
+void text_batch_reset(text_batch_t *batch) {
+    batch->num = 0;
+}
 
-/* ...draw external texture in given view-port */
-void texture_draw(texture_data_t *texture, texture_view_t *view, texture_crop_t *crop, GLfloat alpha) {
-    display_data_t *display = &__display;
-    gl_shader_t *shader = &display->shader_ext;
-    GLint saved_program = 0;
-
-    /* ...identity matrix - not needed really */
-    static const GLfloat identity[4 * 4] = {
-        1, 0, 0, 0,
-        0, 1, 0, 0,
-        0, 0, 1, 0,
-        0, 0, 0, 1,
+/* ...add a textured quad with premultiplied color */
+static inline int __text_batch_quad(text_batch_t *batch, GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1,
+                                    GLfloat u0, GLfloat v0, GLfloat u1, GLfloat v1, u32 color) {
+    GLfloat a = (color & 0xFF) / 255.0f;
+    GLfloat r = (color >> 24) / 255.0f * a, g = ((color >> 16) & 0xFF) / 255.0f * a, b = ((color >> 8) & 0xFF) / 255.0f * a;
+    const GLfloat q[6][4] = {
+        { x0, y0, u0, v0 }, { x1, y0, u1, v0 }, { x0, y1, u0, v1 },
+        { x0, y1, u0, v1 }, { x1, y0, u1, v0 }, { x1, y1, u1, v1 },
     };
+    GLfloat *p;
+    int i;
 
-    /* ...vertices coordinates */
-    static const GLfloat verts[] = {
-        -1, -1,
-        1, -1,
-        -1, 1,
-        -1, 1,
-        1, -1,
-        1, 1,
-    };
+    /* ...silently drop quads exceeding batch capacity */
+    if (batch->num == batch->size) return -ENOSPC;
 
-    /* ...triangle coordinates */
-    static const GLfloat texcoords[] = {
-        0, 1,
-        1, 1,
-        0, 0,
-        0, 0,
-        1, 1,
-        1, 0,
-    };
+    for (p = batch->v + batch->num++ * 6 * TEXT_VERTEX_SIZE, i = 0; i < 6; i++) {
+        *p++ = q[i][0], *p++ = q[i][1], *p++ = q[i][2], *p++ = q[i][3];
+        *p++ = r, *p++ = g, *p++ = b, *p++ = a;
+    }
 
-    if (view) {
-        int i;
-        GLfloat *p = *view;
+    return 0;
+}
 
-        for (i = 0; i < 12; i += 2, p += 2) {
-            TRACE(0, _b("view[%d] = (%.2f, %.2f)"), i / 2, p[0], p[1]);
+/* ...add formatted (multi-line) string; pen starts at (x, y) on a baseline; returns maximal line width */
+int text_batch_printf(text_batch_t *batch, int x, int y, u32 color, const char *fmt, ...) {
+    text_font_t *font = batch->font;
+    char buffer[256], *s;
+    GLfloat px = x, py = y, w = 0;
+    va_list argp;
+
+    va_start(argp, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, argp);
+    va_end(argp);
+
+    for (s = buffer; *s; s++) {
+        int c = (u8)*s;
+        text_glyph_t *g;
+
+        if (c == '\n') {
+            (px - x > w ? w = px - x : 0);
+            px = x, py += font->height;
+            continue;
         }
-    }
 
-    if (crop) {
-        int i;
-        GLfloat *p = *crop;
+        /* ...characters out of atlas range are drawn as blanks */
+        g = &font->glyph[(c >= TEXT_GLYPH_FIRST && c <= TEXT_GLYPH_LAST ? c : ' ') - TEXT_GLYPH_FIRST];
 
-        for (i = 0; i < 12; i += 2, p += 2) {
-            TRACE(0, _b("crop[%d] = (%.2f, %.2f)"), i / 2, p[0], p[1]);
+        if (c != ' ') {
+            __text_batch_quad(batch, px + g->x, py + g->y, px + g->x + g->w, py + g->y + g->h, g->u0, g->v0, g->u1, g->v1, color);
         }
+
+        px += g->advance;
     }
 
-    /* ...save current program (possible used by cairo) */
-    glGetIntegerv(GL_CURRENT_PROGRAM, &saved_program);
+    (px - x > w ? w = px - x : 0);
 
-    /* ...set current precompiled shader */
-    glUseProgram(shader->program);
+    return (int)ceil(w);
+}
 
-    /* ...prepare shader uniforms */
-    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, identity);
+/* ...add solid rectangle */
+void text_batch_box(text_batch_t *batch, int x, int y, int w, int h, u32 color) {
+    text_font_t *font = batch->font;
+
+    __text_batch_quad(batch, x, y, x + w, y + h, font->su, font->sv, font->su, font->sv, color);
+}
+
+/* ...projection mapping viewport pixels into normalized device coordinates of (rotated) buffer */
+static void __viewport_proj(window_data_t *window, GLfloat *proj) {
+    const cairo_matrix_t *m = &window->cmatrix;
+    GLfloat W = window_get_width(window), H = window_get_height(window);
+
+    memset(proj, 0, 4 * 4 * sizeof(GLfloat));
+    proj[0] = 2 * m->xx / W, proj[1] = -2 * m->yx / H;
+    proj[4] = 2 * m->xy / W, proj[5] = -2 * m->yy / H;
+    proj[10] = 1;
+    proj[12] = 2 * m->x0 / W - 1, proj[13] = 1 - 2 * m->y0 / H, proj[15] = 1;
+}
+
+/* ...draw accumulated quads in a window (cairo context is flushed first, if given) */
+void text_batch_draw(text_batch_t *batch, window_data_t *window, cairo_t *cr) {
+    gl_shader_t *shader = &window->display->shader_text;
+    GLfloat proj[4 * 4];
+
+    if (batch->num == 0) return;
+
+    /* ...submit pending cairo drawing; it has modified GL state */
+    if (cr) {
+        cairo_surface_flush(cairo_get_target(cr));
+        gl_state_leave_cairo(&window->gl);
+    }
+
+    __viewport_proj(window, proj);
+
+    /* ...set current precompiled shader */
+    gl_state_use_program(shader->program);
+    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, proj);
     glUniform1i(shader->tex_uniforms[0], 0);
-    glUniform1f(shader->alpha_uniform, alpha);
 
-    /* ...bind textures */
+    /* ...bind atlas texture */
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture->tex);
+    glBindTexture(GL_TEXTURE_2D, batch->font->tex);
 
-    /* ...set vertices array attribute */
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (view ? *view : verts));
+    /* ...vertices are passed in client arrays */
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, TEXT_VERTEX_SIZE * sizeof(GLfloat), batch->v);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, TEXT_VERTEX_SIZE * sizeof(GLfloat), batch->v + 2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, TEXT_VERTEX_SIZE * sizeof(GLfloat), batch->v + 4);
     glEnableVertexAttribArray(0);
-
-    /* ...set vertex coordinates attribute */
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (crop ? *crop : texcoords));
     glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
 
-    /* ...render triangles on the surface */
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    /* ...draw all quads with a single call */
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, batch->num * 6);
 
-    /* ...disable generic attributes arrays */
+    /* ...cleanup GL state */
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
+    glDisableVertexAttribArray(2);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    /* ...unbind texture */
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
-
-    /* ...restore active program */
-    glUseProgram(saved_program);
-}
-
-#define EGL_NATIVE_PIXFORMAT_NV16_REL 12
-
-/* ...translate V4L2 pixel-format into EGL-format */
-static inline int __pixfmt_gst_to_egl(int format) {
-    switch (format) {
-        case GST_VIDEO_FORMAT_NV12: return EGL_NATIVE_PIXFORMAT_NV12_REL;
-        case GST_VIDEO_FORMAT_UYVY: return EGL_NATIVE_PIXFORMAT_UYVY_REL;
-        case GST_VIDEO_FORMAT_NV16: return EGL_NATIVE_PIXFORMAT_NV16_REL;
-        default: return TRACE(ERROR, _x("unsupported format: %d"), format), -1;
+    /* ...hand context back to cairo */
+    if (cr) {
+        gl_state_enter_cairo(&window->gl);
     }
 }
 
-/* ...texture creation (in shared display context) */
-texture_data_t * texture_create(int w, int h, void **data, int format) {
-    display_data_t *display = &__display;
-    EGLDisplay dpy = display->egl.dpy;
-    EGLNativePixmapTypeREL pixmap;
-    texture_data_t *texture;
-    EGLImageKHR image;
+/*******************************************************************************
+ * Overlay primitives batching
+ ******************************************************************************/
 
-    /* ...map format to the internal value */
-    CHK_ERR(pixmap.format = __pixfmt_gst_to_egl(format), (errno = EINVAL, NULL));
+/* ...number of floats per vertex: position, color */
+#define OVERLAY_VERTEX_SIZE             6
 
-    /* ...allocate texture data */
-    CHK_ERR(texture = malloc(sizeof (*texture)), (errno = ENOMEM, NULL));
+/* ...overlay primitives recorded as a triangles stream */
+struct overlay {
+    /* ...vertex data, capacity and number of vertices */
+    GLfloat *v;
+    int size, num;
 
-    /* ...get shared display EGL context */
-    display_egl_ctx_get(display);
+    /* ...user-to-viewport coordinates transformation */
+    cairo_matrix_t matrix;
 
-    /* ...allocate texture */
-    glGenTextures(1, &texture->tex);
+    /* ...primitives dropped due to lack of space */
+    u32 dropped;
+};
 
-    /* ...save planes buffers pointers */
-    memcpy(texture->data, data, sizeof (texture->data));
-    texture->size[0] = __pixfmt_image_size(w, h, format);
+/* ...create overlay stream holding up to "size" vertices */
+overlay_t * overlay_create(int size) {
+    overlay_t *overlay;
 
-    /* ...create EGL surface for a pixmap */
-    pixmap.width = w;
-    pixmap.height = h;
-    pixmap.stride = w;
-    pixmap.usage = 0;
-    pixmap.pixelData = texture->data[0];
-    texture->pdata = image = eglCreateImageKHR(dpy, NULL, EGL_NATIVE_PIXMAP_KHR, &pixmap, NULL);
-
-    /* ...bind texture to the output device */
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture->tex);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, image);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    TRACE(INFO, _b("plane #0: image=%p, tex=%u, data=%p"), image, texture->tex, texture->data[0]);
+    CHK_ERR(overlay = malloc(sizeof (*overlay)), (errno = ENOMEM, NULL));
+    CHK_ERR(overlay->v = malloc(size * OVERLAY_VERTEX_SIZE * sizeof (GLfloat)), (free(overlay), errno = ENOMEM, NULL));
 
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+    overlay->size = size, overlay->num = 0, overlay->dropped = 0;
+    cairo_matrix_init_identity(&overlay->matrix);
 
-    /* ...release shared display context */
-    display_egl_ctx_put(display);
+    return overlay;
+}
 
-    return texture;
+/* ...destroy overlay stream */
+void overlay_destroy(overlay_t *overlay) {
+    free(overlay->v);
+    free(overlay);
 }
 
+/* ...start new frame; transformation is reset to identity */
+void overlay_reset(overlay_t *overlay) {
+    if (overlay->dropped) {
+        TRACE(DEBUG, _b("overlay[%p]: %u primitives dropped"), overlay, overlay->dropped);
+    }
 
-#ifdef ENABLE_OBJDET
-/* ...map texture data */
-cl_mem texture_map(texture_data_t *texture, cl_mem_flags flags) {
-    display_data_t *display = &__display;
-    cl_mem buf;
-    cl_int r;
+    overlay->num = 0, overlay->dropped = 0;
+    cairo_matrix_init_identity(&overlay->matrix);
+}
 
-    /* ...get EGL context? - we need to assure the image is accessible */
-    display_egl_ctx_get(display);
+/* ...set transformation applied to subsequently recorded coordinates */
+void overlay_set_matrix(overlay_t *overlay, const cairo_matrix_t *matrix) {
+    overlay->matrix = *matrix;
+}
 
-    //buf = clCreateBufferFromEGLImageKHR(display->cl.ctx, display->egl.dpy, texture->pdata, flags, NULL, &r);
-    buf = _clCreateFromEGLImageKHR(display->cl.ctx, display->egl.dpy, texture->pdata, flags, NULL, &r);
-    //buf = clCreateBuffer(display->cl.ctx, CL_MEM_USE_HOST_PTR, texture->size[0], texture->data[0], &r);
+/* ...reserve space for "n" vertices; returns NULL if stream is full */
+static inline GLfloat * __overlay_reserve(overlay_t *overlay, int n) {
+    GLfloat *p;
 
-    TRACE(1, _b("mapped buffer %p (image: %p, data: %p, size: %u): %d"), buf, texture->pdata, texture->data[0], texture->size[0], r);
+    if (overlay->num + n > overlay->size) {
+        overlay->dropped++;
+        return NULL;
+    }
 
-    display_egl_ctx_put(display);
+    p = overlay->v + overlay->num * OVERLAY_VERTEX_SIZE, overlay->num += n;
 
-    return buf;
+    return p;
 }
 
-/* ...unmap CL-buffer */
-void texture_unmap(cl_mem buf) {
-    cl_int r;
-
-    /* ...set current CL context - tbd - do I need that at all? */
-    r = clReleaseMemObject(buf);
+/* ...output single vertex with premultiplied color */
+static inline GLfloat * __overlay_vertex(GLfloat *p, GLfloat x, GLfloat y, const GLfloat *c) {
+    *p++ = x, *p++ = y;
+    *p++ = c[0], *p++ = c[1], *p++ = c[2], *p++ = c[3];
 
-    TRACE(DEBUG, _b("buffer %p released: %d"), buf, r);
+    return p;
 }
-#endif
 
-/* ...destroy texture data */
-void texture_destroy(texture_data_t *texture) {
-    display_data_t *display = &__display;
-    EGLContext ctx = eglGetCurrentContext();
+/* ...convert 0xRRGGBBAA color into premultiplied components */
+static inline void __overlay_color(u32 color, GLfloat *c) {
+    GLfloat a = (color & 0xFF) / 255.0f;
 
-    /* ...get display shared context */
-    (ctx == EGL_NO_CONTEXT ? display_egl_ctx_get(display) : 0);
+    c[0] = (color >> 24) / 255.0f * a, c[1] = ((color >> 16) & 0xFF) / 255.0f * a;
+    c[2] = ((color >> 8) & 0xFF) / 255.0f * a, c[3] = a;
+}
 
-    /* ...destroy textures */
-    glDeleteTextures(1, &texture->tex);
+/* ...add segment between transformed points as a quad of given width */
+static inline void __overlay_segment(overlay_t *overlay, double x0, double y0, double x1, double y1, GLfloat width, const GLfloat *c) {
+    double dx = x1 - x0, dy = y1 - y0, l = sqrt(dx * dx + dy * dy);
+    GLfloat nx, ny, *p;
 
-    /* ...destroy EGL image */
-    eglDestroyImageKHR(display->egl.dpy, texture->pdata);
+    if (l == 0 || (p = __overlay_reserve(overlay, 6)) == NULL) return;
 
-    /* ...release shared display context */
-    (ctx == EGL_NO_CONTEXT ? display_egl_ctx_put(display) : 0);
+    /* ...half-width normal of the segment */
+    nx = -dy / l * width / 2, ny = dx / l * width / 2;
 
-    /* ...destroy texture structure */
-    free(texture);
+    p = __overlay_vertex(p, x0 + nx, y0 + ny, c);
+    p = __overlay_vertex(p, x1 + nx, y1 + ny, c);
+    p = __overlay_vertex(p, x0 - nx, y0 - ny, c);
+    p = __overlay_vertex(p, x0 - nx, y0 - ny, c);
+    p = __overlay_vertex(p, x1 + nx, y1 + ny, c);
+    __overlay_vertex(p, x1 - nx, y1 - ny, c);
 }
 
-/*******************************************************************************
- * VBO support
- ******************************************************************************/
-
-/* ...create VBO object in shared display context */
-vbo_data_t * vbo_create(u32 v_size, u32 v_number, u32 i_size, u32 i_number) {
-    display_data_t *display = &__display;
-    vbo_data_t *vbo;
-    GLenum error;
-    u32 t0, t1, t2;
+/* ...add straight line; width is in viewport pixels */
+void overlay_line(overlay_t *overlay, float x0, float y0, float x1, float y1, float width, u32 color) {
+    double u0 = x0, v0 = y0, u1 = x1, v1 = y1;
+    GLfloat c[4];
 
-    /* ...allocate VBO handle */
-    CHK_ERR(vbo = malloc(sizeof (*vbo)), (errno = ENOMEM, NULL));
+    __overlay_color(color, c);
+    cairo_matrix_transform_point(&overlay->matrix, &u0, &v0);
+    cairo_matrix_transform_point(&overlay->matrix, &u1, &v1);
+    __overlay_segment(overlay, u0, v0, u1, v1, width, c);
+}
 
-    /* ...get display shared context */
-    display_egl_ctx_get(display);
+/* ...add polyline of "n" points (interleaved x,y); segments are not joined */
+void overlay_polyline(overlay_t *overlay, const float *xy, int n, int closed, float width, u32 color) {
+    double x0, y0, x1, y1, xs, ys;
+    GLfloat c[4];
+    int i;
 
-    t0 = __get_cpu_cycles();
+    if (n < 2) return;
 
-    /* ...generate buffer-object */
-    glGenBuffers(1, &vbo->vbo);
-    if ((error = glGetError()) != GL_NO_ERROR) {
-        TRACE(ERROR, _x("failed to create VBO: %X"), error);
-        errno = ENOMEM;
-        goto error;
-    }
+    __overlay_color(color, c);
+    xs = xy[0], ys = xy[1];
+    cairo_matrix_transform_point(&overlay->matrix, &xs, &ys);
+    x0 = xs, y0 = ys;
 
-    /* ...allocate vertex buffer memory */
-    glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
-    glBufferData(GL_ARRAY_BUFFER, v_size * v_number, NULL, GL_STREAM_DRAW);
-    error = glGetError();
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    if (error != GL_NO_ERROR) {
-        TRACE(ERROR, _x("failed to allocate VBO memory (%u * %u): %X"), v_size, v_number, error);
-        errno = ENOMEM;
-        goto error_vbo;
+    for (i = 1; i < n; i++, x0 = x1, y0 = y1) {
+        x1 = xy[2 * i], y1 = xy[2 * i + 1];
+        cairo_matrix_transform_point(&overlay->matrix, &x1, &y1);
+        __overlay_segment(overlay, x0, y0, x1, y1, width, c);
     }
 
-    t1 = __get_cpu_cycles();
-
-    /* ...allocate index buffer object */
-    glGenBuffers(1, &vbo->ibo);
-    if ((error = glGetError()) != GL_NO_ERROR) {
-        TRACE(ERROR, _x("failed to allocate IBO: %X"), error);
-        errno = ENOMEM;
-        goto error_vbo;
+    if (closed) {
+        __overlay_segment(overlay, x0, y0, xs, ys, width, c);
     }
+}
 
-    /* ...allocate indices buffer memory */
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo->ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, i_size * i_number, NULL, GL_STREAM_DRAW);
-    error = glGetError();
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    if (error != GL_NO_ERROR) {
-        TRACE(ERROR, _x("failed to allocate IBO memory (%u * %u): %X"), i_size, i_number, error);
-        errno = ENOMEM;
-        goto error_ibo;
+/* ...add filled convex polygon of "n" points (interleaved x,y) */
+void overlay_polygon(overlay_t *overlay, const float *xy, int n, u32 color) {
+    double x[3], y[3];
+    GLfloat c[4], *p;
+    int i;
+
+    /* ...triangle fan is unrolled into triangles list */
+    if (n < 3 || (p = __overlay_reserve(overlay, 3 * (n - 2))) == NULL) return;
+
+    __overlay_color(color, c);
+    x[0] = xy[0], y[0] = xy[1];
+    x[1] = xy[2], y[1] = xy[3];
+    cairo_matrix_transform_point(&overlay->matrix, &x[0], &y[0]);
+    cairo_matrix_transform_point(&overlay->matrix, &x[1], &y[1]);
+
+    for (i = 2; i < n; i++, x[1] = x[2], y[1] = y[2]) {
+        x[2] = xy[2 * i], y[2] = xy[2 * i + 1];
+        cairo_matrix_transform_point(&overlay->matrix, &x[2], &y[2]);
+        p = __overlay_vertex(p, x[0], y[0], c);
+        p = __overlay_vertex(p, x[1], y[1], c);
+        p = __overlay_vertex(p, x[2], y[2], c);
     }
-
-    t2 = __get_cpu_cycles();
-
-    /* ...do we need to set any parameters here? guess no */
-    TRACE(DEBUG, _b("VBO=%u(%u*%u)/IBO=%u(%u*%u) allocated[%p] (%u / %u)"), vbo->vbo, v_size, v_number, vbo->ibo, i_size, i_number, vbo, t1 - t0, t2 - t1);
-
-    goto out;
-
-error_ibo:
-    /* ...destroy index buffer object (deallocate memory as needed) */
-    glDeleteBuffers(1, &vbo->ibo);
-
-error_vbo:
-    /* ...destroy buffer object (deallocate memory as needed) */
-    glDeleteBuffers(1, &vbo->vbo);
-
-error:
-    /* ...destroy data handle */
-    free(vbo), vbo = NULL;
-
-out:
-    /* ...release display context */
-    display_egl_ctx_put(display);
-
-    return vbo;
 }
 
-/* ...get writable data pointer to the VBO */
-int vbo_map(vbo_data_t *vbo, int buffer, int index) {
-    display_data_t *display = &__display;
-    EGLContext ctx = eglGetCurrentContext();
-    u32 t0, t1, t2;
-    GLenum err;
+/* ...add box; filled if width is zero, outlined otherwise */
+void overlay_box(overlay_t *overlay, float x, float y, float w, float h, float width, u32 color) {
+    const float xy[] = { x, y, x + w, y, x + w, y + h, x, y + h };
 
-    /* ...get display shared context */
-    (ctx == EGL_NO_CONTEXT ? display_egl_ctx_get(display) : 0);
+    if (width > 0) {
+        overlay_polyline(overlay, xy, 4, 1, width, color);
+    } else {
+        overlay_polygon(overlay, xy, 4, color);
+    }
+}
 
-    t0 = __get_cpu_cycles();
+/* ...draw recorded primitives with a single call (cairo context is flushed first, if given) */
+void overlay_draw(overlay_t *overlay, window_data_t *window, cairo_t *cr) {
+    gl_shader_t *shader = &window->display->shader_overlay;
+    GLfloat proj[4 * 4];
 
-    /* ...map vertex buffer if requested */
-    if (buffer) {
+    if (overlay->num == 0) return;
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
-        BUG((err = glGetError()) != GL_NO_ERROR, _x("error=%X (vbo=%u)"), err, vbo->vbo);
-        vbo->buffer = glMapBufferOES(GL_ARRAY_BUFFER, GL_WRITE_ONLY_OES);
-        BUG((err = glGetError()) != GL_NO_ERROR, _x("error=%X (vbo=%u)"), err, vbo->vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        BUG((err = glGetError()) != GL_NO_ERROR, _x("error=%X (vbo=%u)"), err, vbo->vbo);
+    /* ...submit pending cairo drawing; it has modified GL state */
+    if (cr) {
+        cairo_surface_flush(cairo_get_target(cr));
+        gl_state_leave_cairo(&window->gl);
     }
 
-    t1 = __get_cpu_cycles();
+    __viewport_proj(window, proj);
 
-    /* ...map index buffer if requested */
-    if (index) {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo->ibo);
-        BUG((err = glGetError()) != GL_NO_ERROR, _x("error=%X (ibo=%u)"), err, vbo->ibo);
-        vbo->index = glMapBufferOES(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY_OES);
-        BUG((err = glGetError()) != GL_NO_ERROR, _x("error=%X (ibo=%u)"), err, vbo->ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        BUG((err = glGetError()) != GL_NO_ERROR, _x("error=%X (ibo=%u)"), err, vbo->ibo);
-    }
+    /* ...set current precompiled shader */
+    gl_state_use_program(shader->program);
+    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, proj);
 
-    t2 = __get_cpu_cycles();
+    /* ...vertices are passed in client arrays */
+    gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, OVERLAY_VERTEX_SIZE * sizeof(GLfloat), overlay->v);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, OVERLAY_VERTEX_SIZE * sizeof(GLfloat), overlay->v + 2);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
 
-    /* ...release shared display context */
-    (ctx == EGL_NO_CONTEXT ? display_egl_ctx_put(display) : 0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, overlay->num);
 
-    TRACE(DEBUG, _b("VBO[%u]/IBO[%u] mapped: %p/%p (%u/%u)"), vbo->vbo, vbo->ibo, vbo->buffer, vbo->index, t1 - t0, t2 - t1);
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
 
-    return 0;
+    /* ...hand context back to cairo */
+    if (cr) {
+        gl_state_enter_cairo(&window->gl);
+    }
 }
 
-/* ...unmap buffer data */
-void vbo_unmap(vbo_data_t *vbo) {
-    display_data_t *display = &__display;
-    EGLContext ctx = eglGetCurrentContext();
-    u32 t0, t1, t2;
+/*******************************************************************************
+ * VBO streaming microbenchmark
+ ******************************************************************************/
 
-    /* ...get display shared context */
-    (ctx == EGL_NO_CONTEXT ? display_egl_ctx_get(display) : 0);
+/* ...benchmark configuration */
+typedef struct vbo_bench_cfg {
+    const char *name;
+    u32 number;
+    u32 segments;
 
-    t0 = __get_cpu_cycles();
+} vbo_bench_cfg_t;
 
-    /* ...unmap buffer array if needed */
-    if (vbo->buffer) {
-        glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
-        glUnmapBufferOES(GL_ARRAY_BUFFER);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        vbo->buffer = NULL;
-    }
+/* ...typical point-cloud and overlay sizes (vertex is three floats) */
+static const vbo_bench_cfg_t __vbo_bench_cfg[] = {
+    { "point-cloud", 65536, 1 },
+    { "point-cloud", 65536, 3 },
+    { "overlay", 1024, 1 },
+    { "overlay", 1024, 3 },
+};
 
-    t1 = __get_cpu_cycles();
+/* ...offscreen render target size */
+#define VBO_BENCH_SIZE                  256
 
-    /* ...unmap index array if needed */
-    if (vbo->index) {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo->ibo);
-        glUnmapBufferOES(GL_ELEMENT_ARRAY_BUFFER);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        vbo->index = NULL;
+/* ...run single configuration */
+static void __vbo_bench_run(const vbo_bench_cfg_t *cfg, int frames) {
+    u32 t0, t1, t2, t3, t4, t_map = 0, t_write = 0, t_unmap = 0, t_draw = 0;
+    vbo_data_t *vbo;
+    GLfloat *v;
+    u32 i;
+    int k;
+
+    if ((vbo = vbo_ring_create(3 * sizeof (GLfloat), cfg->number, sizeof (GLushort), 0, cfg->segments)) == NULL) {
+        TRACE(ERROR, _x("%s: failed to create VBO: %m"), cfg->name);
+        return;
     }
 
-    t2 = __get_cpu_cycles();
+    t0 = __get_time_usec();
 
-    /* ...release display context */
-    (ctx == EGL_NO_CONTEXT ? display_egl_ctx_put(display) : 0);
+    for (k = 0; k < frames; k++) {
+        t1 = __get_time_usec();
 
-    TRACE(DEBUG, _b("VBO[%u]/IBO[%u] unmapped (%u/%u)"), vbo->vbo, vbo->ibo, t1 - t0, t2 - t1);
-}
+        if (vbo_map(vbo, 1, 0) < 0 || (v = vbo->buffer) == NULL) {
+            TRACE(ERROR, _x("%s: mapping failed"), cfg->name);
+            break;
+        }
 
-/* ...visualize VBO as an array of points */
-void vbo_draw(vbo_data_t *vbo, int offset, int stride, int number, GLfloat *pvm) {
-    display_data_t *display = &__display;
-    gl_shader_t *shader = &display->shader_vbo;
-    GLint program = 0;
-
-    /* ...identity matrix - not needed really */
-    static const GLfloat __identity[4 * 4] = {
-        1, 0, 0, 0,
-        0, 1, 0, 0,
-        0, 0, 1, 0,
-        0, 0, 0, 1,
-    };
+        t2 = __get_time_usec();
 
-    /* ...save current program (possible used by cairo) */
-    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        /* ...fill points positions; all vertices are rewritten every frame */
+        for (i = 0; i < cfg->number; i++, v += 3) {
+            v[0] = (GLfloat)(i & 0xFF) / 128.0f - 1.0f;
+            v[1] = (GLfloat)((i >> 8) & 0xFF) / 128.0f - 1.0f;
+            v[2] = (GLfloat)k;
+        }
 
-    TRACE(DEBUG, _b("draw vbo: %u (%d)"), vbo->vbo, glIsBuffer(vbo->vbo));
+        t3 = __get_time_usec();
 
-    /* ...set current precompiled shader */
-    glUseProgram(shader->program);
+        vbo_unmap(vbo);
 
-    /* ...prepare shader uniforms */
-    glUniformMatrix4fv(shader->proj_uniform, 1, GL_FALSE, (pvm ? : __identity));
+        t4 = __get_time_usec();
 
-    /* ...prepare shader uniforms */
-    glUniform1f(shader->width_uniform, 5.0);
+        vbo_draw(vbo, 0, 0, cfg->number, NULL);
+        glFlush();
 
-    /* ...bind VBO */
-    glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *) (intptr_t) offset);
+        t_map += t2 - t1, t_write += t3 - t2, t_unmap += t4 - t3, t_draw += __get_time_usec() - t4;
+    }
 
-    /* ...draw VBOs in current viewport */
-    glDrawArrays(GL_POINTS, 0, number);
+    /* ...include GPU completion in total time */
+    glFinish();
+    t1 = __get_time_usec();
 
-    /* ...cleanup GL state */
-    glDisableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (k > 0) {
+        TRACE(INIT, _b("%s[%u points, %u segments, mode=%u]: map=%u, write=%u, unmap=%u, draw=%u, total=%u us/frame (%u stalls)"),
+              cfg->name, cfg->number, vbo->segments, vbo->mode, t_map / k, t_write / k, t_unmap / k, t_draw / k, (t1 - t0) / k, vbo->stalls);
+    }
 
-    /* ...restore original program */
-    glUseProgram(program);
+    vbo_destroy(vbo);
 }
 
-/* ...destroy buffer-object */
-void vbo_destroy(vbo_data_t *vbo) {
-    display_data_t *display = &__display;
+/* ...benchmark command (resource context) */
+static int __vbo_benchmark(display_data_t *display, void *arg) {
+    int frames = *(int *)arg;
+    GLuint fbo, rbo;
+    u32 i;
+
+    /* ...create offscreen render target */
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB565, VBO_BENCH_SIZE, VBO_BENCH_SIZE);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        TRACE(ERROR, _x("benchmark framebuffer is incomplete"));
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &rbo);
+        return -ENOTSUP;
+    }
 
-    /* ...get display shared context */
-    display_egl_ctx_get(display);
+    glViewport(0, 0, VBO_BENCH_SIZE, VBO_BENCH_SIZE);
 
-    /* ...delete buffer-object */
-    glDeleteBuffers(1, &vbo->vbo);
+    TRACE(INIT, _b("VBO benchmark: %d frames (map-buffer-range: %d)"), frames, !!(display->gl_ext & DISPLAY_GL_EXT_MAP_BUFFER_RANGE));
 
-    /* ...delete index-buffer object */
-    glDeleteBuffers(1, &vbo->ibo);
+    for (i = 0; i < sizeof (__vbo_bench_cfg) / sizeof (__vbo_bench_cfg[0]); i++) {
+        __vbo_bench_run(&__vbo_bench_cfg[i], frames);
+    }
 
-    /* ...allocate memory (do not pass any data yet) */
-    TRACE(INIT, _b("VBO[%u]/IBO[%u] object destroyed"), vbo->vbo, vbo->ibo);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &rbo);
 
-    /* ...release display context */
-    display_egl_ctx_put(display);
+    return 0;
+}
 
-    /* ...destroy VBO handle */
-    free(vbo);
+/* ...measure map/write/draw cost per frame for streaming VBOs */
+int vbo_benchmark(display_data_t *display, int frames) {
+    return resource_call(display, __vbo_benchmark, &frames);
 }
 
 /*******************************************************************************
@@ -1,7 +1,7 @@
 /*******************************************************************************
- * utest-display-wayland.h
+ * utest-display-x11.c
  *
- * Display support for X11 client
+ * X11 platform support for display module (desktop profiling)
  *
  * Copyright (c) 2015-2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
  *
@@ -24,347 +24,326 @@
  * THE SOFTWARE.
  *******************************************************************************/
 
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/epoll.h>
-#include <GL/gl.h>
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
-
-#include "utest.h"
-#include "utest-common.h"
-#include "utest-display.h"
-
-/* ...display data */
-struct display_data
-{
-    /*display handle */
-    Display* display;
 
-    /* ...pending display event status */
-    int                         pending;
+#define MODULE_TAG                      X11
 
-    /* ...polling structure handle */
-    int                         efd;
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
 
-    /* ...dispatch thread handle */
-    pthread_t                   thread;
+#include "utest.h"
+#include "utest-common.h"
+#include "utest-display-x11.h"
 
-    /* ...display lock (need that really? - tbd) */
-    pthread_mutex_t             lock;
-};
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
 
-/* ...output window data */
-struct window_data
-{
-	/*handle*/
-	Window window;
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
 
-    /* ...reference to a display data */
-    display_data_t             *display;
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
 
-    /* ...window information */
-    const window_info_t        *info;
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
 
-    /* ...client data for a callback */
-    void                       *cdata;
+/* ...wheel step reported as axis value (matches typical compositor scaling) */
+#define X11_AXIS_STEP                   10
 
-    /* ...current window size */
-    int                         width, height;
+/* ...X11 connection data */
+struct x11_display {
+    /* ...Xlib display handle */
+    Display *dpy;
 
-    /* ...command pipe */
-    int                         pipe[2];
+    /* ...context used for window lookup */
+    XContext context;
 
-    /* ...synchronous commands processing lock */
-    pthread_mutex_t             lock;
+    /* ...window manager protocol atoms */
+    Atom wm_delete, net_wm_state, net_wm_state_fullscreen;
 
-    /* ...conditional variable for synchronous commands processing */
-    pthread_cond_t              wait;
+    /* ...events processing lock (serializes window lookup against window destruction) */
+    pthread_mutex_t lock;
 
-    /* ...pending redraw flag */
-    int                         redraw;
+    /* ...window whose callback is running (callbacks are invoked without lock) */
+    x11_window_t *busy;
+    pthread_t busy_thread;
+    pthread_cond_t idle;
 };
 
-static display_data_t   __display;
+/* ...X11 window data */
+struct x11_window {
+    /* ...owning connection */
+    x11_display_t *x11;
 
-/* ...communication between application and display thread */
-typedef struct window_cmd
-{
-    /* ...user-supplied callback */
-    int           (*hook)(window_data_t *, void *);
-
-    /* ...callback-specific data */
-    void           *data;
-
-}   window_cmd_t;
+    /* ...window and its colormap */
+    Window window;
+    Colormap colormap;
 
+    /* ...input events callback */
+    x11_event_cb_t cb;
+    void *cdata;
+};
 
 /*******************************************************************************
- * Window internal functions
+ * Events translation
  ******************************************************************************/
 
-/* ...process window redraw command */
-static int __window_redraw(window_data_t *window, void *data)
-{
-    /* ...clear redraw event */
-    window->redraw = 0;
-
-    /* ...invoke user-supplied hook */
-    window->info->redraw(window->display, window->cdata);
-
-    return 0;
-}
-
-/* ...create EGL ARGB surface */
-window_data_t * window_create(display_data_t *display, const window_info_t *info, void *cdata)
-{
-    int                 width = info->width, height = info->height;
-    window_data_t      *window;
-
-    Display* dsp = display->display;
-
-    printf("create window\n");
-    /* ...allocate a window data */
-    if ((window = malloc(sizeof(*window))) == NULL)
-    {
-        return NULL;
+/* ...map X11 pointer button to evdev code */
+static inline u32 __x11_button(unsigned int button) {
+    switch (button) {
+        case Button1: return BTN_LEFT;
+        case Button2: return BTN_MIDDLE;
+        case Button3: return BTN_RIGHT;
+        default: return BTN_SIDE + button - 8;
     }
+}
 
-    memset(window, 0 , sizeof (window_data_t));
-
-    /* ...create window communication pipe */
-    if (pipe2(window->pipe, O_NONBLOCK) != 0)
-    {
-        goto error;
+/* ...translate X event into widget event; return 0 if event is not forwarded */
+static int x11_event_translate(XEvent *xe, widget_event_t *event) {
+    switch (xe->type) {
+        case EnterNotify:
+        case LeaveNotify:
+        case MotionNotify:
+            event->type = (xe->type == EnterNotify ? WIDGET_EVENT_MOUSE_ENTER : (xe->type == LeaveNotify ? WIDGET_EVENT_MOUSE_LEAVE : WIDGET_EVENT_MOUSE_MOVE));
+            event->mouse.x = (xe->type == MotionNotify ? xe->xmotion.x : xe->xcrossing.x);
+            event->mouse.y = (xe->type == MotionNotify ? xe->xmotion.y : xe->xcrossing.y);
+            return 1;
+
+        case ButtonPress:
+        case ButtonRelease:
+            event->mouse.x = xe->xbutton.x;
+            event->mouse.y = xe->xbutton.y;
+
+            /* ...buttons 4..7 are wheel steps reported on press only */
+            if (xe->xbutton.button >= Button4 && xe->xbutton.button <= 7) {
+                if (xe->type == ButtonRelease) return 0;
+                event->type = WIDGET_EVENT_MOUSE_AXIS;
+                event->mouse.axis = (xe->xbutton.button >= 6);
+                event->mouse.value = ((xe->xbutton.button & 1) ? X11_AXIS_STEP : -X11_AXIS_STEP);
+            } else {
+                event->type = WIDGET_EVENT_MOUSE_BUTTON;
+                event->mouse.button = __x11_button(xe->xbutton.button);
+                event->mouse.state = (xe->type == ButtonPress);
+            }
+            return 1;
+
+        case KeyPress:
+        case KeyRelease:
+            /* ...X keycodes are evdev codes shifted by 8 */
+            event->type = WIDGET_EVENT_KEY_PRESS;
+            event->key.code = xe->xkey.keycode - 8;
+            event->key.state = (xe->type == KeyPress);
+            return 1;
+
+        case FocusIn:
+            event->type = WIDGET_EVENT_KEY_ENTER;
+            return 1;
+
+        case FocusOut:
+            event->type = WIDGET_EVENT_KEY_LEAVE;
+            return 1;
+
+        default:
+            return 0;
     }
+}
 
-    /* ...create mutex and conditional variable for synchronous commands processing */
-    //pthread_cond_init(&window->wait, NULL);
-    //pthread_mutex_init(&window->lock, NULL);
+/* ...process pending X events */
+int x11_dispatch(x11_display_t *x11) {
+    Display *dpy = x11->dpy;
+    XEvent xe;
 
-    /* ...save display handle */
-    window->display = display;
+    pthread_mutex_lock(&x11->lock);
 
-    /* ...set current window parameters */
-    window->width = width, window->height = height;
+    while (XPending(dpy)) {
+        widget_event_t event;
+        x11_window_t *window;
+        XPointer ptr;
 
-    /* ...save window info data */
-    window->info = info, window->cdata = cdata;
+        XNextEvent(dpy, &xe);
 
-    /* ...clear redraw flag */
-    window->redraw = 0;
+        /* ...find window the event belongs to */
+        if (XFindContext(dpy, xe.xany.window, x11->context, &ptr) != 0) continue;
 
-    int screenNumber = DefaultScreen(dsp);
-    unsigned long white = WhitePixel(dsp,screenNumber);
-    unsigned long black = BlackPixel(dsp,screenNumber);
+        window = (x11_window_t *) ptr;
 
-    Window win = XCreateSimpleWindow(dsp,
-                                 DefaultRootWindow(dsp),
-                                 500, 500,   // origin
-                                 1280, 800, // size
-                                 0, black, // border
-                                 black );  // backgd
-    window->window = win;
+        /* ...close request is only logged; application lifetime is not managed here */
+        if (xe.type == ClientMessage && (Atom) xe.xclient.data.l[0] == x11->wm_delete) {
+            TRACE(INFO, _b("window[%p]: close request ignored"), window);
+            continue;
+        }
 
-    XMapWindow( dsp, win );
+        TRACE(DEBUG, _b("window[%p]: event %d"), window, xe.type);
 
-    long eventMask = StructureNotifyMask;
-    XSelectInput( dsp, win, eventMask );
+        if (window->cb && x11_event_translate(&xe, &event)) {
+            x11_event_cb_t cb = window->cb;
+            void *cdata = window->cdata;
 
-    XEvent evt;
-    do
-    {
-      XNextEvent( dsp, &evt );   // calls XFlush
+            /* ...callback may destroy windows; destruction waits until it returns */
+            x11->busy = window, x11->busy_thread = pthread_self();
+            pthread_mutex_unlock(&x11->lock);
+            cb(cdata, &event);
+            pthread_mutex_lock(&x11->lock);
+            x11->busy = NULL;
+            pthread_cond_broadcast(&x11->idle);
+        }
     }
-    while( evt.type != MapNotify );
 
-    GC gc = XCreateGC( dsp, win,
-                       0,        // mask of values
-                       NULL );   // array of values
-    XSetForeground( dsp, gc, black );
+    pthread_mutex_unlock(&x11->lock);
 
-    eventMask = ButtonPressMask|ButtonReleaseMask;
-    XSelectInput(dsp,win,eventMask); // override prev
-
-    return window;
-
-error:
-    /* ...destroy window memory */
-    free(window);
-    return NULL;
+    return 0;
 }
 
-/* ...destroy a window */
-void window_destroy(window_data_t *window)
-{
-    display_data_t     *display = window->display;
+/*******************************************************************************
+ * Windows handling
+ ******************************************************************************/
 
-    XDestroyWindow( display->display, window->window );
+/* ...create window with given visual */
+x11_window_t * x11_window_create(x11_display_t *x11, VisualID visual, const char *title, int fullscreen, x11_event_cb_t cb, void *cdata, int *width, int *height) {
+    Display *dpy = x11->dpy;
+    int screen = DefaultScreen(dpy);
+    Window root = RootWindow(dpy, screen);
+    XSetWindowAttributes attr;
+    XVisualInfo template, *vi;
+    x11_window_t *window;
+    int n, depth;
+
+    /* ...find visual matching EGL configuration */
+    template.visualid = visual;
+    if ((vi = XGetVisualInfo(dpy, VisualIDMask, &template, &n)) == NULL) {
+        TRACE(ERROR, _x("visual %lX not found"), (unsigned long) visual);
+        errno = ENODEV;
+        return NULL;
+    }
 
-    /* ...destroy object */
-    free(window);
-}
+    CHK_ERR(window = calloc(1, sizeof (*window)), (XFree(vi), errno = ENOMEM, NULL));
 
-/* ...return current window width */
-int window_get_width(window_data_t *window)
-{
-    return window->width;
-}
+    /* ...default to screen dimensions */
+    (!*width || fullscreen ? *width = DisplayWidth(dpy, screen) : 0);
+    (!*height || fullscreen ? *height = DisplayHeight(dpy, screen) : 0);
 
-/* ...return current window height */
-int window_get_height(window_data_t *window)
-{
-    return window->height;
-}
+    window->x11 = x11;
+    window->cb = cb, window->cdata = cdata;
+    window->colormap = XCreateColormap(dpy, root, vi->visual, AllocNone);
 
-/* ...schedule redrawal of the window */
-void window_schedule_redraw(window_data_t *window)
-{
-    /* ...emit redraw command to a dispatch loop */
-    pthread_mutex_lock(&window->lock);
+    /* ...border pixel and colormap are required for non-default visuals */
+    attr.colormap = window->colormap;
+    attr.border_pixel = 0;
+    attr.background_pixmap = None;
+    attr.event_mask = KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+                      PointerMotionMask | EnterWindowMask | LeaveWindowMask | FocusChangeMask | StructureNotifyMask;
 
-    /* ...send a command only if there is no pending event */
-    if (!window->redraw)
-    {
-        window->redraw = 1;
+    window->window = XCreateWindow(dpy, root, 0, 0, *width, *height, 0, vi->depth, InputOutput, vi->visual,
+                                   CWColormap | CWBorderPixel | CWBackPixmap | CWEventMask, &attr);
 
-        //__window_command(window, __window_redraw, window);
-        __window_redraw(window, NULL);
-    }
+    depth = vi->depth, XFree(vi);
 
-    pthread_mutex_unlock(&window->lock);
-}
+    /* ...register window for events lookup */
+    pthread_mutex_lock(&x11->lock);
+    XSaveContext(dpy, window->window, x11->context, (XPointer) window);
+    pthread_mutex_unlock(&x11->lock);
 
-/* ...submit window to a renderer */
-void window_draw(window_data_t *window)
-{
-    display_data_t     *display = window->display;
+    (title ? XStoreName(dpy, window->window, title) : 0);
+    XSetWMProtocols(dpy, window->window, &x11->wm_delete, 1);
 
+    /* ...ask window manager for fullscreen state before mapping (no-op without WM) */
+    if (fullscreen) {
+        XChangeProperty(dpy, window->window, x11->net_wm_state, XA_ATOM, 32, PropModeReplace,
+                        (unsigned char *) &x11->net_wm_state_fullscreen, 1);
+    }
 
-}
+    XMapWindow(dpy, window->window);
+    XFlush(dpy);
 
-/*******************************************************************************
- * Display module initialization
- ******************************************************************************/
+    TRACE(INIT, _b("window[%p]: X window %lX created (%d*%d, depth=%d)"), window, window->window, *width, *height, depth);
 
-/* ...create display data */
-display_data_t * display_create(void)
-{
-    display_data_t     *display = &__display;
-    pthread_attr_t      attr;
-    int                 r;
+    return window;
+}
 
-    /* ...reset display data */
-    memset(display, 0, sizeof(*display));
+/* ...destroy window */
+void x11_window_destroy(x11_window_t *window) {
+    x11_display_t *x11 = window->x11;
+    Display *dpy = x11->dpy;
 
-    XInitThreads();
+    /* ...make sure no events are delivered to the window anymore */
+    pthread_mutex_lock(&x11->lock);
+    XDeleteContext(dpy, window->window, x11->context);
 
-    /* ...connect to X server display */
-    display->display = XOpenDisplay(NULL);
-    if (display->display == NULL)
-    {
-        goto error;
+    /* ...wait for a callback running on another thread; window callback may destroy it as well */
+    while (x11->busy == window && !pthread_equal(x11->busy_thread, pthread_self())) {
+        pthread_cond_wait(&x11->idle, &x11->lock);
     }
 
-    /* ...initialize thread attributes (joinable, default stack size) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-    /* ...wait until display thread starts? */
-    TRACE(INIT, _b("X11 display interface initialized"));
+    pthread_mutex_unlock(&x11->lock);
 
-    return display;
+    XDestroyWindow(dpy, window->window);
+    XFreeColormap(dpy, window->colormap);
+    XFlush(dpy);
 
-error_epoll:
+    TRACE(INIT, _b("window[%p] destroyed"), window);
 
-error_disp:
+    free(window);
+}
 
-error:
-    return NULL;
+/* ...native window handle */
+Window x11_window_native(x11_window_t *window) {
+    return window->window;
 }
 
 /*******************************************************************************
- * Texture creation command
+ * Connection handling
  ******************************************************************************/
 
-/* ...command handle */
-typedef struct texture_create_cmd
-{
-    /* ...image size */
-    u16                 width, height;
-
-    /* ...planes memory */
-    void               *y, *uv;
-
-    /* ...pointer where texture should be stored */
-    texture_data_t    **out;
-
-}   texture_create_cmd_t;
+/* ...Xlib display handle */
+Display * x11_native_display(x11_display_t *x11) {
+    return x11->dpy;
+}
 
-static int __texture_create(window_data_t *window, void *data)
-{
-    texture_create_cmd_t   *cmd = data;
-    display_data_t         *display = window->display;
-    texture_data_t         *texture;
+/* ...connection file descriptor */
+int x11_fd(x11_display_t *x11) {
+    return ConnectionNumber(x11->dpy);
+}
 
-    printf("texture create\n");
+/* ...connect to X server */
+x11_display_t * x11_open(const char *name) {
+    x11_display_t *x11;
 
-    /* ...allocate texture data */
-    if ((texture = malloc(sizeof(*texture))) == NULL)
-    {
-        TRACE(ERROR, _x("failed to allocate memory"));
-        return -ENOMEM;
+    /* ...display is accessed from dispatch and rendering threads */
+    if (!XInitThreads()) {
+        TRACE(ERROR, _x("Xlib threads support is not available"));
+        errno = ENOTSUP;
+        return NULL;
     }
 
-    /* ...save texture context */
-    texture->window = window;
-
-    GLuint vtex;
-    int vtarget = GL_TEXTURE_2D;
-    glGenTextures(1, &vtex);
-    glBindTexture(vtarget, vtex);
-
-    glTexParameteri(vtarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(vtarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexParameteri(vtarget, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameteri(vtarget, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-    glTexImage2D(vtarget, 0, GL_RGBA, cmd->width, cmd->height, 0,
-    			GL_RGBA, GL_UNSIGNED_BYTE, cmd->y);
-    glBindTexture(vtarget, 0);
-
-    /* ...save texture in output pointer */
-    *cmd->out = texture;
-
-    return 0;
-}
+    CHK_ERR(x11 = calloc(1, sizeof (*x11)), (errno = ENOMEM, NULL));
 
-/* ...public API - display texture creation */
-texture_data_t * window_texture_create(window_data_t *window, int width, int height, void *y, void *uv)
-{
-    texture_data_t         *texture = NULL;
-    texture_create_cmd_t    cmd = { .width = width, .height = height, .y = y, .uv = uv, .out = &texture };
+    if ((x11->dpy = XOpenDisplay(name)) == NULL) {
+        TRACE(ERROR, _x("failed to open X display '%s'"), (name ? : getenv("DISPLAY") ? : ""));
+        free(x11);
+        errno = ENOENT;
+        return NULL;
+    }
 
-    /* ...issue a command to main display thread */
-    __texture_create(window, &cmd);
+    x11->context = XUniqueContext();
+    x11->wm_delete = XInternAtom(x11->dpy, "WM_DELETE_WINDOW", False);
+    x11->net_wm_state = XInternAtom(x11->dpy, "_NET_WM_STATE", False);
+    x11->net_wm_state_fullscreen = XInternAtom(x11->dpy, "_NET_WM_STATE_FULLSCREEN", False);
 
-    return texture;
-}
+    pthread_mutex_init(&x11->lock, NULL);
+    pthread_cond_init(&x11->idle, NULL);
 
-/* ...destroy texture data */
-void window_texture_destroy(window_data_t *window, texture_data_t *texture)
-{
+    TRACE(INIT, _b("X display '%s' opened (fd=%d)"), DisplayString(x11->dpy), ConnectionNumber(x11->dpy));
 
+    return x11;
 }
 
-/*******************************************************************************
- * Texture drawing helpers
- ******************************************************************************/
-
-/* ...output texture in current EGL context */
-int texture_draw(texture_data_t *texture, int x0, int y0, int x1, int y1)
-{
-
-    return 0;
+/* ...close X server connection */
+void x11_close(x11_display_t *x11) {
+    XCloseDisplay(x11->dpy);
+    pthread_cond_destroy(&x11->idle);
+    pthread_mutex_destroy(&x11->lock);
+    free(x11);
 }
@@ -36,6 +36,7 @@
 #include "utest-event.h"
 
 #include <cairo-gl.h>
+#include <GLES2/gl2.h>
 
 #include <math.h>
 
@@ -81,6 +82,9 @@ struct widget_data
 
     /* ...surface update request */
     int                         dirty;
+
+    /* ...layer rasterized off the render thread (NULL for root widget) */
+    struct widget_layer        *layer;
 };
 
 /*******************************************************************************
@@ -119,8 +123,8 @@ void widget_destroy(widget_data_t *widget) {
     /* ...invoke custom destructor function as needed */
     (info && info->destroy ? info->destroy(widget, widget->cdata) : 0);
 
-    /* ...destroy cairo surface */
-    cairo_surface_destroy(widget->cs);
+    /* ...destroy cairo surface and backing texture */
+    __widget_fini(widget);
 
     /* ...release data handle */
     free(widget);
@@ -176,6 +180,12 @@ void widget_schedule_redraw(widget_data_t *widget) {
     /* ...mark widget is dirty */
     widget->dirty = 1;
 
+    /* ...layered widget is rasterized in background; window is redrawn when layer is ready */
+    if (widget->layer) {
+        __widget_layer_schedule(widget);
+        return;
+    }
+
     /* ...schedule redrawing of the parent window */
     window_schedule_redraw(widget->window);
 }
@@ -262,7 +272,7 @@ static inline void window_set_transform_matrix(window_data_t *window, int *width
 /* ...get window viewport data */
 void window_get_viewport(window_data_t *window, int *w, int *h)
 {
-    switch(window_get_info(window)->transform)
+    switch(window_get_transform(window))
     {
     case 90:
     case 270:
@@ -276,7 +286,7 @@ void window_get_viewport(window_data_t *window, int *w, int *h)
         break;
         
     default:
-        BUG(1, _x("invalid transformation: %u"), window_get_info(window)->transform);
+        BUG(1, _x("invalid transformation: %u"), window_get_transform(window));
     }
 }
 
@@ -285,8 +295,15 @@ void window_translate_coordinates(window_data_t *window, int x, int y, int *X, i
 {
     int     w = window_get_width(window);
     int     h = window_get_height(window);
+    u32     t = window_get_info(window)->transform;
     
-    switch (window_get_info(window)->transform)
+    /* ...input is in surface coordinates; buffer rotated by compositor has swapped dimensions */
+    if (window_get_info(window)->fullscreen && window_get_transform(window) != t && (t == 90 || t == 270))
+    {
+        w = window_get_height(window), h = window_get_width(window);
+    }
+
+    switch (t)
     {
     case 0:
         *X = x, *Y = y;
@@ -391,7 +408,7 @@ void texture_set_view_scale(texture_view_t *vcoord, int x, int y, int w, int h,
 void texture_scale_to_window(texture_view_t *vcoord, window_data_t *window, int w, int h, cairo_matrix_t *m)
 {
     int     W, H;
-    u32     t =  window_get_info(window)->transform / 90;
+    u32     t =  window_get_transform(window) / 90;
     
     /* ...get effective window viewable area */
     window_get_viewport(window, &W, &H);    
@@ -440,6 +457,204 @@ void texture_set_crop(texture_crop_t *tcoord, float x0, float y0, float x1, floa
     *p++ = x1, *p++ = y0;
 }
 
+/*******************************************************************************
+ * Split-screen layouts
+ ******************************************************************************/
+
+/* ...scene on the left, camera previews stacked in the right quarter */
+static const layout_t __layout_quad = {
+    5,
+    {
+        {   0.00, 0.00, 0.75, 1.00, LAYOUT_SOURCE_SCENE },
+        {   0.75, 0.00, 0.25, 0.25, 0 },
+        {   0.75, 0.25, 0.25, 0.25, 1 },
+        {   0.75, 0.50, 0.25, 0.25, 2 },
+        {   0.75, 0.75, 0.25, 0.25, 3 },
+    },
+};
+
+/* ...scene in the left half, 2x2 camera previews grid in the right half */
+static const layout_t __layout_split = {
+    5,
+    {
+        {   0.00, 0.00, 0.50, 1.00, LAYOUT_SOURCE_SCENE },
+        {   0.50, 0.00, 0.25, 0.50, 0 },
+        {   0.75, 0.00, 0.25, 0.50, 1 },
+        {   0.50, 0.50, 0.25, 0.50, 2 },
+        {   0.75, 0.50, 0.25, 0.50, 3 },
+    },
+};
+
+/* ...predefined layouts */
+static const struct {
+    const char         *name;
+    const layout_t     *layout;
+
+}   __layout_presets[] = {
+    {   "quad",     &__layout_quad },
+    {   "split",    &__layout_split },
+};
+
+/* ...parse layout specification ("quad", "split" or "scene:x,y,w,h;cam0:x,y,w,h;...") */
+int layout_parse(layout_t *layout, const char *spec)
+{
+    const char     *s;
+    int             i;
+
+    /* ...check for a predefined layout first */
+    for (i = 0; i < (int)(sizeof(__layout_presets) / sizeof(__layout_presets[0])); i++)
+    {
+        if (!strcmp(spec, __layout_presets[i].name))
+        {
+            *layout = *__layout_presets[i].layout;
+            return 0;
+        }
+    }
+
+    /* ...parse explicit list of cells separated with semicolons */
+    for (layout->num = 0, s = spec; *s; s += (*s == ';'))
+    {
+        layout_cell_t  *cell = &layout->cell[layout->num];
+        char            name[8];
+        int             n;
+
+        CHK_ERR(layout->num < LAYOUT_CELLS_MAX, -(errno = EINVAL));
+        CHK_ERR(sscanf(s, "%7[^:]:%f,%f,%f,%f%n", name, &cell->x, &cell->y, &cell->w, &cell->h, &n) == 5, -(errno = EINVAL));
+
+        /* ...cell source is either a scene or a camera index */
+        if (!strcmp(name, "scene"))
+        {
+            cell->source = LAYOUT_SOURCE_SCENE;
+        }
+        else
+        {
+            CHK_ERR(sscanf(name, "cam%d", &cell->source) == 1 && cell->source >= 0 && cell->source < CAMERAS_NUMBER, -(errno = EINVAL));
+        }
+
+        /* ...cell must fit into viewable area (allow for rounding of decimal fractions) */
+        CHK_ERR(cell->x >= 0 && cell->y >= 0 && cell->w > 0 && cell->h > 0, -(errno = EINVAL));
+        CHK_ERR(cell->x + cell->w <= 1.001f && cell->y + cell->h <= 1.001f, -(errno = EINVAL));
+
+        /* ...proceed to next cell */
+        s += n, layout->num++;
+        CHK_ERR(*s == ';' || *s == '\0', -(errno = EINVAL));
+    }
+
+    CHK_ERR(layout->num > 0, -(errno = EINVAL));
+
+    TRACE(INIT, _b("layout '%s': %d cells"), spec, layout->num);
+
+    return 0;
+}
+
+/* ...get cell occupied by a scene */
+const layout_cell_t * layout_scene_cell(const layout_t *layout)
+{
+    int     i;
+
+    for (i = 0; i < layout->num; i++)
+    {
+        if (layout->cell[i].source == LAYOUT_SOURCE_SCENE)
+        {
+            return &layout->cell[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* ...get cell bounding box in window buffer pixels (GL convention, origin in lower-left corner) */
+static void __layout_cell_rect(const layout_cell_t *cell, window_data_t *window, int *x, int *y, int *w, int *h)
+{
+    int             W = window_get_width(window);
+    int             H = window_get_height(window);
+    float           x0 = 1, y0 = 1, x1 = -1, y1 = -1;
+    texture_view_t  v;
+    float          *p;
+    int             i;
+
+    /* ...map cell into normalized device coordinates of rotated buffer */
+    texture_set_view(&v, cell->x, 1 - cell->y - cell->h, cell->x + cell->w, 1 - cell->y);
+    texture_transform_view(&v, window_get_transform(window) / 90);
+
+    for (p = v, i = 0; i < 6; i++, p += 2)
+    {
+        (p[0] < x0 ? x0 = p[0] : 0), (p[0] > x1 ? x1 = p[0] : 0);
+        (p[1] < y0 ? y0 = p[1] : 0), (p[1] > y1 ? y1 = p[1] : 0);
+    }
+
+    *x = lrintf((x0 + 1) * W / 2), *w = lrintf((x1 + 1) * W / 2) - *x;
+    *y = lrintf((y0 + 1) * H / 2), *h = lrintf((y1 + 1) * H / 2) - *y;
+}
+
+/* ...restrict GL viewport and cairo drawing to a cell */
+void layout_cell_enter(const layout_cell_t *cell, window_data_t *window, cairo_t *cr)
+{
+    int     x, y, w, h;
+    int     W, H;
+
+    /* ...GL output is clipped to cell bounding box */
+    __layout_cell_rect(cell, window, &x, &y, &w, &h);
+    glViewport(x, y, w, h);
+    glScissor(x, y, w, h);
+    glEnable(GL_SCISSOR_TEST);
+
+    /* ...cairo overlays are scaled into the cell (context has window transformation set) */
+    window_get_viewport(window, &W, &H);
+    cairo_save(cr);
+    cairo_rectangle(cr, cell->x * W, cell->y * H, cell->w * W, cell->h * H);
+    cairo_clip(cr);
+    cairo_translate(cr, cell->x * W, cell->y * H);
+    cairo_scale(cr, cell->w, cell->h);
+
+    TRACE(0, _b("cell: %d,%d %d*%d"), x, y, w, h);
+}
+
+/* ...restore full-window output */
+void layout_cell_leave(window_data_t *window, cairo_t *cr)
+{
+    cairo_restore(cr);
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, window_get_width(window), window_get_height(window));
+}
+
+/* ...draw camera previews (aspect-preserving) into their cells with a single batch */
+void layout_draw_previews(const layout_t *layout, window_data_t *window, texture_data_t **textures, int n, int w, int h)
+{
+    texture_data_t     *t[LAYOUT_CELLS_MAX];
+    texture_view_t      v[LAYOUT_CELLS_MAX];
+    u32                 r = window_get_transform(window) / 90;
+    int                 W, H;
+    int                 i, k;
+
+    /* ...get effective window viewable area */
+    window_get_viewport(window, &W, &H);
+
+    for (i = k = 0; i < layout->num; i++)
+    {
+        const layout_cell_t    *cell = &layout->cell[i];
+        int                     x, y, cw, ch;
+
+        /* ...skip scene cell and cameras that are not available */
+        if (cell->source < 0 || cell->source >= n)      continue;
+
+        /* ...cell area in viewport pixels (GL view is bottom-up) */
+        x = cell->x * W, cw = cell->w * W;
+        ch = cell->h * H, y = H - (int)(cell->y * H) - ch;
+
+        /* ...fit camera image into the cell and apply output rotation */
+        texture_set_view_scale(&v[k], x, y, cw, ch, W, H, w, h);
+        texture_transform_view(&v[k], r);
+        t[k++] = textures[cell->source];
+    }
+
+    /* ...submit all previews at once */
+    if (k)
+    {
+        texture_draw_batch(k, t, v, NULL, 1.0);
+    }
+}
+
 
 
 /*******************************************************************************
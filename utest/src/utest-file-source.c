@@ -0,0 +1,477 @@
+/*******************************************************************************
+ * utest-file-source.c
+ *
+ *  High-throughput file source (read-ahead / memory-mapped)
+ *
+ * Copyright (c) 2015-2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      FSRC
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest.h"
+#include "utest-common.h"
+#include "utest-camera.h"
+#include <gst/app/gstappsrc.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...alignment of read buffer and file offsets */
+#define FILE_SOURCE_ALIGN               4096
+
+/* ...read-ahead window (in blocks) */
+#define FILE_SOURCE_WINDOW              4
+
+/* ...storage access latency treated as a stall (in microseconds) */
+#define FILE_SOURCE_STALL_TIME          20000
+
+/*******************************************************************************
+ * Local types definitions
+ ******************************************************************************/
+
+/* ...file source data */
+typedef struct file_source
+{
+    /* ...application source element */
+    GstElement             *appsrc;
+
+    /* ...stream identifier */
+    int                     id;
+
+    /* ...file descriptor */
+    int                     fd;
+
+    /* ...file size */
+    u64                     size;
+
+    /* ...current reading position */
+    u64                     offset;
+
+    /* ...aligned read cache (read-ahead mode) */
+    u8                     *cache;
+
+    /* ...read block size */
+    u32                     block;
+
+    /* ...file region held in the cache */
+    u64                     cache_offset;
+    u32                     cache_length;
+
+    /* ...end of region the kernel has been hinted to prefetch */
+    u64                     ra_offset;
+
+    /* ...memory-mapped file content (mmap mode) */
+    u8                     *map;
+
+    /* ...reference counter (memory-mapped buffers may outlive the element) */
+    gint                    refcount;
+
+    /* ...timestamp of the first access (in microseconds) */
+    u64                     ts_start;
+
+    /* ...I/O statistics */
+    file_source_stats_t     stats;
+
+}   file_source_t;
+
+/*******************************************************************************
+ * Statistics
+ ******************************************************************************/
+
+/* ...monotonic time in microseconds (accumulators must not wrap on long tracks) */
+static inline u64 file_source_time(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* ...account single storage access */
+static inline void file_source_account(file_source_t *src, u64 t0)
+{
+    file_source_stats_t    *stats = &src->stats;
+    u32                     delta = (u32)(file_source_time() - t0);
+
+    stats->reads++, stats->read_time += delta;
+    (stats->read_max < delta ? stats->read_max = delta : 0);
+
+    /* ...long access means decoder waits for the storage */
+    if (delta > FILE_SOURCE_STALL_TIME)
+    {
+        stats->stalls++, stats->stall_time += delta;
+
+        TRACE(DEBUG, _b("file-source-%d: stall %u us @ %llu"), src->id, delta, (unsigned long long)src->offset);
+    }
+}
+
+/* ...output statistics */
+static void file_source_report(file_source_t *src)
+{
+    file_source_stats_t    *stats = &src->stats;
+    u64                     elapsed = (src->ts_start ? file_source_time() - src->ts_start : 0);
+
+    TRACE(INFO, _b("file-source-%d: %llu bytes, %u reads, rate=%.1f MB/s, storage=%.1f MB/s, stalls=%u (%llu us), max-read=%u us"),
+          src->id, (unsigned long long)stats->bytes, stats->reads,
+          (elapsed ? (double)stats->bytes / elapsed : 0.0),
+          (stats->read_time ? (double)stats->bytes / stats->read_time : 0.0),
+          stats->stalls, (unsigned long long)stats->stall_time, stats->read_max);
+}
+
+/*******************************************************************************
+ * Storage access helpers
+ ******************************************************************************/
+
+/* ...hint the kernel to prefetch a window past current position */
+static inline void file_source_readahead(file_source_t *src, u64 end)
+{
+    u64     window = (u64)src->block * FILE_SOURCE_WINDOW;
+
+    /* ...reset hinted region after a seek */
+    (end > src->ra_offset || end + window < src->ra_offset ? src->ra_offset = end : 0);
+
+    /* ...extend prefetched region when half of it is consumed */
+    if (src->ra_offset - end < window / 2 && src->ra_offset < src->size)
+    {
+        u64     len = MIN(end + window, src->size) - src->ra_offset;
+
+        if (src->map)
+        {
+            u64     start = src->ra_offset & ~(u64)(FILE_SOURCE_ALIGN - 1);
+
+            madvise(src->map + start, src->ra_offset + len - start, MADV_WILLNEED);
+        }
+        else
+        {
+            posix_fadvise(src->fd, src->ra_offset, len, POSIX_FADV_WILLNEED);
+        }
+
+        TRACE(DEBUG, _b("file-source-%d: prefetch %llu+%llu"), src->id, (unsigned long long)src->ra_offset, (unsigned long long)len);
+
+        src->ra_offset += len;
+    }
+}
+
+/* ...refill read cache with aligned block containing given offset */
+static int file_source_fill(file_source_t *src, u64 offset)
+{
+    u64         start = offset & ~(u64)(FILE_SOURCE_ALIGN - 1);
+    u64         t0 = file_source_time();
+    ssize_t     n;
+
+    /* ...read a single large aligned block */
+    while ((n = pread(src->fd, src->cache, src->block, start)) < 0 && errno == EINTR)
+        ;
+
+    CHK_ERR(n > 0, (n < 0 ? -errno : -(errno = ENODATA)));
+
+    /* ...update statistics */
+    file_source_account(src, t0);
+
+    /* ...save cached region */
+    src->cache_offset = start, src->cache_length = (u32)n;
+
+    /* ...keep the kernel ahead of us */
+    file_source_readahead(src, start + n);
+
+    return 0;
+}
+
+/* ...produce buffer using read-ahead cache */
+static GstBuffer * file_source_read(file_source_t *src, u64 offset, u32 length)
+{
+    GstBuffer      *buffer;
+    GstMapInfo      map;
+    u8             *p;
+
+    CHK_ERR(buffer = gst_buffer_new_allocate(NULL, length, NULL), (errno = ENOMEM, NULL));
+
+    gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+
+    for (p = map.data; length > 0; )
+    {
+        u32     n;
+
+        /* ...refill cache if position is not covered */
+        if (offset < src->cache_offset || offset >= src->cache_offset + src->cache_length)
+        {
+            if (file_source_fill(src, offset) < 0)
+            {
+                TRACE(ERROR, _x("file-source-%d: read failed: %m"), src->id);
+                gst_buffer_unmap(buffer, &map);
+                gst_buffer_unref(buffer);
+                return NULL;
+            }
+        }
+
+        /* ...copy cached data */
+        n = MIN(length, src->cache_offset + src->cache_length - offset);
+        memcpy(p, src->cache + (offset - src->cache_offset), n);
+        p += n, offset += n, length -= n;
+    }
+
+    gst_buffer_unmap(buffer, &map);
+
+    return buffer;
+}
+
+/* ...release source reference */
+static void file_source_unref(gpointer data)
+{
+    file_source_t  *src = data;
+
+    if (g_atomic_int_dec_and_test(&src->refcount))
+    {
+        (src->map ? munmap(src->map, src->size) : 0);
+        close(src->fd);
+        free(src->cache);
+        free(src);
+
+        TRACE(INIT, _b("file-source %p destroyed"), src);
+    }
+}
+
+/* ...produce zero-copy buffer from memory-mapped file */
+static GstBuffer * file_source_map(file_source_t *src, u64 offset, u32 length)
+{
+    volatile u8    *p = src->map + offset;
+    u64             t0 = file_source_time();
+    u32             i;
+
+    /* ...prefault pages here so that storage latency is accounted in source */
+    for (i = 0; i < length; i += FILE_SOURCE_ALIGN)
+        (void)p[i];
+
+    file_source_account(src, t0);
+    file_source_readahead(src, offset + length);
+
+    /* ...buffer holds a reference to the mapping */
+    g_atomic_int_inc(&src->refcount);
+
+    return gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, src->map, src->size, offset, length, src, file_source_unref);
+}
+
+/*******************************************************************************
+ * Application source callbacks
+ ******************************************************************************/
+
+/* ...data request (random-access mode) */
+static void file_source_need_data(GstAppSrc *appsrc, guint length, gpointer data)
+{
+    file_source_t  *src = data;
+    u64             offset = src->offset;
+    GstBuffer      *buffer;
+
+    /* ...start measuring on first access */
+    (!src->ts_start ? src->ts_start = file_source_time() : 0);
+
+    /* ...signal end-of-stream when file is over */
+    if (offset >= src->size)
+    {
+        file_source_report(src);
+        gst_app_src_end_of_stream(appsrc);
+        return;
+    }
+
+    /* ...clip request to file size */
+    (length > src->size - offset ? length = src->size - offset : 0);
+
+    /* ...produce buffer; failure is a pipeline error, not an end of file */
+    if ((buffer = (src->map ? file_source_map(src, offset, length) : file_source_read(src, offset, length))) == NULL)
+    {
+        const gchar    *reason = g_strerror(errno);
+
+        GST_ELEMENT_ERROR(appsrc, RESOURCE, READ, (NULL),
+                          ("file-source-%d: failed to read %u bytes at %llu: %s", src->id, length, (unsigned long long)offset, reason));
+        return;
+    }
+
+    GST_BUFFER_OFFSET(buffer) = offset;
+    src->offset = offset + length;
+    src->stats.bytes += length;
+
+    TRACE(0, _b("file-source-%d: pushed %llu+%u"), src->id, (unsigned long long)offset, length);
+
+    gst_app_src_push_buffer(appsrc, buffer);
+}
+
+/* ...position change request */
+static gboolean file_source_seek_data(GstAppSrc *appsrc, guint64 offset, gpointer data)
+{
+    file_source_t  *src = data;
+
+    TRACE(DEBUG, _b("file-source-%d: seek to %llu"), src->id, (unsigned long long)offset);
+
+    src->offset = offset;
+
+    return TRUE;
+}
+
+/* ...application source callbacks */
+static GstAppSrcCallbacks file_source_cb = {
+    .need_data = file_source_need_data,
+    .seek_data = file_source_seek_data,
+};
+
+/* ...element destructor */
+static void __file_source_destructor(gpointer data, GObject *obj)
+{
+    file_source_t  *src = data;
+
+    /* ...output final statistics */
+    file_source_report(src);
+
+    /* ...drop element reference */
+    file_source_unref(src);
+}
+
+/*******************************************************************************
+ * Entry points
+ ******************************************************************************/
+
+/* ...global file source configuration */
+int     file_source_mode = FILE_SOURCE_MODE_FILESRC;
+u32     file_source_block = FILE_SOURCE_BLOCK_SIZE;
+
+/* ...create file source element */
+GstElement * file_source_create(const char *filename, int id)
+{
+    file_source_t  *src;
+    GstElement     *appsrc;
+    struct stat     st;
+
+    /* ...default GStreamer file source */
+    if (file_source_mode == FILE_SOURCE_MODE_FILESRC)
+    {
+        CHK_ERR(appsrc = gst_element_factory_make("filesrc", NULL), (errno = ENOENT, NULL));
+        g_object_set(appsrc, "location", filename, NULL);
+        return appsrc;
+    }
+
+    /* ...allocate source data */
+    CHK_ERR(src = calloc(1, sizeof(*src)), (errno = ENOMEM, NULL));
+
+    /* ...open the file */
+    if ((src->fd = open(filename, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+        TRACE(ERROR, _x("failed to open '%s': %m"), filename);
+        goto error;
+    }
+
+    /* ...get file size */
+    if (fstat(src->fd, &st) < 0)
+    {
+        TRACE(ERROR, _x("failed to stat '%s': %m"), filename);
+        goto error_fd;
+    }
+
+    src->id = id, src->size = st.st_size, src->refcount = 1;
+    src->block = (file_source_block + FILE_SOURCE_ALIGN - 1) & ~(FILE_SOURCE_ALIGN - 1);
+
+    /* ...we are going to read file sequentially most of the time */
+    posix_fadvise(src->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (file_source_mode == FILE_SOURCE_MODE_MMAP)
+    {
+        /* ...map entire file */
+        if ((src->map = mmap(NULL, src->size, PROT_READ, MAP_SHARED, src->fd, 0)) == MAP_FAILED)
+        {
+            TRACE(ERROR, _x("failed to map '%s': %m"), filename);
+            src->map = NULL;
+            goto error_fd;
+        }
+
+        madvise(src->map, src->size, MADV_SEQUENTIAL);
+    }
+    else if ((errno = posix_memalign((void **)&src->cache, FILE_SOURCE_ALIGN, src->block)) != 0)
+    {
+        TRACE(ERROR, _x("failed to allocate %u bytes: %m"), src->block);
+        goto error_fd;
+    }
+
+    /* ...create random-access application source */
+    if ((src->appsrc = appsrc = gst_element_factory_make("appsrc", NULL)) == NULL)
+    {
+        TRACE(ERROR, _x("failed to create appsrc"));
+        errno = ENOENT;
+        goto error_fd;
+    }
+
+    /* ...request whole blocks; default 4KB requests cost a buffer and a copy each */
+    g_object_set(appsrc,
+                 "stream-type", GST_APP_STREAM_TYPE_RANDOM_ACCESS,
+                 "format", GST_FORMAT_BYTES,
+                 "size", (gint64)src->size,
+                 "blocksize", (guint)src->block,
+                 NULL);
+
+    gst_app_src_set_callbacks(GST_APP_SRC(appsrc), &file_source_cb, src, NULL);
+
+    /* ...make statistics available to the application */
+    g_object_set_data(G_OBJECT(appsrc), "file-source", src);
+
+    /* ...set custom destructor */
+    g_object_weak_ref(G_OBJECT(appsrc), __file_source_destructor, src);
+
+    TRACE(INIT, _b("file-source-%d: '%s' (%llu bytes, %s, block=%u)"), id, filename, (unsigned long long)src->size,
+          (src->map ? "mmap" : "read-ahead"), src->block);
+
+    return appsrc;
+
+error_fd:
+    (src->map ? munmap(src->map, src->size) : 0);
+    free(src->cache);
+    close(src->fd);
+
+error:
+    free(src);
+    return NULL;
+}
+
+/* ...retrieve I/O statistics */
+int file_source_get_stats(GstElement *element, file_source_stats_t *stats)
+{
+    file_source_t  *src = g_object_get_data(G_OBJECT(element), "file-source");
+
+    CHK_ERR(src, -EINVAL);
+
+    *stats = src->stats;
+    stats->elapsed = (src->ts_start ? file_source_time() - src->ts_start : 0);
+
+    return 0;
+}
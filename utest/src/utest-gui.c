@@ -322,21 +322,19 @@ static void __menu_draw(widget_data_t *widget, void *cdata, cairo_t *cr)
  ******************************************************************************/
 
 /* ...main GUI layer drawing */
-void gui_redraw(widget_data_t *widget, cairo_t *cr)
+int gui_redraw(widget_data_t *widget, cairo_t *cr)
 {
     gui_t      *gui = &__gui;
 
     /* ...check if GUI layer is active */
-    if (!gui->active)       return;
+    if (!gui->active)       return 0;
 
-    /* ...fade-out window content */
-    cairo_set_source_rgba(cr, 0, 0, 0, gui->alpha);
-    cairo_paint(cr);
-    
-    /* ...render menu widget image on the current surface */
-    widget_render(gui->menu.base.widget, cr, gui->alpha);
+    /* ...fade-out window content and blend cached menu image with a single quad */
+    widget_compose(gui->menu.base.widget, cr, gui->alpha, gui->alpha);
 
     TRACE(DEBUG, _b("GUI drawing complete (alpha=%.2f)"), gui->alpha);
+
+    return 1;
 }
 
 /*******************************************************************************
@@ -746,6 +744,7 @@ enum __menu_items {
 	__MENU_ITEM_DUMMY,
     __MENU_ITEM_LIVE,
     __MENU_ITEM_DEBUG,
+    __MENU_ITEM_HUD,
     __MENU_ITEM_SPHERE,
     __MENU_ITEM_ADJUST,
 	__MENU_ITEM_CALIBRATE,
@@ -892,6 +891,23 @@ static void __debug_output(gui_menu_item_t *item, widget_data_t *widget)
     app_debug_enable(gui->app, !!(item->flags & GUI_MENU_ITEM_CHECKBOX_STATE));
 }
 
+/* ...toggle performance HUD */
+static void __perf_hud(gui_menu_item_t *item, widget_data_t *widget)
+{
+    gui_t      *gui = &__gui;
+
+    /* ...toggle menu state */
+    item->flags ^= GUI_MENU_ITEM_CHECKBOX_STATE;
+
+    TRACE(INFO, _b("performance HUD: %d"), !!(item->flags & GUI_MENU_ITEM_CHECKBOX_STATE));
+
+    /* ...invoke application callback */
+    app_hud_enable(gui->app, !!(item->flags & GUI_MENU_ITEM_CHECKBOX_STATE));
+
+    /* ...force widget update */
+    widget_schedule_redraw(widget);
+}
+
 /* ...close GUI layer */
 static void __close_gui(gui_menu_item_t *item, widget_data_t *widget)
 {
@@ -942,6 +958,11 @@ static gui_menu_item_t __menu_items[] = {
         .flags = GUI_MENU_ITEM_CHECKBOX,
         .select = __debug_output,
     },
+    [__MENU_ITEM_HUD] = {
+        .text = "Performance HUD",
+        .flags = GUI_MENU_ITEM_CHECKBOX,
+        .select = __perf_hud,
+    },
     [__MENU_ITEM_TOP] = {
         .text = "Top view",
         .select = __sview_top_view,
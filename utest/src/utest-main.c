@@ -33,6 +33,8 @@
 #include "utest.h"
 #include "utest-common.h"
 #include "utest-app.h"
+#include "utest-vsink.h"
+#include "utest-display-wayland.h"
 #include <getopt.h>
 
 #ifdef COMPILE_WITH_PRIVATE
@@ -55,6 +57,12 @@ TRACE_TAG(DEBUG, 0);
 /* ...output devices for main / auxiliary windows */
 int                 __output_main = 0, __output_transform = 0;
 
+/* ...additional outputs mirroring surround-view scene */
+int                 __output_aux[APP_VIEWS_MAX - 1], __output_aux_num = 0;
+
+/* ...split-screen layout of output windows (no cells - scene fills a window) */
+layout_t            __layout;
+
 #ifdef ENABLE_CAMERA_MJPEG
 /* ...pointer to effective AVB MJPEG cameras MAC addresses */
 u8                (*camera_mac_address)[6];
@@ -99,6 +107,9 @@ char                   *joystick_dev_name = "/dev/input/js0";
 /* ...application flags */
 static int flags;
 
+/* ...number of frames for VBO streaming benchmark (disabled if zero) */
+static int vbo_bench_frames;
+
 /*******************************************************************************
  * Tracks parsing
  ******************************************************************************/
@@ -352,21 +363,50 @@ static inline int parse_vin_devices(char *str, char **name, int n)
     return 0;
 }
 
-/* ...parse video stream file names */
-static inline int parse_video_file_names(char *str, char **name, int n)
+/* ...parse auxiliary output devices list */
+static inline int parse_aux_outputs(char *str, int *output, int n)
 {
     char   *s;
-    
-    for (s = strtok(str, ","); n > 0 && s; n--, s = strtok(NULL, ","))
+    int     i;
+
+    for (i = 0, s = strtok(str, ","); s; i++, s = strtok(NULL, ","))
+    {
+        /* ...make sure we do not exceed maximal number of views */
+        CHK_ERR(i < n, -EINVAL);
+
+        output[i] = atoi(s);
+    }
+
+    return i;
+}
+
+/* ...parse video stream file names */
+static inline int parse_video_file_names(const char *str, char **name, int n)
+{
+    char   *p, *s;
+    int     i, k;
+
+    /* ...work on a copy - track descriptor is reused when track is replayed */
+    CHK_ERR(p = strdup(str), -(errno = ENOMEM));
+
+    for (i = 0, s = strtok(p, ","); i < n && s; i++, s = strtok(NULL, ","))
     {
         /* ...copy a string */
-        *name++ = strdup(s);
+        free(name[i]), name[i] = strdup(s);
     }
 
-    /* ...make sure we have parsed all addresses */
-    CHK_ERR(n == 0, -EINVAL);
+    /* ...reset remaining names */
+    for (k = i; k < n; k++)
+    {
+        free(name[k]), name[k] = NULL;
+    }
 
-    return 0;
+    free(p);
+
+    /* ...either a single multi-stream container or a file per camera */
+    CHK_ERR(i == 1 || i == n, -(errno = EINVAL));
+
+    return i;
 }
 
 static inline void mac_addresses_to_name(char* str[4], u8 addr[4][6]) {
@@ -518,6 +558,26 @@ static const struct option    options[] = {
         {   "nonFisheyeCam",    no_argument,    NULL,   14 },
         {   "save",             no_argument,    NULL,   15 },
 
+    /* ...playback control options */
+    {   "loop",             no_argument,        NULL, 16 },
+    {   "readahead",        required_argument,  NULL, 17 },
+    {   "mmap",             no_argument,        NULL, 18 },
+    {   "pool-depth",       required_argument,  NULL, 19 },
+    {   "rate",             required_argument,  NULL, 20 },
+
+    /* ...diagnostics options */
+    {   "vbo-bench",        required_argument,  NULL, 21 },
+
+    /* ...display options */
+    {   "shader-cache",     required_argument,  NULL, 22 },
+    {   "gpu-timing",       no_argument,        NULL, 23 },
+    {   "outputs",          required_argument,  NULL, 24 },
+    {   "compositor-rotation", no_argument,     NULL, 25 },
+    {   "drm",              required_argument,  NULL, 26 },
+    {   "x11",              optional_argument,  NULL, 27 },
+    {   "camera-plane",     no_argument,        NULL, 28 },
+    {   "layout",           required_argument,  NULL, 29 },
+
     /* ...object detection engine library configuration options - tbd */
     {   NULL,               0,                  NULL, 0 },
 };
@@ -717,6 +777,102 @@ static int parse_cmdline(int argc, char **argv)
 			cfg->saveFrames = 1;
 			break;
 
+        case 16:
+            /* ...loop offline tracks using segment seeks */
+            TRACE(INIT, _b("track looping enabled"));
+            flags |= APP_FLAG_LOOP;
+            break;
+
+        case 17:
+            /* ...read-ahead file source with given block size (in KB) */
+            TRACE(INIT, _b("read-ahead file source: block=%s KB"), optarg);
+            file_source_mode = FILE_SOURCE_MODE_READAHEAD;
+            (atoi(optarg) > 0 ? file_source_block = atoi(optarg) << 10 : 0);
+            break;
+
+        case 18:
+            /* ...memory-mapped file source */
+            TRACE(INIT, _b("memory-mapped file source"));
+            file_source_mode = FILE_SOURCE_MODE_MMAP;
+            break;
+
+        case 19:
+            /* ...video-sink buffer pool depth */
+            TRACE(INIT, _b("video-sink pool depth: %s"), optarg);
+            CHK_ERR((vsink_pool_depth = atoi(optarg)) > 0, -EINVAL);
+            break;
+
+        case 20:
+            /* ...offline playback rate */
+            TRACE(INIT, _b("playback rate: %s"), optarg);
+            video_stream_rate = atof(optarg);
+            CHK_ERR(video_stream_rate >= VIDEO_STREAM_RATE_MIN && video_stream_rate <= VIDEO_STREAM_RATE_MAX, -EINVAL);
+            break;
+
+        case 21:
+            /* ...run VBO streaming benchmark instead of application */
+            TRACE(INIT, _b("VBO benchmark: %s frames"), optarg);
+            CHK_ERR((vbo_bench_frames = atoi(optarg)) > 0, -EINVAL);
+            break;
+
+        case 22:
+            /* ...program binaries cache directory (empty string disables caching) */
+            TRACE(INIT, _b("shader cache: '%s'"), optarg);
+            program_cache_dir = optarg;
+            break;
+
+        case 23:
+            /* ...GPU timer queries around render stages */
+            TRACE(INIT, _b("GPU stages timing enabled"));
+            window_gpu_timing = 1;
+            break;
+
+        case 24:
+            /* ...additional outputs rendering surround-view scene */
+            TRACE(INIT, _b("auxiliary outputs: '%s'"), optarg);
+            CHK_API(__output_aux_num = parse_aux_outputs(optarg, __output_aux, APP_VIEWS_MAX - 1));
+            break;
+
+        case 25:
+            /* ...screen rotation is applied by compositor (buffer transformation) */
+            TRACE(INIT, _b("compositor-side rotation enabled"));
+            window_buffer_transform = 1;
+            break;
+
+        case 26:
+            /* ...render directly to KMS device bypassing compositor */
+#ifdef DISPLAY_DRM_ENABLED
+            TRACE(INIT, _b("KMS output device: '%s'"), optarg);
+            display_drm_device = optarg;
+            break;
+#else
+            TRACE(ERROR, _x("KMS display support is not compiled in"));
+            return -EINVAL;
+#endif
+
+        case 27:
+            /* ...render into X11 window (desktop profiling) */
+#ifdef DISPLAY_X11_ENABLED
+            TRACE(INIT, _b("X11 display: '%s'"), (optarg ? : "default"));
+            display_x11_name = (optarg ? : "");
+            break;
+#else
+            TRACE(ERROR, _x("X11 display support is not compiled in"));
+            return -EINVAL;
+#endif
+
+        case 28:
+            /* ...frontal camera buffers are scanned out by compositor */
+            TRACE(INIT, _b("camera plane presentation enabled"));
+            flags |= APP_FLAG_CAMERA_PLANE;
+            break;
+
+        case 29:
+            /* ...split-screen layout with scene and camera previews */
+            TRACE(INIT, _b("layout: '%s'"), optarg);
+            CHK_API(layout_parse(&__layout, optarg));
+            break;
+
 		default:
 		return -EINVAL;
         }
@@ -856,7 +1012,7 @@ static inline int playback_video(app_data_t *app, track_desc_t *track, int start
         {
 #endif
         CHK_ERR(track->type == 0, -EINVAL);
-        parse_video_file_names(track->file, file_names, CAMERAS_NUMBER);
+        CHK_API(parse_video_file_names(track->file, file_names, CAMERAS_NUMBER));
         CHK_API(sview_camera_init(app, video_stream_create));
 #ifdef ENABLE_OBJDET
         }
@@ -1039,6 +1195,14 @@ int main(int argc, char **argv)
 
     /* ...initialize display subsystem */
     CHK_ERR(display = display_create(), -errno);
+
+    /* ...run diagnostics only if requested */
+    if (vbo_bench_frames > 0)
+    {
+        CHK_API(vbo_benchmark(display, vbo_bench_frames));
+        return 0;
+    }
+
     /* ...initialize surround-view application */
     CHK_ERR(app = app_init(display, &__sv_cfg, flags), -errno);
     
@@ -33,6 +33,7 @@
 #include "utest.h"
 #include "utest-app.h"
 #include "utest-vsink.h"
+#include "utest-display-wayland.h"
 
 /* ...system headers */
 #include <sys/poll.h>
@@ -48,6 +49,13 @@ TRACE_TAG(INIT, 1);
 TRACE_TAG(INFO, 1);
 TRACE_TAG(DEBUG, 1);
     
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...playback rate statistics reporting period (in microseconds) */
+#define APP_RATE_REPORT_PERIOD          5000000
+    
 /*******************************************************************************
  * Local types definitions
  ******************************************************************************/
@@ -58,16 +66,205 @@ TRACE_TAG(DEBUG, 1);
 /* ...debugging helper */
 static inline void gl_dump_state(void);
 
+/*******************************************************************************
+ * Playback rate statistics
+ ******************************************************************************/
+
+/* ...report delivered vs decimated frame rate (called with queue lock held) */
+static inline void app_rate_stats_update(app_data_t *app)
+{
+    u32     now = __get_time_usec();
+    u32     delta = now - app->rate_ts;
+    float   k;
+
+    /* ...start reporting period on first frame */
+    if (app->rate_ts == 0)
+    {
+        app->rate_ts = now, app->rate_delivered = app->rate_dropped = app->rate_late = 0;
+        return;
+    }
+
+    if (delta < APP_RATE_REPORT_PERIOD)     return;
+
+    k = 1e+06 / delta;
+
+    TRACE(INFO, _b("rate x%.2f: delivered %.1f fps, decimated %.1f fps, late %.1f fps"),
+          video_stream_rate, app->rate_delivered * k,
+          (float)app->rate_dropped * k / CAMERAS_NUMBER, (float)app->rate_late * k / CAMERAS_NUMBER);
+
+    /* ...start new period; cameras report their sinks statistics on next frame */
+    app->rate_ts = now, app->rate_delivered = app->rate_dropped = app->rate_late = 0;
+    app->rate_pool = (1 << CAMERAS_NUMBER) - 1;
+}
+
+/* ...report video-sink buffer pool statistics once per period (camera streaming thread) */
+static void app_pool_stats_report(app_data_t *app, int i, vsink_meta_t *vmeta)
+{
+    vsink_pool_stats_t  stats;
+    int                 report;
+
+    pthread_mutex_lock(&app->lock);
+    report = (app->rate_pool & (1 << i)) != 0;
+    app->rate_pool &= ~(1 << i);
+    pthread_mutex_unlock(&app->lock);
+
+    if (!report || !vmeta->sink || video_sink_get_stats(vmeta->sink, &stats) < 0)     return;
+
+    TRACE(INFO, _b("camera-%d sink: allocs=%u, acquires=%u, reuses=%u, waits=%u (%llu us), renegotiations=%u, cache=%u/%u/%u"),
+          i, stats.allocs, stats.acquires, stats.reuses, stats.waits, (unsigned long long)stats.wait_time, stats.renegotiations,
+          stats.cache_hits, stats.cache_misses, stats.cache_evictions);
+}
+
+/* ...scale replayed CAN/PDU timestamp according to playback rate */
+static inline u64 app_rate_scale_ts(app_data_t *app, u64 ts)
+{
+    if (video_stream_rate == 1.0)           return ts;
+
+    /* ...first message of the track defines time origin */
+    (app->rate_pkt_ts == 0 ? app->rate_pkt_ts = ts : 0);
+
+    return app->rate_pkt_ts + (u64)((ts - app->rate_pkt_ts) / video_stream_rate);
+}
+
 /*******************************************************************************
  * Render queue access helpers
  ******************************************************************************/
 
-/* ...pop buffers from a render queue */
-static inline int sview_pop_buffers(app_data_t *app, GstBuffer **buf, texture_data_t **tex, GLuint *t, void **planes, s64 *ts)
+/* ...camera frame-set shared by all output views */
+struct sview_frame
+{
+    /* ...reference counter (application and views drawing the set) */
+    gint                refcount;
+
+    /* ...frame-set sequence number */
+    u32                 seq;
+
+    /* ...set has been picked up by at least one view */
+    int                 used;
+
+    /* ...camera buffers held by the set */
+    GstBuffer          *buffers[CAMERAS_NUMBER];
+
+    /* ...textures and planes wrapping the buffers */
+    GLuint              tex[CAMERAS_NUMBER];
+    void               *planes[CAMERAS_NUMBER];
+    texture_data_t     *textures[CAMERAS_NUMBER];
+
+    /* ...camera image dimensions */
+    int                 width, height;
+
+    /* ...averaged timestamp of the set */
+    s64                 ts;
+};
+
+/* ...release frame-set reference; buffers are returned when last view is done */
+static void sview_frame_unref(sview_frame_t *frame)
 {
     int     i;
-    int     ready;
-    
+
+    if (!g_atomic_int_dec_and_test(&frame->refcount))       return;
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        gst_buffer_unref(frame->buffers[i]);
+    }
+
+    free(frame);
+}
+
+/* ...schedule redraw of all output views */
+static inline void app_views_schedule_redraw(app_data_t *app)
+{
+    int     i;
+
+    for (i = 0; i < app->views_num; i++)
+    {
+        window_schedule_redraw(app->views[i].window);
+    }
+}
+
+/* ...collect complete frame-set from render queues (called with queue lock held) */
+static void sview_frame_publish(app_data_t *app)
+{
+    sview_frame_t  *frame;
+    s64             ts, ts_acc = 0, ts_min = 0, ts_max = 0;
+    u32             depth;
+    int             i;
+
+    /* ...leave buffers in the queues if set cannot be allocated */
+    if ((frame = malloc(sizeof(*frame))) == NULL)
+    {
+        TRACE(ERROR, _x("out of memory"));
+        return;
+    }
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        GQueue         *queue = &app->render[i];
+        GstBuffer      *buffer;
+        vsink_meta_t   *meta;
+        texture_data_t *texture;
+
+        /* ...buffer must be available */
+        BUG(g_queue_is_empty(queue), _x("inconsistent state of camera-%d"), i);
+
+        /* ...take last (most actual) buffer; queue ownership passes to the set */
+        frame->buffers[i] = buffer = g_queue_pop_tail(queue);
+        meta = gst_buffer_get_vsink_meta(buffer);
+        texture = meta->priv;
+        frame->tex[i] = texture->tex;
+        frame->planes[i] = texture->data[0];
+        frame->textures[i] = texture;
+        frame->width = meta->width, frame->height = meta->height;
+
+        /* ...update timestamp accumulator and inter-camera spread */
+        ts_acc += (ts = GST_BUFFER_DTS(buffer));
+        (i == 0 || ts < ts_min ? ts_min = ts : 0), (i == 0 || ts > ts_max ? ts_max = ts : 0);
+
+        /* ...account render queue depth (buffers taken at once) */
+        depth = g_queue_get_length(queue) + 1;
+        (depth > app->hud.depth ? app->hud.depth = depth : 0);
+
+        /* ...drop all "previous" buffers (decimate when rendering cannot keep up) */
+        while (!g_queue_is_empty(queue))
+        {
+            gst_buffer_unref(g_queue_pop_head(queue));
+            app->rate_dropped++, app->hud.dropped++;
+        }
+    }
+
+    /* ...account inter-camera skew of the set (in microseconds) */
+    (ts_max - ts_min > (s64)app->hud.skew * 1000 ? app->hud.skew = (u32)((ts_max - ts_min) / 1000) : 0);
+
+    /* ...all queues are empty now */
+    app->frames = (1 << CAMERAS_NUMBER) - 1;
+
+    frame->refcount = 1, frame->used = 0;
+    frame->seq = ++app->frame_seq;
+    frame->ts = ts_acc / CAMERAS_NUMBER;
+
+    /* ...replace previous set; it is dropped unless some view still draws it */
+    if (app->frame)
+    {
+        (!app->frame->used ? app->rate_dropped += CAMERAS_NUMBER, app->hud.dropped += CAMERAS_NUMBER : 0);
+        sview_frame_unref(app->frame);
+    }
+
+    app->frame = frame;
+
+    /* ...account delivered frame-set */
+    app->rate_delivered++, app_rate_stats_update(app);
+
+    /* ...trigger surround-view scene processing in all views */
+    app_views_schedule_redraw(app);
+}
+
+/* ...acquire latest frame-set not yet drawn by the view */
+static sview_frame_t * sview_frame_get(app_data_t *app, app_view_t *view)
+{
+    sview_frame_t  *frame = NULL;
+    int             i;
+
     /* ...lock access to internal data */
     pthread_mutex_lock(&app->lock);
 
@@ -83,90 +280,97 @@ static inline int sview_pop_buffers(app_data_t *app, GstBuffer **buf, texture_da
             }
         }
 
-        TRACE(DEBUG, _b("purged rendering queue"));
-        
-        /* ...mark we have no buffers to draw */
-        ready = 0;
-    }
-    else if ((app->frames & ((1 << CAMERAS_NUMBER) - 1)) == 0)
-    {
-        s64     ts_acc = 0;
-        
-        /* ...collect the textures corresponding to the cameras */
-        for (i = 0; i < CAMERAS_NUMBER; i++)
+        /* ...release published set (views may still hold references) */
+        if (app->frame)
         {
-            GQueue         *queue = &app->render[i];
-            GstBuffer      *buffer;
-            vsink_meta_t   *meta;
-            texture_data_t *texture;
-            
-            /* ...buffer must be available */
-            BUG(g_queue_is_empty(queue), _x("inconsistent state of camera-%d"), i);
-            
-            /* ...retrieve last (most actual) buffer */
-            buf[i] = buffer = g_queue_peek_tail(queue);
-            meta = gst_buffer_get_vsink_meta(buffer);
-            tex[i] = texture = meta->priv;
-            t[i] = texture->tex;
-            planes[i] = texture->data[0];
-
-            /* ...update timestamp accumulator */
-            ts_acc += GST_BUFFER_DTS(buffer);
-
-            /* ...drop all "previous" buffers */
-            while (g_queue_peek_head(queue) != buffer)
-            {
-                gst_buffer_unref(g_queue_pop_head(queue));
-            }
+            sview_frame_unref(app->frame);
+            app->frame = NULL;
         }
-        
-        /* ...update accumulator */
-        *ts = ts_acc / CAMERAS_NUMBER;
 
-        /* ...return buffer readiness indication */
-        ready = 1;
+        TRACE(DEBUG, _b("purged rendering queue"));
+    }
+    else if ((frame = app->frame) != NULL && frame->seq != view->seq)
+    {
+        /* ...take a reference for the view */
+        g_atomic_int_inc(&frame->refcount);
+        frame->used = 1;
+        view->seq = frame->seq;
     }
     else
     {
-        /* ...buffers not ready */
-        ready = 0;
+        /* ...nothing new to draw */
+        frame = NULL;
     }
 
     pthread_mutex_unlock(&app->lock);
 
-    return ready;
+    return frame;
 }
 
-/* ...release buffer set */
-static inline void sview_release_buffers(app_data_t *app, GstBuffer **buffers)
+/* ...frame-set awaiting GPU completion in a view */
+typedef struct sview_retire
 {
-    int     i;
+    /* ...fence inserted after the last texture read */
+    EGLSyncKHR          sync;
 
-    pthread_mutex_lock(&app->lock);
-    
-    /* ...drop the buffers - they are heads of the rendering queues */
-    for (i = 0; i < CAMERAS_NUMBER; i++)
+    /* ...frame-set read by the GPU */
+    sview_frame_t      *frame;
+
+}   sview_retire_t;
+
+/* ...drop frame-sets whose fences have signalled (render thread context) */
+static void sview_retire_frames(app_view_t *view, int wait)
+{
+    EGLDisplay          dpy = eglGetCurrentDisplay();
+    EGLTimeKHR          timeout = (wait ? EGL_FOREVER_KHR : 0);
+    sview_retire_t     *r;
+
+    /* ...fences are signalled in submission order */
+    while ((r = g_queue_peek_head(&view->retire)) != NULL)
     {
-        GQueue     *queue = &app->render[i];
-        GstBuffer  *buffer;
+        if (r->sync != EGL_NO_SYNC_KHR)
+        {
+            if (eglClientWaitSyncKHR(dpy, r->sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, timeout) != EGL_CONDITION_SATISFIED_KHR)
+                break;
 
-        /* ...queue cannot be empty */
-        BUG(g_queue_is_empty(queue), _x("inconsistent state of camera-%d"), i);
+            eglDestroySyncKHR(dpy, r->sync);
+        }
 
-        /* ...remove head of the queue */
-        buffer = g_queue_pop_head(queue);
-        
-        /* ...buffer must be at the head of the queue */
-        BUG(buffers[i] != buffer, _x("invalid queue head: %p != %p"), buffers[i], buffer);
-        
-        /* ...return buffer to a pool */
-        gst_buffer_unref(buffer);
+        /* ...buffers return to their pools once all views are done */
+        sview_frame_unref(r->frame);
 
-        /* ...check if queue gets empty */
-        (g_queue_is_empty(queue) ? app->frames ^= 1 << i : 0);
+        free(g_queue_pop_head(&view->retire));
     }
+}
 
-    pthread_mutex_unlock(&app->lock);
+/* ...hold frame-set until GPU reads of the view complete */
+static inline void sview_frame_release(app_view_t *view, sview_frame_t *frame)
+{
+    sview_retire_t     *r;
+
+    /* ...return sets of previous frames that GPU is done with */
+    sview_retire_frames(view, 0);
+
+    if ((r = malloc(sizeof(*r))) == NULL)
+    {
+        /* ...no tracking possible; wait for the reads right away */
+        glFinish();
+        sview_frame_unref(frame);
+        return;
+    }
+
+    /* ...fence marks completion of engine texture reads (fallback to release after draw) */
+    r->sync = (eglCreateSyncKHR ? eglCreateSyncKHR(eglGetCurrentDisplay(), EGL_SYNC_FENCE_KHR, NULL) : EGL_NO_SYNC_KHR);
+    r->frame = frame;
+
+    g_queue_push_tail(&view->retire, r);
+
+    /* ...track GPU hold depth (pool sizing hint) */
+    if (g_queue_get_length(&view->retire) > view->retire_max)
+    {
+        view->retire_max = g_queue_get_length(&view->retire);
+        TRACE(INFO, _b("view-%d: frame-sets held by GPU: %u"), (int)(view - view->app->views), view->retire_max);
+    }
 }
 
 /* ...purge render queues */
@@ -187,6 +391,46 @@ static inline void sview_purge_buffers(app_data_t *app)
     pthread_mutex_unlock(&app->lock);
 }
 
+/*******************************************************************************
+ * Track looping support
+ ******************************************************************************/
+
+/* ...update loop-boundary glitch statistics (called with queue lock held) */
+static inline void app_loop_glitch_update(app_data_t *app)
+{
+    u32     delta = __get_time_usec() - app->loop_ts;
+
+    /* ...accumulate glitch duration */
+    app->loop_glitch = delta;
+    app->loop_glitch_acc += delta;
+    (app->loop_glitch_max < delta ? app->loop_glitch_max = delta : 0);
+
+    /* ...mark boundary is passed */
+    app->loop_ts = 0;
+
+    TRACE(INFO, _b("loop #%u: glitch=%u us (avg=%u, max=%u)"), app->loop_count, delta,
+          (u32)(app->loop_glitch_acc / app->loop_count), app->loop_glitch_max);
+}
+
+/* ...issue (segment) seek to the beginning of the track on all streams at configured rate */
+static inline int app_loop_seek(app_data_t *app, int flush)
+{
+    GstSeekFlags    flags = (flush ? GST_SEEK_FLAG_FLUSH : 0);
+
+    /* ...segment seek is used for looping only; otherwise end-of-stream is delivered */
+    (app->flags & APP_FLAG_LOOP ? flags |= GST_SEEK_FLAG_SEGMENT : 0);
+
+    /* ...seek is sent to the pipeline and distributed to all sinks in sync */
+    if (!gst_element_seek(app->pipe, video_stream_rate, GST_FORMAT_TIME, flags,
+                          GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE))
+    {
+        TRACE(ERROR, _x("seek (rate=%.2f) failed"), video_stream_rate);
+        return -EPIPE;
+    }
+
+    return 0;
+}
+
 /*******************************************************************************
  * Interface exposed to the camera backend
  ******************************************************************************/
@@ -214,7 +458,7 @@ static int sview_input_alloc(void *data, GstBuffer *buffer)
     CHK_ERR(w == 1280 && h == 800, -EINVAL);
 
     /* ...allocate texture to wrap the buffer */
-    CHK_ERR(vmeta->priv = texture_create(w, h, vmeta->plane, vmeta->format), -errno);
+    CHK_ERR(vmeta->priv = texture_create_dmabuf(w, h, vmeta->plane, vmeta->dmafd, vmeta->stride, vmeta->offset, vmeta->modifier, vmeta->format), -errno);
 
     /* ...add custom destructor to the buffer */
     gst_mini_object_weak_ref(GST_MINI_OBJECT(buffer), __destroy_sv_texture, app);
@@ -224,15 +468,9 @@ static int sview_input_alloc(void *data, GstBuffer *buffer)
     return 0;
 }
 
-/* ...process new input buffer submitted from camera */
-static int sview_input_process(void *data, int i, GstBuffer *buffer)
+/* ...place camera buffer into rendering queue */
+static int __sview_input_submit(app_data_t *app, int i, GstBuffer *buffer)
 {
-    app_data_t     *app = data;
-
-    BUG(i >= CAMERAS_NUMBER, _x("invalid camera index: %d"), i);
-
-    TRACE(DEBUG, _b("camera-%d: input buffer received"), i);
-
     /* ...get queue access lock */
     pthread_mutex_lock(&app->lock);
 
@@ -241,6 +479,7 @@ static int sview_input_process(void *data, int i, GstBuffer *buffer)
     {
         /* ...place buffer into main rendering queue (take ownership) */
         g_queue_push_tail(&app->render[i], buffer), gst_buffer_ref(buffer);
+        app->hud.input[i]++;
 
         /* ...indicate buffer is available */
         app->frames &= ~(1 << i);
@@ -248,8 +487,11 @@ static int sview_input_process(void *data, int i, GstBuffer *buffer)
         /* ...schedule processing if all buffers are ready */
         if ((app->frames & ((1 << CAMERAS_NUMBER) - 1)) == 0)
         {
-            /* ...all buffers available; trigger surround-view scene processing */
-            window_schedule_redraw(app->window);
+            /* ...account loop-boundary glitch when first complete set arrives */
+            (app->loop_ts ? app_loop_glitch_update(app) : 0);
+
+            /* ...all buffers available; publish frame-set to the views */
+            sview_frame_publish(app);
         }
     }
 
@@ -259,6 +501,68 @@ static int sview_input_process(void *data, int i, GstBuffer *buffer)
     return 0;
 }
 
+/* ...pending copy-upload of camera buffer */
+typedef struct sview_upload
+{
+    /* ...application handle */
+    app_data_t         *app;
+
+    /* ...camera index */
+    int                 id;
+
+    /* ...buffer being uploaded (reference held) */
+    GstBuffer          *buffer;
+
+}   sview_upload_t;
+
+/* ...copy-upload completion callback (invoked from upload thread) */
+static void __sview_upload_done(texture_data_t *texture, void *cdata)
+{
+    sview_upload_t     *upload = cdata;
+
+    /* ...texture content is ready; pass buffer to the renderer */
+    __sview_input_submit(upload->app, upload->id, upload->buffer);
+
+    gst_buffer_unref(upload->buffer);
+    free(upload);
+}
+
+/* ...process new input buffer submitted from camera */
+static int sview_input_process(void *data, int i, GstBuffer *buffer)
+{
+    app_data_t         *app = data;
+    vsink_meta_t       *vmeta = gst_buffer_get_vsink_meta(buffer);
+    texture_data_t     *texture = vmeta->priv;
+    sview_upload_t     *upload;
+
+    BUG(i >= CAMERAS_NUMBER, _x("invalid camera index: %d"), i);
+
+    TRACE(DEBUG, _b("camera-%d: input buffer received"), i);
+
+    /* ...sink statistics are read on its own streaming thread */
+    app_pool_stats_report(app, i, vmeta);
+
+    /* ...zero-copy textures are submitted to the renderer directly */
+    if (!texture->upload)
+    {
+        return __sview_input_submit(app, i, buffer);
+    }
+
+    /* ...copy planes into texture asynchronously; renderer never waits for upload */
+    CHK_ERR(upload = malloc(sizeof(*upload)), -(errno = ENOMEM));
+    upload->app = app, upload->id = i, upload->buffer = gst_buffer_ref(buffer);
+
+    if (texture_upload(texture, __sview_upload_done, upload) < 0)
+    {
+        /* ...upload thread is behind; drop the frame */
+        gst_buffer_unref(buffer);
+        free(upload);
+    }
+
+    return 0;
+}
+
+
 /* ...callbacks for surround view camera set back-end */
 static const camera_callback_t sv_camera_cb = {
     .allocate = sview_input_alloc,
@@ -375,6 +679,47 @@ static void __destroy_od_texture(gpointer data, GstMiniObject *obj)
     texture_destroy(vmeta->priv);
 }
 
+/* ...quark of compositor plane buffer attached to camera buffer */
+static GQuark __objdet_plane_quark;
+
+/* ...camera buffer released by compositor */
+static void __objdet_plane_release(void *cookie)
+{
+    gst_buffer_unref((GstBuffer *)cookie);
+}
+
+/* ...present camera buffer on compositor plane (buffer is held until released) */
+static int objdet_plane_present(app_data_t *app, GstBuffer *buffer)
+{
+    plane_buffer_t     *plane = gst_mini_object_get_qdata(GST_MINI_OBJECT(buffer), __objdet_plane_quark);
+    cairo_matrix_t     *m = &app->matrix;
+    int                 x, y, w, h, r;
+
+    /* ...buffer is not wrapped, or plane mode got disabled */
+    if (!plane || !(app->configuration & APP_FLAG_CAMERA_PLANE))    return -ENOENT;
+
+    /* ...camera image rectangle in window coordinates (same as overlay graphics) */
+    x = (int)m->x0, y = (int)m->y0;
+    w = (int)(app->f_width * m->xx + 0.5), h = (int)(app->f_height * m->yy + 0.5);
+
+    /* ...take reference before release notification may arrive */
+    gst_buffer_ref(buffer);
+
+    if ((r = window_plane_present(app->window, plane, x, y, w, h, __objdet_plane_release, buffer)) < 0)
+    {
+        TRACE(INFO, _b("camera plane is not available; use GL drawing"));
+        gst_buffer_unref(buffer);
+
+        /* ...configuration is shared with streaming thread */
+        pthread_mutex_lock(&app->lock);
+        app->configuration &= ~APP_FLAG_CAMERA_PLANE;
+        pthread_mutex_unlock(&app->lock);
+        return r;
+    }
+
+    return 0;
+}
+
 /* ...buffer allocation from frontal camera (object detection engine) */
 static int objdet_input_alloc(void *data, GstBuffer *buffer)
 {
@@ -419,7 +764,27 @@ static int objdet_input_alloc(void *data, GstBuffer *buffer)
     }
 
     /* ...allocate texture to wrap the buffer */
-    CHK_ERR(vmeta->priv = texture_create(w, h, vmeta->plane, vmeta->format), -errno);
+    CHK_ERR(vmeta->priv = texture_create_dmabuf(w, h, vmeta->plane, vmeta->dmafd, vmeta->stride, vmeta->offset, vmeta->modifier, vmeta->format), -errno);
+
+    /* ...wrap buffer for compositor presentation if requested (texture is still used by engine) */
+    if (app->configuration & APP_FLAG_CAMERA_PLANE)
+    {
+        plane_buffer_t     *plane = plane_buffer_create(w, h, vmeta->dmafd, vmeta->stride, vmeta->offset, vmeta->modifier, vmeta->format);
+
+        if (plane)
+        {
+            gst_mini_object_set_qdata(GST_MINI_OBJECT(buffer), __objdet_plane_quark, plane, (GDestroyNotify)plane_buffer_destroy);
+        }
+        else
+        {
+            TRACE(INFO, _b("camera plane not supported (%m); use GL drawing"));
+
+            /* ...configuration is shared with render thread */
+            pthread_mutex_lock(&app->lock);
+            app->configuration &= ~APP_FLAG_CAMERA_PLANE;
+            pthread_mutex_unlock(&app->lock);
+        }
+    }
 
     /* ...add custom buffer metadata */
     CHK_ERR(ometa = gst_buffer_add_objdet_meta(buffer), -(errno = ENOMEM));
@@ -504,19 +869,26 @@ static void objdet_redraw(display_data_t *display, void *data)
         texture_data_t     *texture = vmeta->priv;
         float               fps = window_frame_rate_update(window);
         cairo_t            *cr;
+        int                 plane, gui;
 
         /* ...add some performance monitors here - tbd */
         TRACE(INFO, _b("redraw frame: %u"), app->frame_num++);
 
 		/* ...clear buffer before drawing anything */
+        window_gpu_stage(window, WINDOW_GPU_STAGE_CLEAR);
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 		glClearDepthf(1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-        /* ...output buffer on screen */
-        texture_draw(texture, &app->view, NULL, 1.0);
+        /* ...output buffer on screen (camera plane is composed below transparent window) */
+        window_gpu_stage(window, WINDOW_GPU_STAGE_OVERLAY);
+        if (!(plane = (objdet_plane_present(app, buffer) == 0)))
+        {
+            texture_draw(texture, &app->view, NULL, 1.0);
+        }
 
         /* ...get cairo drawing context */
+        window_gpu_stage(window, WINDOW_GPU_STAGE_GUI);
         cr = window_get_cairo(window);
 
         /* ...set cairo transformation matrix for a given view-port - tbd */
@@ -534,10 +906,12 @@ static void objdet_redraw(display_data_t *display, void *data)
         /* ...output current vehicle status? - use unprocessed frame, maybe... */
         if (app->flags & APP_FLAG_DEBUG)
         {
+            text_batch_t   *text = app->views[0].text;
+
             /* ...output frame-rate in the upper-left corner */
-            cairo_set_source_rgba(cr, 1, 1, 1, 0.5);
-            cairo_move_to(cr, 40, 80);
-            draw_string(cr, "%.1f FPS", fps);
+            text_batch_reset(text);
+            text_batch_printf(text, 40, 80, 0xFFFFFF80, "%.1f FPS", fps);
+            text_batch_draw(text, window, cr);
         }
         else
         {
@@ -545,11 +919,21 @@ static void objdet_redraw(display_data_t *display, void *data)
         }
 
         /* ...output GUI graphics as needed */
-        gui_redraw(app->gui, cr);
+        gui = gui_redraw(app->gui, cr);
 
         /* ...release cairo drawing context */
         window_put_cairo(window, cr);
 
+        /* ...with camera on a plane only overlays within camera area change (unless GUI dims the window) */
+        if (plane && !gui && !app->gui_shown && !(app->flags & APP_FLAG_DEBUG))
+        {
+            cairo_matrix_t     *m = &app->matrix;
+
+            window_add_damage(window, (int)m->x0, (int)m->y0, (int)(app->f_width * m->xx + 0.5), (int)(app->f_height * m->yy + 0.5));
+        }
+
+        app->gui_shown = gui;
+
         /* ...submit window to composer */
         window_draw(window);
 
@@ -557,6 +941,12 @@ static void objdet_redraw(display_data_t *display, void *data)
         gst_buffer_unref(buffer);
     }
 
+    /* ...return last presented buffer to the pool when stream is over */
+    if (app->flags & APP_FLAG_EOS)
+    {
+        window_plane_hide(window);
+    }
+
     TRACE(DEBUG, _b("frontal camera drawing complete.."));
 }
 
@@ -568,6 +958,9 @@ int objdet_camera_init(app_data_t *app, camera_init_func_t camera_init)
     /* ...clear input stream dimensions (force engine reinitialization) */
     app->f_width = app->f_height = 0;
 
+    /* ...register quark for compositor plane buffers */
+    (!__objdet_plane_quark ? __objdet_plane_quark = g_quark_from_static_string("objdet-plane") : 0);
+
     /* ...create camera interface (it may be network camera or file on disk) */
     CHK_ERR(bin = camera_init(&objdet_camera_cb, app), -errno);
 
@@ -624,64 +1017,225 @@ static track_desc_t * __app_objdet_track(app_data_t *app)
 #endif
 
 /*******************************************************************************
- * Rendering functions
+ * Performance HUD
  ******************************************************************************/
 
-/* ...draw multiline string - hmm; need to put that stuff into display */
-static inline void draw_string(cairo_t *cr, const char *fmt, ...)
+/* ...HUD sampling period (in microseconds) */
+#define APP_HUD_PERIOD                  250000
+
+/* ...graph sample pitch and graph dimensions (in pixels) */
+#define APP_HUD_STEP                    4
+#define APP_HUD_GRAPH_WIDTH             ((APP_HUD_SAMPLES - 1) * APP_HUD_STEP)
+#define APP_HUD_GRAPH_HEIGHT            40
+
+/* ...global metrics graphs (follow per-camera input rate graphs) */
+static const struct app_hud_graph
 {
-	char                    buffer[4096], *p, *end;
-	cairo_text_extents_t    text_extents;
-	cairo_font_extents_t    font_extents;
-	va_list                 argp;
+    /* ...graph label */
+    const char         *name;
+
+    /* ...graph line color (0xRRGGBBAA) */
+    u32                 color;
+
+    /* ...minimal full-scale value */
+    float               scale;
+
+}   __hud_graphs[APP_HUD_GRAPHS - CAMERAS_NUMBER] = {
+    { "skew, ms",           0xFFC040C0, 1 },
+    { "queue depth",        0x40C0FFC0, 2 },
+    { "drops, fps",         0xFF4040C0, 1 },
+    { "cpu clear, ms",      0xC0C0C0C0, 1 },
+    { "cpu scene, ms",      0x40FF40C0, 1 },
+    { "cpu gui, ms",        0x4080FFC0, 1 },
+    { "swap, ms",           0xFF80FFC0, 1 },
+    { "gpu, ms",            0xFFFF40C0, 1 },
+};
 
-	cairo_save(cr);
-	cairo_select_font_face(cr, "sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-	cairo_set_font_size(cr, 40);
-	cairo_font_extents(cr, &font_extents);
+/* ...average per-frame time in milliseconds */
+static inline float __hud_avg(u32 us, u32 frames)
+{
+    return (frames ? us / 1000.0f / frames : 0);
+}
 
-	va_start(argp, fmt);
-	vsnprintf(buffer, sizeof(buffer), fmt, argp);
-	va_end(argp);
+/* ...take HUD sample; returns non-zero if graphs need to be rebuilt */
+static int app_hud_sample(app_data_t *app, window_data_t *window)
+{
+    app_hud_t          *hud = &app->hud;
+    u32                 now = __get_time_usec();
+    u32                 delta;
+    u32                 input[CAMERAS_NUMBER], dropped, skew, depth;
+    u32                 frames, gpu_frames, gpu_us;
+    window_cpu_stats_t  cpu;
+    window_gpu_stats_t  gpu;
+    float               v[APP_HUD_GRAPHS], k;
+    int                 i;
 
-    for (p = buffer; *p; p = end + 1)
+    pthread_mutex_lock(&app->lock);
+
+    /* ...restart sampling with empty history if requested (history is owned by render thread) */
+    if (hud->reset)
     {
-        /* ...output single line */
-		((end = strchr(p, '\n')) != NULL ? *end = 0 : 0);
-		cairo_show_text(cr, p);
-		cairo_text_extents (cr, p, &text_extents);
-		cairo_rel_move_to (cr, -text_extents.x_advance, font_extents.height);
-        TRACE(0, _b("print text-line: <%f,%f>"), text_extents.x_advance, font_extents.height);
+        hud->reset = 0;
+        hud->ts = 0, hud->num = hud->pos = 0;
+    }
+
+    /* ...graphs are updated at much lower rate than the scene */
+    delta = now - hud->ts;
+
+    if (hud->ts != 0 && delta < APP_HUD_PERIOD)
+    {
+        pthread_mutex_unlock(&app->lock);
+        return 0;
+    }
 
-        /* ...stop when last line processes */
-        if (!end)   break;
+    /* ...collect counters accumulated by streaming threads */
+    memcpy(input, hud->input, sizeof(input)), memset(hud->input, 0, sizeof(hud->input));
+    dropped = hud->dropped, skew = hud->skew, depth = hud->depth;
+    hud->dropped = hud->skew = hud->depth = 0;
+    pthread_mutex_unlock(&app->lock);
+
+    /* ...GPU statistics are zero if timer queries are not available */
+    window_get_cpu_stats(window, &cpu);
+    window_get_gpu_stats(window, &gpu);
+
+    /* ...first sample defines reference point only */
+    if (hud->ts == 0)
+    {
+        hud->cpu = cpu, hud->gpu = gpu, hud->ts = now;
+        return 1;
     }
 
-    /* ...restore drawing context */
-	cairo_restore(cr);
+    k = 1e+06 / delta;
+    frames = cpu.frames - hud->cpu.frames;
+    gpu_frames = gpu.frames - hud->gpu.frames;
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        v[i] = input[i] * k;
+    }
+
+    for (i = 0, gpu_us = 0; i < WINDOW_GPU_STAGES; i++)
+    {
+        gpu_us += gpu.stage[i].total - hud->gpu.stage[i].total;
+    }
+
+    v[CAMERAS_NUMBER + 0] = skew / 1000.0f;
+    v[CAMERAS_NUMBER + 1] = depth;
+    v[CAMERAS_NUMBER + 2] = dropped * k;
+    v[CAMERAS_NUMBER + 3] = __hud_avg(cpu.stage[WINDOW_GPU_STAGE_CLEAR] - hud->cpu.stage[WINDOW_GPU_STAGE_CLEAR], frames);
+    v[CAMERAS_NUMBER + 4] = __hud_avg(cpu.stage[WINDOW_GPU_STAGE_SCENE] - hud->cpu.stage[WINDOW_GPU_STAGE_SCENE], frames);
+    v[CAMERAS_NUMBER + 5] = __hud_avg(cpu.stage[WINDOW_GPU_STAGE_GUI] - hud->cpu.stage[WINDOW_GPU_STAGE_GUI], frames);
+    v[CAMERAS_NUMBER + 6] = __hud_avg(cpu.swap - hud->cpu.swap, frames);
+    v[CAMERAS_NUMBER + 7] = __hud_avg(gpu_us, gpu_frames);
+
+    /* ...append sample to history rings */
+    for (i = 0; i < APP_HUD_GRAPHS; i++)
+    {
+        hud->graph[i][hud->pos] = v[i];
+    }
+
+    hud->pos = (hud->pos + 1) % APP_HUD_SAMPLES;
+    (hud->num < APP_HUD_SAMPLES ? hud->num++ : 0);
+
+    hud->cpu = cpu, hud->gpu = gpu, hud->ts = now;
+
+    return 1;
 }
 
-/* ...surround-view scene rendering */
-static void sview_redraw(display_data_t *display, void *data)
+/* ...rebuild HUD labels and graphs from sampled history */
+static void app_hud_build(app_data_t *app)
 {
-    app_data_t         *app = data;
-    window_data_t      *window = app->window;
+    app_hud_t          *hud = &app->hud;
+    text_batch_t       *batch = hud->batch;
+    overlay_t          *overlay = hud->overlay;
+    int                 h = text_font_height(hud->font);
+    float               xy[2 * APP_HUD_SAMPLES];
+    int                 i, j;
+
+    text_batch_reset(batch);
+    overlay_reset(overlay);
+
+    for (i = 0; i < APP_HUD_GRAPHS; i++)
+    {
+        const struct app_hud_graph *g = (i >= CAMERAS_NUMBER ? &__hud_graphs[i - CAMERAS_NUMBER] : NULL);
+        float  *r = hud->graph[i];
+        float   last = (hud->num ? r[(hud->pos + APP_HUD_SAMPLES - 1) % APP_HUD_SAMPLES] : 0);
+        float   max = 0, scale = (g ? g->scale : 10);
+        int     x = 40 + (i & 1) * (APP_HUD_GRAPH_WIDTH + 40);
+        int     y = 120 + (i >> 1) * (APP_HUD_GRAPH_HEIGHT + h + 8);
+
+        /* ...valid samples occupy first "num" ring entries */
+        for (j = 0; j < hud->num; j++)
+        {
+            (r[j] > max ? max = r[j] : 0);
+        }
+
+        /* ...label with latest and peak values */
+        if (g)
+        {
+            text_batch_printf(batch, x, y + h * 4 / 5, 0xFFFFFFC0, "%s: %.1f (%.1f)", g->name, last, max);
+        }
+        else
+        {
+            text_batch_printf(batch, x, y + h * 4 / 5, 0xFFFFFFC0, "cam-%d, fps: %.1f (%.1f)", i, last, max);
+        }
+
+        (max < scale ? max = scale : 0);
+        y += h + 4;
+
+        /* ...graph background */
+        overlay_box(overlay, x, y, APP_HUD_GRAPH_WIDTH, APP_HUD_GRAPH_HEIGHT, 0, 0x00000080);
+
+        /* ...graph line from oldest to newest sample (right-aligned) */
+        for (j = 0; j < hud->num; j++)
+        {
+            float   s = r[(hud->pos + APP_HUD_SAMPLES - hud->num + j) % APP_HUD_SAMPLES];
+
+            xy[2 * j] = x + (APP_HUD_SAMPLES - hud->num + j) * APP_HUD_STEP;
+            xy[2 * j + 1] = y + APP_HUD_GRAPH_HEIGHT * (1 - s / max);
+        }
+
+        overlay_polyline(overlay, xy, hud->num, 0, 2, g ? g->color : 0x40FFC0C0);
+    }
+}
+
+/* ...draw performance HUD (render thread of the main view) */
+static void app_hud_draw(app_data_t *app, window_data_t *window, cairo_t *cr)
+{
+    /* ...primitives are rebuilt at sampling rate only; cached streams are redrawn otherwise */
+    if (app_hud_sample(app, window))
+    {
+        app_hud_build(app);
+    }
+
+    /* ...graphs and labels take one draw call each */
+    overlay_draw(app->hud.overlay, window, cr);
+    text_batch_draw(app->hud.batch, window, cr);
+}
+
+/*******************************************************************************
+ * Rendering functions
+ ******************************************************************************/
+
+/* ...surround-view scene rendering in a view */
+static void __sview_view_redraw(app_data_t *app, app_view_t *view)
+{
+    window_data_t      *window = view->window;
     int                 W = window_get_width(window);
     int                 H = window_get_height(window);
-    GstBuffer          *buffers[CAMERAS_NUMBER];
-    texture_data_t     *texture[CAMERAS_NUMBER];
-    GLuint              tex[CAMERAS_NUMBER];
-    void               *planes[CAMERAS_NUMBER];
-    s64                 ts;
-    
+    int                 primary = (view == &app->views[0]);
+    const layout_cell_t *cell = (__layout.num ? layout_scene_cell(&__layout) : NULL);
+    sview_frame_t      *frame;
+    int                 eos;
 
-    /* ...try to get buffers */
-    while(sview_pop_buffers(app, buffers, texture, tex, planes, &ts))
+    /* ...try to get latest frame-set (each view is paced by its own output) */
+    while ((frame = sview_frame_get(app, view)) != NULL)
     {
         float       fps = window_frame_rate_update(window);
         cairo_t    *cr;
         
         /* ...ready for rendering; clear surface content */
+        window_gpu_stage(window, WINDOW_GPU_STAGE_CLEAR);
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 		glClearDepthf(1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -690,29 +1244,57 @@ static void sview_redraw(display_data_t *display, void *data)
         if (0) glViewport(0, 0, W, H);
 
         /* ...draw graphics on top of the scene */
+        window_gpu_stage(window, WINDOW_GPU_STAGE_SCENE);
         cr = window_get_cairo(window);
 
-        /* ...generate a single scene; acquire engine access lock */
-        pthread_mutex_lock(&app->access);
-        
-        sview_engine_process(app->sv, tex, planes, cr, ts);
-        
-        pthread_mutex_unlock(&app->access);
+        /* ...confine the scene to its layout cell */
+        if (cell)   layout_cell_enter(cell, window, cr);
+
+        /* ...generate a single scene; main view engine is shared with GUI/input handlers */
+        if (primary)
+        {
+            pthread_mutex_lock(&app->access);
+            sview_engine_process(view->sv, frame->tex, frame->planes, cr, frame->ts);
+            pthread_mutex_unlock(&app->access);
+        }
+        else
+        {
+            sview_engine_process(view->sv, frame->tex, frame->planes, cr, frame->ts);
+        }
+
+        /* ...camera previews share the frame-set textures; draw them in one batch */
+        if (__layout.num)
+        {
+            if (cell)   layout_cell_leave(window, cr);
+            layout_draw_previews(&__layout, window, frame->textures, CAMERAS_NUMBER, frame->width, frame->height);
+        }
+
+        /* ...2D overlays and GUI */
+        window_gpu_stage(window, WINDOW_GPU_STAGE_GUI);
+
+        /* ...textures are consumed; release buffers as soon as GPU reads complete */
+        sview_frame_release(view, frame);
 
         /* ...output frame-rate in the upper-left corner */
         if(app->flags & APP_FLAG_DEBUG)
         {
-            cairo_set_source_rgba(cr, 1, 1, 1, 0.5);
-            cairo_move_to(cr, 40, 80);
-            draw_string(cr, "%.1f FPS", fps);
+            text_batch_reset(view->text);
+            text_batch_printf(view->text, 40, 80, 0xFFFFFF80, "%.1f FPS", fps);
+            text_batch_draw(view->text, window, cr);
         }
         else
         {
-            TRACE(DEBUG, _b("main-window fps: %.1f"), fps);
+            TRACE(DEBUG, _b("view-%d fps: %.1f"), (int)(view - app->views), fps);
         }
         
-        /* ...output GUI graphics as needed */
-        gui_redraw(app->gui, cr);
+        /* ...output performance HUD (main window only) */
+        if (primary && (app->flags & APP_FLAG_HUD))
+        {
+            app_hud_draw(app, window, cr);
+        }
+
+        /* ...output GUI graphics as needed (main window only) */
+        if (primary)    gui_redraw(app->gui, cr);
         
         /* ...release cairo interface */
         window_put_cairo(window, cr);
@@ -720,22 +1302,52 @@ static void sview_redraw(display_data_t *display, void *data)
         /* ...submit window to a compositor */
         window_draw(window);
 
-        /* ...release buffers collected */
-        sview_release_buffers(app, buffers);
+        /* ...return buffers whose reads have completed meanwhile */
+        sview_retire_frames(view, 0);
     }
 
+    /* ...on termination make sure all buffers are returned before pipeline stops */
+    pthread_mutex_lock(&app->lock);
+    eos = ((app->flags & APP_FLAG_EOS) != 0);
+    pthread_mutex_unlock(&app->lock);
+    sview_retire_frames(view, eos);
+
     TRACE(DEBUG, _b("surround-view drawing complete"));
 }
 
+/* ...main window rendering hook */
+static void sview_redraw(display_data_t *display, void *data)
+{
+    app_data_t         *app = data;
+
+    __sview_view_redraw(app, &app->views[0]);
+}
+
+/* ...auxiliary output rendering hook */
+static void sview_aux_redraw(display_data_t *display, void *data)
+{
+    app_view_t         *view = data;
+
+    __sview_view_redraw(view->app, view);
+}
+
 static void sview_init_bv(display_data_t *display, void *data)
 {
     app_data_t         *app = data;
     /* ...generate a single scene; acquire engine access lock */
     pthread_mutex_lock(&app->access);
-    app->sv = sview_bv_reinit(app->sv, app->sv_cfg, 1280, 800);
+    app->views[0].sv = sview_bv_reinit(app->views[0].sv, app->sv_cfg, 1280, 800);
     pthread_mutex_unlock(&app->access);
 }
 
+/* ...auxiliary view engine reconfiguration (engine is private to the view thread) */
+static void sview_aux_init_bv(display_data_t *display, void *data)
+{
+    app_view_t         *view = data;
+
+    view->sv = sview_bv_reinit(view->sv, view->app->sv_cfg, 1280, 800);
+}
+
 /*******************************************************************************
  * Runtime initialization
  ******************************************************************************/
@@ -825,14 +1437,49 @@ static int app_context_init(widget_data_t *widget, void *data)
     window_data_t  *window = (window_data_t *)widget;
     int             W = widget_get_width(widget);
     int             H = widget_get_height(widget);
+    int             r;
     
     /* ...initialize surround-view engine (dimensions are fixed?) */
-    CHK_ERR(app->sv = sview_engine_init(app->sv_cfg, 1280, 800), -errno);
+    CHK_ERR(app->views[0].sv = sview_engine_init(app->sv_cfg, 1280, 800), -errno);
+
+    /* ...rasterize overlay font; atlas texture is shared by all windows */
+    if ((app->font = text_font_create("sans", 40)) == NULL)
+    {
+        r = -errno;
+        goto error_sv;
+    }
+
+    if ((app->views[0].text = text_batch_create(app->font, 256)) == NULL)
+    {
+        r = -errno;
+        goto error_font;
+    }
+
+    /* ...performance HUD labels (~400 glyphs) and graphs (background and segment per sample) */
+    if ((app->hud.font = text_font_create("monospace", 16)) == NULL)
+    {
+        r = -errno;
+        goto error_text;
+    }
+
+    if ((app->hud.batch = text_batch_create(app->hud.font, 1024)) == NULL)
+    {
+        r = -errno;
+        goto error_hud_font;
+    }
+
+    if ((app->hud.overlay = overlay_create(APP_HUD_GRAPHS * (APP_HUD_SAMPLES + 1) * 6)) == NULL)
+    {
+        r = -errno;
+        goto error_hud_batch;
+    }
 
-    
-    
     /* ...create UI layer */
-    CHK_ERR(app->gui = gui_create(window, app), -errno);
+    if ((app->gui = gui_create(window, app)) == NULL)
+    {
+        r = -errno;
+        goto error_hud_overlay;
+    }
 
 //    /* ...display context is shared with all windows; context is surfaceless */
 //    eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, display->egl.ctx);
@@ -848,6 +1495,47 @@ static int app_context_init(widget_data_t *widget, void *data)
     
     TRACE(INIT, _b("run-time initialized: %u*%u"), W, H);
 
+    return 0;
+
+error_hud_overlay:
+    overlay_destroy(app->hud.overlay), app->hud.overlay = NULL;
+
+error_hud_batch:
+    text_batch_destroy(app->hud.batch), app->hud.batch = NULL;
+
+error_hud_font:
+    text_font_destroy(app->hud.font), app->hud.font = NULL;
+
+error_text:
+    text_batch_destroy(app->views[0].text), app->views[0].text = NULL;
+
+error_font:
+    text_font_destroy(app->font), app->font = NULL;
+
+error_sv:
+    sview_engine_destroy(app->views[0].sv), app->views[0].sv = NULL;
+    return r;
+}
+
+/* ...initialize GL-processing context of auxiliary output */
+static int app_aux_context_init(widget_data_t *widget, void *data)
+{
+    app_view_t     *view = data;
+
+    /* ...engine GL objects are per-context; camera textures are shared */
+    CHK_ERR(view->sv = sview_engine_init(view->app->sv_cfg, 1280, 800), -errno);
+
+    /* ...per-view text batch uses the font of the main window */
+    if ((view->text = text_batch_create(view->app->font, 256)) == NULL)
+    {
+        int     r = -errno;
+
+        sview_engine_destroy(view->sv), view->sv = NULL;
+        return r;
+    }
+
+    TRACE(INIT, _b("view-%d initialized: %u*%u"), (int)(view - view->app->views), widget_get_width(widget), widget_get_height(widget));
+
     return 0;
 }
 
@@ -864,7 +1552,7 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
         if (event->e->type == SPNAV_EVENT_MOTION)
         {
             pthread_mutex_lock(&app->access);
-            sview_engine_spnav_event(app->sv, event->e);
+            sview_engine_spnav_event(app->views[0].sv, event->e);
             pthread_mutex_unlock(&app->access);
         }
     }
@@ -887,15 +1575,15 @@ static inline widget_data_t * app_touch_event(app_data_t *app, widget_data_t *wi
         switch (event->type)
         {
         case WIDGET_EVENT_TOUCH_DOWN:
-            sview_engine_touch(app->sv, TOUCH_DOWN, event->id, event->x, event->y);
+            sview_engine_touch(app->views[0].sv, TOUCH_DOWN, event->id, event->x, event->y);
             break;
             
         case WIDGET_EVENT_TOUCH_MOVE:
-            sview_engine_touch(app->sv, TOUCH_MOVE, event->id, event->x, event->y);
+            sview_engine_touch(app->views[0].sv, TOUCH_MOVE, event->id, event->x, event->y);
             break;
 
         case WIDGET_EVENT_TOUCH_UP:
-            sview_engine_touch(app->sv, TOUCH_UP, event->id, event->x, event->y);
+            sview_engine_touch(app->views[0].sv, TOUCH_UP, event->id, event->x, event->y);
             break;
         }
 
@@ -915,7 +1603,7 @@ static inline widget_data_t * app_key_event(app_data_t *app, widget_data_t *widg
         if (event->type == WIDGET_EVENT_KEY_PRESS)
         {
             TRACE(DEBUG, _b("Key pressed: %i"), event->code);
-            sview_engine_keyboard_key(app->sv, event->code, event->state);
+            sview_engine_keyboard_key(app->views[0].sv, event->code, event->state);
         }
     }
     else
@@ -942,15 +1630,15 @@ static inline widget_data_t * app_mouse_event(app_data_t *app, widget_data_t *wi
     {
         if (event->type == WIDGET_EVENT_MOUSE_BUTTON)
         {
-            sview_engine_mouse_button (app->sv, event->button, event->state);
+            sview_engine_mouse_button (app->views[0].sv, event->button, event->state);
         }
         else if (event->type == WIDGET_EVENT_MOUSE_MOVE)
           {
-            sview_engine_mouse_motion (app->sv, event->x, event->y);
+            sview_engine_mouse_motion (app->views[0].sv, event->x, event->y);
           }
         else if (event->type == WIDGET_EVENT_MOUSE_AXIS)
           {
-            sview_engine_mouse_wheel (app->sv, event->axis, event->value);
+            sview_engine_mouse_wheel (app->views[0].sv, event->axis, event->value);
           }
     }
     else
@@ -1039,6 +1727,53 @@ static gboolean app_bus_callback(GstBus *bus, GstMessage *message, gpointer data
         break;
     }
 
+    case GST_MESSAGE_ASYNC_DONE:
+    {
+        /* ...pipeline prerolled; switch to segment / rate playback if requested */
+        if (app->loop_state == APP_LOOP_PENDING)
+        {
+            if (app_loop_seek(app, 1) == 0)
+            {
+                TRACE(INFO, _b("track seek activated (loop=%d, rate=%.2f)"), !!(app->flags & APP_FLAG_LOOP), video_stream_rate);
+                app->loop_state = APP_LOOP_ACTIVE;
+            }
+            else
+            {
+                /* ...source is not seekable; fall back to end-of-stream processing */
+                app->loop_state = APP_LOOP_NONE;
+            }
+        }
+
+        break;
+    }
+
+    case GST_MESSAGE_SEGMENT_DONE:
+    {
+        /* ...end of segment reached by all streams; rewind to the beginning */
+        pthread_mutex_lock(&app->lock);
+        app->loop_ts = __get_time_usec(), app->loop_count++;
+        pthread_mutex_unlock(&app->lock);
+
+        /* ...non-flushing seek keeps pools, textures and engine alive */
+        if (app_loop_seek(app, 0) < 0)
+        {
+            /* ...cannot continue looping; treat as end-of-stream */
+            app->loop_state = APP_LOOP_NONE;
+            g_main_loop_quit(loop);
+        }
+
+        break;
+    }
+
+    case GST_MESSAGE_QOS:
+    {
+        /* ...frame dropped by a sink as too late */
+        pthread_mutex_lock(&app->lock);
+        app->rate_late++, app->hud.dropped++;
+        pthread_mutex_unlock(&app->lock);
+        break;
+    }
+
     case GST_MESSAGE_STATE_CHANGED:
     {
         /* ...state has changed; test if it is start or stop */
@@ -1080,6 +1815,18 @@ static widget_info_t app_main_info2 = {
     .event = app_input_event,
 };
 
+/* ...auxiliary output window parameters (surround-view scene mirror) */
+static window_info_t app_aux_info = {
+    .fullscreen = 1,
+    .redraw = sview_aux_redraw,
+    .init_bv = sview_aux_init_bv,
+};
+
+/* ...auxiliary output widget parameters (no input processing) */
+static widget_info_t app_aux_info2 = {
+    .init = app_aux_context_init,
+};
+
 /* ...start surround-view track */
 static track_desc_t * __app_sview_track(app_data_t *app)
 {
@@ -1156,7 +1903,10 @@ void * app_thread(void *arg)
                 {
                   app->sv_cfg->cam_names[i] = track->camera_names[i];
                 }
-              window_reinit_bv (app->window);
+              for (i = 0; i < app->views_num; i++)
+                {
+                  window_reinit_bv (app->views[i].window);
+                }
             }
             
 #ifdef ENABLE_OBJDET
@@ -1165,6 +1915,13 @@ void * app_thread(void *arg)
         /* ...start a selected track (ignore error) */
         app_track_start(app, track, 1);
 
+        /* ...offline tracks are looped / rate-adjusted with seeks once prerolled */
+        app->loop_state = (track->file && ((app->flags & APP_FLAG_LOOP) || video_stream_rate != 1.0) ? APP_LOOP_PENDING : APP_LOOP_NONE);
+        app->loop_ts = 0;
+
+        /* ...reset playback rate statistics */
+        app->rate_ts = 0, app->rate_pkt_ts = 0;
+
         /* ...release internal data access lock */
         pthread_mutex_unlock(&app->lock);
 
@@ -1182,8 +1939,8 @@ void * app_thread(void *arg)
         /* ...put end-of-stream flag */
         app->flags |= APP_FLAG_EOS;
 
-        /* ...kick renderer window to drop all buffers */
-        window_schedule_redraw(app->window);
+        /* ...kick renderer windows to drop all buffers */
+        app_views_schedule_redraw(app);
 
         TRACE(INFO, _b("track '%s' completed"), (track->info ? : "default"));
 
@@ -1233,7 +1990,7 @@ void app_eos(app_data_t *app)
 void app_packet_receive(app_data_t *app, int id, u8 *pdu, u16 len, u64 ts)	 
 {	 
     /* ...pass packet to the camera bin */	 
-    camera_mjpeg_packet_receive(id, pdu, len, ts); 
+    camera_mjpeg_packet_receive(id, pdu, len, app_rate_scale_ts(app, ts)); 
 }
 #endif
 
@@ -1251,6 +2008,9 @@ static inline float steering_wheel_degree(u8 *p)
 void app_can_message_receive(app_data_t *app, u32 can_id, u8 *msg, u8 dlc, u64 ts)
 {
     vehicle_info_t     *info = &app->vehicle;
+
+    /* ...keep vehicle information time aligned with accelerated video */
+    app->vehicle_ts = app_rate_scale_ts(app, ts);
     
     switch (can_id)
     {
@@ -1326,7 +2086,7 @@ void app_can_message_receive(app_data_t *app, u32 can_id, u8 *msg, u8 dlc, u64 t
 void sview_sphere_enable(app_data_t *app, int enable)
 {
     pthread_mutex_lock(&app->access);
-    sview_engine_keyboard_key(app->sv, KEY_H, 1);
+    sview_engine_keyboard_key(app->views[0].sv, KEY_H, 1);
     pthread_mutex_unlock(&app->access);
 }
 
@@ -1353,31 +2113,31 @@ void app_live_enable(app_data_t *app, int enable)
 void sview_set_view(app_data_t *app, int view)
 {
     pthread_mutex_lock(&app->access);
-    sview_engine_keyboard_key(app->sv, (view ? KEY_9 : KEY_0), 1);
+    sview_engine_keyboard_key(app->views[0].sv, (view ? KEY_9 : KEY_0), 1);
     pthread_mutex_unlock(&app->access);
 }
 
 void sview_adjust(app_data_t *app) {
     pthread_mutex_lock(&app->access);
-    sview_engine_keyboard_key(app->sv, KEY_Q, 1);
+    sview_engine_keyboard_key(app->views[0].sv, KEY_Q, 1);
     pthread_mutex_unlock(&app->access);
 }
 
 void sview_calibrate(app_data_t *app) {
     pthread_mutex_lock(&app->access);
-    sview_engine_keyboard_key(app->sv, KEY_C, 1);
+    sview_engine_keyboard_key(app->views[0].sv, KEY_C, 1);
     pthread_mutex_unlock(&app->access);
 }
 
 void sview_load_calibration(app_data_t *app) {
     pthread_mutex_lock(&app->access);
-    sview_engine_keyboard_key(app->sv, KEY_8, 1);
+    sview_engine_keyboard_key(app->views[0].sv, KEY_8, 1);
     pthread_mutex_unlock(&app->access);
 }
 
 void sview_escape(app_data_t *app) {
     pthread_mutex_lock(&app->access);
-    sview_engine_keyboard_key(app->sv, KEY_ESC, 1);
+    sview_engine_keyboard_key(app->views[0].sv, KEY_ESC, 1);
     pthread_mutex_unlock(&app->access);
 }
 
@@ -1446,6 +2206,24 @@ void app_debug_enable(app_data_t *app, int enable)
     TRACE(INFO, _b("debug-data output enable: %d"), enable);
 }
 
+/* ...enable performance HUD */
+void app_hud_enable(app_data_t *app, int enable)
+{
+    pthread_mutex_lock(&app->lock);
+
+    if (enable)
+        app->flags |= APP_FLAG_HUD;
+    else
+        app->flags &= ~APP_FLAG_HUD;
+
+    /* ...restart sampling with empty history (served by render thread) */
+    app->hud.reset = 1;
+
+    pthread_mutex_unlock(&app->lock);
+
+    TRACE(INFO, _b("performance HUD enable: %d"), enable);
+}
+
 /* ...close application */
 void app_exit(app_data_t *app)
 {
@@ -1464,6 +2242,26 @@ void app_exit(app_data_t *app)
  * Module entry-points
  ******************************************************************************/
 
+/* ...destroy output views and rendering resources shared by them */
+static void app_views_destroy(app_data_t *app)
+{
+    /* ...main window is the first view; text batch is used until window is gone */
+    while (app->views_num-- > 0)
+    {
+        app_view_t     *view = &app->views[app->views_num];
+
+        (view->sv ? sview_engine_destroy(view->sv) : 0);
+        window_destroy(view->window);
+        if (view->text)     text_batch_destroy(view->text);
+    }
+
+    /* ...fonts and HUD primitives outlive all windows */
+    if (app->hud.overlay)   overlay_destroy(app->hud.overlay);
+    if (app->hud.batch)     text_batch_destroy(app->hud.batch);
+    if (app->hud.font)      text_font_destroy(app->hud.font);
+    if (app->font)          text_font_destroy(app->font);
+}
+
 /* ...module destructor */
 static void app_destroy(gpointer data, GObject *obj)
 {
@@ -1471,18 +2269,24 @@ static void app_destroy(gpointer data, GObject *obj)
 
     TRACE(INIT, _b("destruct module"));
 
+    /* ...complete outstanding copy-uploads while renderer is still alive */
+    texture_upload_stop();
+
+    /* ...terminate widget rasterizer; layers are redrawn by render thread afterwards */
+    widget_rasterizer_stop();
+
     /* ...destroy main loop */
     g_main_loop_unref(app->loop);
 
     /* ...destroy GUI layer */
     (app->gui ? widget_destroy(app->gui) : 0);
 
-    /* ...destroy surround-view engine data */
-    (app->sv ? sview_engine_destroy(app->sv) : 0);
-    
-    /* ...destroy main application window */
-    (app->window ? window_destroy(app->window) : 0);
-    
+    /* ...drop published frame-set */
+    if (app->frame)     sview_frame_unref(app->frame);
+
+    /* ...destroy output views and fonts */
+    app_views_destroy(app);
+
     /* ...free application data structure */
     free(app);
 
@@ -1516,6 +2320,7 @@ app_data_t * app_init(display_data_t *display, sview_cfg_t *sv_cfg, int flags)
 {
     app_data_t     *app;
     GstElement     *pipe;
+    int             i;
 
     /* ...create local data handle */
     CHK_ERR(app = calloc(1, sizeof(*app)), (errno = ENOMEM, NULL));
@@ -1546,6 +2351,30 @@ app_data_t * app_init(display_data_t *display, sview_cfg_t *sv_cfg, int flags)
         TRACE(ERROR, _x("failed to create main window: %m"));
         goto error;
     }
+    else
+    {
+        /* ...main window is the first output view */
+        app->views[0].app = app, app->views[0].window = app->window;
+        app->views_num = 1;
+    }
+
+    /* ...create auxiliary outputs; camera textures are shared across all contexts */
+    for (i = 0; i < __output_aux_num; i++)
+    {
+        app_view_t     *view = &app->views[app->views_num];
+
+        app_aux_info.output = __output_aux[i];
+        app_aux_info.transform = __output_transform;
+        view->app = app;
+
+        if ((view->window = window_create(display, &app_aux_info, &app_aux_info2, view)) == NULL)
+        {
+            TRACE(ERROR, _x("failed to create window on output %d: %m"), __output_aux[i]);
+            goto error_window;
+        }
+
+        app->views_num++;
+    }
 
     /* ...create main loop object (use default context) */
     if ((app->loop = g_main_loop_new(NULL, FALSE)) == NULL)
@@ -1595,9 +2424,9 @@ error_loop:
     g_main_loop_unref(app->loop);
 
 error_window:
-    /* ...destroy main application window */
-    window_destroy(app->window);
-    
+    /* ...destroy output views and fonts */
+    app_views_destroy(app);
+
 error:
     /* ...destroy data handle */
     free(app);
@@ -180,8 +180,8 @@ extern void sview_exit(sview_data_t *sv);
 /* ...GUI initialization function */
 extern widget_data_t * gui_create(window_data_t *window, sview_data_t *sv);
 
-/* ...draw GUI layer */
-extern void gui_redraw(widget_data_t *widget, cairo_t *cr);
+/* ...draw GUI layer (returns non-zero if layer is visible) */
+extern int gui_redraw(widget_data_t *widget, cairo_t *cr);
 
 /* ...update GUI configuration */
 extern void gui_config_update(widget_data_t *widget);
@@ -69,6 +69,16 @@ typedef struct video_stream
     
 }   video_stream_t;
 
+/*******************************************************************************
+ * Global configuration
+ ******************************************************************************/
+
+/* ...offline playback rate */
+double video_stream_rate = 1.0;
+
+/* ...maximal lateness of a frame before it is dropped by accelerated playback */
+#define VIDEO_STREAM_MAX_LATENESS       (20 * GST_MSECOND)
+
 /*******************************************************************************
  * Video sink callbacks
  ******************************************************************************/
@@ -121,15 +131,48 @@ static void __stream_destructor(gpointer data, GObject *obj)
     TRACE(INIT, _b("video-stream %p destroyed"), stream);
 }
 
-/* ...decodebin dynamic pad registration callback */
-static void decodebin_pad_added(GstElement *decodebin, GstPad *pad, gpointer data)
+/* ...attach custom video sink to a decoded raw-video pad */
+static int video_stream_attach(video_stream_t *stream, GstPad *pad, GstCaps *caps)
 {
-    video_stream_t *stream = data;
     GstElement     *bin = stream->bin;
+    GstElement     *sink;
+    GstPad         *_pad;
+
+    /* ...connect custom video sink */
+    CHK_ERR(sink = video_sink_element(video_sink_create(caps, &vsink_cb, stream)), -ENOMEM);
+
+    /* ...make sink synchronized to the timestamps */
+    g_object_set(GST_OBJECT(sink), "sync", TRUE, NULL);
+
+    /* ...in accelerated mode drop late frames and let decoder skip via QoS events */
+    if (video_stream_rate != 1.0)
+    {
+        g_object_set(GST_OBJECT(sink), "qos", TRUE, "max-lateness", (gint64)VIDEO_STREAM_MAX_LATENESS, NULL);
+    }
+    
+    /* ...add sink to a stream bin */
+    gst_bin_add(GST_BIN(bin), sink);
+    /* ...link pad to an element */
+    _pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_link(pad, _pad);
+    gst_object_unref(_pad);
+
+    /* ...synchronize sink state with a pipeline */
+    gst_element_sync_state_with_parent(sink);
+    
+    TRACE(INFO, _b("added video-sink #%d to a pipe"), stream->id);
+
+    return 0;
+}
+
+/* ...check if the pad carries supported raw video (returns caps reference) */
+static GstCaps * video_pad_caps(GstPad *pad)
+{
     GstCaps        *caps;
     GstStructure   *str;
     const gchar    *name;
-       
+    GstVideoInfo    vinfo;
+
     /* ...check media type of newly created pad */
     caps = gst_pad_query_caps(pad, NULL);
     str = gst_caps_get_structure(caps, 0);
@@ -138,53 +181,194 @@ static void decodebin_pad_added(GstElement *decodebin, GstPad *pad, gpointer dat
     TRACE(INFO, _b("discovered pad: '%s'"), name);
 
     /* ...connect only raw video pads */
-    if (!g_strcmp0(name, "video/x-raw"))
+    if (g_strcmp0(name, "video/x-raw"))
     {
-        GstElement     *sink;
-        GstPad         *_pad;
-        GstVideoInfo    vinfo;
-        
-        /* ...parse video-stream parameters */
-        gst_video_info_from_caps(&vinfo, caps);
+        TRACE(INFO, _b("ignore media: %s"), name);
+        goto out;
+    }
 
-        TRACE(INFO, _b("video-info: %u * %u, format: %s"), vinfo.width, vinfo.height, vinfo.finfo->name);
+    /* ...parse video-stream parameters */
+    gst_video_info_from_caps(&vinfo, caps);
 
-        /* ...ignore media if it's not NV12 format */
-        if (strcmp(vinfo.finfo->name, "NV12") != 0)
-        {
-            TRACE(INFO, _b("ignore non-supported video format: %s"), vinfo.finfo->name);
-            goto out;
-        }
-        
-        /* ...connect custom video sink */
-        sink = video_sink_element(video_sink_create(caps, &vsink_cb, stream));
-
-        /* ...make sink synchronized to the timestamps */
-        g_object_set(GST_OBJECT(sink), "sync", TRUE, NULL);
-        
-        /* ...add sink to a stream bin */
-        gst_bin_add(GST_BIN(bin), sink);
-        /* ...link pad to an element */
-        _pad = gst_element_get_static_pad(sink, "sink");
-        gst_pad_link(pad, _pad);
-        gst_object_unref(_pad);
-
-        /* ...synchronize sink state with a pipeline */
-        gst_element_sync_state_with_parent(sink);
-        
-        TRACE(INFO, _b("added video-sink to a pipe"));
-    }
-    else
+    TRACE(INFO, _b("video-info: %u * %u, format: %s"), vinfo.width, vinfo.height, vinfo.finfo->name);
+
+    /* ...ignore media if it's not NV12 format */
+    if (strcmp(vinfo.finfo->name, "NV12") != 0)
     {
-        TRACE(INFO, _b("ignore media: %s"), name);
+        TRACE(INFO, _b("ignore non-supported video format: %s"), vinfo.finfo->name);
+        goto out;
     }
 
+    return caps;
+
 out:
     /* ...release capabilities structure */
     gst_caps_unref(caps);
+    return NULL;
 }
 
+/* ...decodebin dynamic pad registration callback */
+static void decodebin_pad_added(GstElement *decodebin, GstPad *pad, gpointer data)
+{
+    video_stream_t *stream = data;
+    GstCaps        *caps;
 
+    /* ...connect only supported raw video pads */
+    if ((caps = video_pad_caps(pad)) != NULL)
+    {
+        video_stream_attach(stream, pad, caps);
+        gst_caps_unref(caps);
+    }
+}
+
+/*******************************************************************************
+ * Single-container multi-stream playback
+ ******************************************************************************/
+
+/* ...container data (one demuxer fanned out to all camera sinks) */
+typedef struct video_container
+{
+    /* ...bin containing all internal nodes */
+    GstElement                 *bin;
+
+    /* ...application callbacks */
+    const camera_callback_t    *cb;
+
+    /* ...application data */
+    void                       *cdata;
+
+    /* ...number of camera streams expected */
+    int                         number;
+
+    /* ...number of camera streams discovered so far */
+    int                         count;
+
+}   video_container_t;
+
+/* ...container destructor */
+static void __container_destructor(gpointer data, GObject *obj)
+{
+    video_container_t  *container = data;
+
+    free(container);
+
+    TRACE(INIT, _b("video-container %p destroyed"), container);
+}
+
+/* ...decodebin pad registration callback - streams are assigned to cameras in order */
+static void container_pad_added(GstElement *decodebin, GstPad *pad, gpointer data)
+{
+    video_container_t  *container = data;
+    video_stream_t     *stream;
+    GstCaps            *caps;
+
+    /* ...connect only supported raw video pads */
+    if ((caps = video_pad_caps(pad)) == NULL)       return;
+
+    /* ...make sure we do not exceed the number of cameras */
+    if (container->count == container->number)
+    {
+        TRACE(INFO, _b("ignore extra video stream (%d cameras)"), container->number);
+        goto out;
+    }
+
+    /* ...allocate new video stream data */
+    if ((stream = malloc(sizeof(*stream))) == NULL)
+    {
+        TRACE(ERROR, _x("failed to allocate stream data"));
+        goto out;
+    }
+
+    /* ...next camera identifier */
+    stream->bin = container->bin;
+    stream->id = container->count++;
+    stream->cb = container->cb, stream->cdata = container->cdata;
+
+    /* ...set custom destructor */
+    g_object_weak_ref(G_OBJECT(container->bin), __stream_destructor, stream);
+
+    /* ...connect sink to the decoded stream */
+    video_stream_attach(stream, pad, caps);
+
+out:
+    gst_caps_unref(caps);
+}
+
+/* ...all streams are exposed; check we have got enough of them */
+static void container_no_more_pads(GstElement *decodebin, gpointer data)
+{
+    video_container_t  *container = data;
+
+    /* ...cameras without a stream would never deliver a frame; fail the pipeline */
+    if (container->count < container->number)
+    {
+        TRACE(ERROR, _x("container has %d video streams (%d expected)"), container->count, container->number);
+        GST_ELEMENT_ERROR(decodebin, STREAM, DEMUX, (NULL),
+                          ("container has %d video streams (%d expected)", container->count, container->number));
+    }
+    else
+    {
+        TRACE(INIT, _b("container streams discovered: %d"), container->count);
+    }
+}
+
+/* ...create single source/demuxer graph for a multi-stream container */
+static GstElement * video_container_create(const camera_callback_t *cb, void *cdata, int n, const char *filename)
+{
+    video_container_t  *container;
+    GstElement         *bin, *source, *decoder;
+
+    /* ...create single bin object that hosts all cameras */
+    CHK_ERR(bin = gst_bin_new("video-stream::bin"), (errno = ENOMEM, NULL));
+
+    /* ...allocate container data */
+    if ((container = malloc(sizeof(*container))) == NULL)
+    {
+        TRACE(ERROR, _x("failed to allocate container data"));
+        errno = ENOMEM;
+        goto error;
+    }
+
+    /* ...save container data */
+    container->bin = bin, container->cb = cb, container->cdata = cdata;
+    container->number = n, container->count = 0;
+
+    /* ...create graph nodes - single file handle and demuxer for all cameras */
+    if ((source = file_source_create(filename, 0)) == NULL)
+    {
+        TRACE(ERROR, _x("failed to create source for '%s': %m"), filename);
+        goto error_container;
+    }
+
+    if ((decoder = gst_element_factory_make("decodebin", NULL)) == NULL)
+    {
+        TRACE(ERROR, _x("failed to create decoder"));
+        gst_object_unref(source);
+        errno = ENOENT;
+        goto error_container;
+    }
+
+    gst_bin_add_many(GST_BIN(bin), source, decoder, NULL);
+    gst_element_link(source, decoder);
+
+    /* ...fan decoded streams out to the cameras */
+    g_signal_connect(decoder, "pad-added", G_CALLBACK(container_pad_added), container);
+    g_signal_connect(decoder, "no-more-pads", G_CALLBACK(container_no_more_pads), container);
+
+    /* ...set custom destructor */
+    g_object_weak_ref(G_OBJECT(bin), __container_destructor, container);
+
+    TRACE(INIT, _b("video-container created: '%s' (%d streams)"), filename, n);
+
+    return bin;
+
+error_container:
+    free(container);
+
+error:
+    gst_object_unref(bin);
+    return NULL;
+}
 
 /*******************************************************************************
  * Camera bin initialization
@@ -195,12 +379,23 @@ GstElement * video_stream_create(const camera_callback_t *cb, void *cdata, int n
     video_stream_t     *stream;
     GstElement         *bin, *source, *decoder;
     
+    /* ...single file for multiple cameras is a multi-stream container */
+    if (n > 1 && video_stream_get_file(1) == NULL)
+    {
+        return video_container_create(cb, cdata, n, video_stream_get_file(0));
+    }
+
     /* ...create single bin object that hosts all cameras */
     CHK_ERR(bin = gst_bin_new("video-stream::bin"), (errno = ENOMEM, NULL));
     int i;
     for (i=0; i < n; i++) {
         /* ...allocate new video stream data */
-        CHK_ERR(stream = malloc(sizeof(*stream)), (errno = ENOMEM, NULL));
+        if ((stream = malloc(sizeof(*stream))) == NULL)
+        {
+            TRACE(ERROR, _x("failed to allocate stream data"));
+            errno = ENOMEM;
+            goto error;
+        }
         const char         *filename = video_stream_get_file(i);
         /* ...save stream data */
         stream->bin = bin;
@@ -211,22 +406,36 @@ GstElement * video_stream_create(const camera_callback_t *cb, void *cdata, int n
         /* ...save stream callback data */
         stream->cb = cb, stream->cdata = cdata;
         /* ...create graph nodes */
-        source = gst_element_factory_make("filesrc", NULL);
-        decoder = gst_element_factory_make("decodebin", NULL);
-        g_assert(source && decoder);
+        if ((source = file_source_create(filename, i)) == NULL)
+        {
+            TRACE(ERROR, _x("failed to create source for '%s': %m"), filename);
+            goto error_stream;
+        }
+        if ((decoder = gst_element_factory_make("decodebin", NULL)) == NULL)
+        {
+            TRACE(ERROR, _x("failed to create decoder"));
+            gst_object_unref(source);
+            errno = ENOENT;
+            goto error_stream;
+        }
         /* ...add nodes into the bin */
         gst_bin_add_many(GST_BIN(bin), source, decoder, NULL);
         gst_element_link(source, decoder);
         /* ...specify a callback for connection with decodebin */
         g_signal_connect_data(decoder, "pad-added", G_CALLBACK(decodebin_pad_added),
                                 stream, NULL, 0);
-        /* ...set video file name */
-        g_object_set(source, "location", filename, NULL);
-
         /* ...set custom destructor */
         g_object_weak_ref(G_OBJECT(bin), __stream_destructor, stream);
 
         TRACE(INIT, _b("video-stream created"));
     }
     return bin;
+
+error_stream:
+    free(stream);
+
+error:
+    /* ...streams created so far are released by the bin destructor */
+    gst_object_unref(bin);
+    return NULL;
 }
@@ -36,6 +36,7 @@
 #include "utest-vsink.h"
 #include <gst/app/gstappsink.h>
 #include <gst/video/video-info.h>
+#include <gst/video/video-frame.h>
 #include <gst/allocators/gstdmabuf.h>
 
 /*******************************************************************************
@@ -46,10 +47,62 @@ TRACE_TAG(INIT, 1);
 TRACE_TAG(INFO, 1);
 TRACE_TAG(DEBUG, 1);
 
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...number of foreign buffers with textures kept in cache */
+#define VSINK_CACHE_SIZE                32
+
 /*******************************************************************************
  * Local types definitions
  ******************************************************************************/
 
+/* ...binding of cache entry to a memory (owned by memory weak-reference) */
+typedef struct vsink_cache_link
+{
+    /* ...cache entry the memory is bound to (NULL if binding is dropped) */
+    struct vsink_cache_entry   *entry;
+
+}   vsink_cache_link_t;
+
+/* ...CPU mapping of foreign buffer memories (kept for the carrier lifetime) */
+typedef struct vsink_carrier_map
+{
+    /* ...number of mapped memories */
+    int                         n_mem;
+
+    /* ...mapping descriptors (hold memory references) */
+    GstMapInfo                  info[GST_VIDEO_MAX_PLANES];
+
+}   vsink_carrier_map_t;
+
+/* ...texture cache entry for a foreign (system-memory / dmabuf) buffer */
+typedef struct vsink_cache_entry
+{
+    /* ...number of memories the buffer is made of */
+    int                         n_mem;
+
+    /* ...memories identity (key for system memory) */
+    GstMemory                  *mem[GST_VIDEO_MAX_PLANES];
+
+    /* ...DMA file-descriptors (key for dmabuf memory, -1 otherwise) */
+    int                         fd[GST_VIDEO_MAX_PLANES];
+
+    /* ...memories finalization bindings */
+    vsink_cache_link_t         *link[GST_VIDEO_MAX_PLANES];
+
+    /* ...carrier buffer holding metadata with user-allocated texture */
+    GstBuffer                  *carrier;
+
+    /* ...last use sequence number */
+    u32                         seq;
+
+    /* ...back-pointer to the sink */
+    video_sink_t               *sink;
+
+}   vsink_cache_entry_t;
+
 /* ...custom video sink node */
 struct video_sink
 {
@@ -64,8 +117,24 @@ struct video_sink
 
     /* ...processing function custom data */
     void                       *cdata;
+
+    /* ...texture cache for foreign buffers */
+    vsink_cache_entry_t         cache[VSINK_CACHE_SIZE];
+
+    /* ...cache use sequence counter */
+    u32                         cache_seq;
+
+    /* ...cache statistics */
+    u32                         cache_hits, cache_misses, cache_evictions;
 };
 
+/*******************************************************************************
+ * Static data definition
+ ******************************************************************************/
+
+/* ...texture cache lock (memories may be finalized from any thread, even after sink is gone) */
+static pthread_mutex_t  vsink_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*******************************************************************************
  * Custom buffer metadata implementation
  ******************************************************************************/
@@ -92,6 +161,7 @@ static gboolean vsink_meta_init(GstMeta *meta, gpointer params, GstBuffer *buffe
     
     /* ...reset fields */
     memset(meta + 1, 0, sizeof(*_meta) - sizeof(*meta));
+    _meta->modifier = VSINK_MODIFIER_IMPLICIT;
 
     return TRUE;
 }
@@ -143,6 +213,160 @@ const GstMetaInfo * vsink_meta_get_info(void)
     return meta_info;
 }
 
+/*******************************************************************************
+ * Custom buffer pool
+ ******************************************************************************/
+
+/* ...buffer pool depth */
+int     vsink_pool_depth = 4;
+
+/* ...buffer pool data */
+typedef struct vsink_pool
+{
+    /* ...generic buffer pool */
+    GstBufferPool               parent;
+
+    /* ...pool statistics */
+    vsink_pool_stats_t          stats;
+
+}   vsink_pool_t;
+
+/* ...buffer pool class */
+typedef struct vsink_pool_class
+{
+    /* ...generic buffer pool class */
+    GstBufferPoolClass          parent_class;
+
+}   vsink_pool_class_t;
+
+/* ...parent class pointer */
+static GstBufferPoolClass      *vsink_pool_parent_class;
+
+/* ...buffer allocation */
+static GstFlowReturn vsink_pool_alloc_buffer(GstBufferPool *bpool, GstBuffer **buffer, GstBufferPoolAcquireParams *params)
+{
+    vsink_pool_t   *pool = (vsink_pool_t *)bpool;
+    GstFlowReturn   ret;
+
+    /* ...use default allocator */
+    if ((ret = vsink_pool_parent_class->alloc_buffer(bpool, buffer, params)) == GST_FLOW_OK)
+    {
+        u32     allocs = __sync_add_and_fetch(&pool->stats.allocs, 1);
+
+        TRACE(DEBUG, _b("pool[%p]: buffer %p allocated (total: %u)"), pool, *buffer, allocs);
+    }
+
+    return ret;
+}
+
+/* ...buffer acquisition - account starvation waits */
+static GstFlowReturn vsink_pool_acquire_buffer(GstBufferPool *bpool, GstBuffer **buffer, GstBufferPoolAcquireParams *params)
+{
+    vsink_pool_t               *pool = (vsink_pool_t *)bpool;
+    vsink_pool_stats_t         *stats = &pool->stats;
+    GstBufferPoolAcquireParams  p = { .format = GST_FORMAT_UNDEFINED };
+    u32                         allocs = __sync_fetch_and_add(&stats->allocs, 0);
+    GstFlowReturn               ret;
+
+    /* ...try to get a buffer without blocking first */
+    if (params)     p = *params;
+    p.flags |= GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+    ret = vsink_pool_parent_class->acquire_buffer(bpool, buffer, &p);
+
+    /* ...pool is exhausted; wait until consumer returns a buffer */
+    if (ret == GST_FLOW_EOS && !(params && (params->flags & GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT)))
+    {
+        u32     t0 = __get_time_usec();
+        u32     waits;
+        u64     wait_time;
+
+        ret = vsink_pool_parent_class->acquire_buffer(bpool, buffer, params);
+
+        waits = __sync_add_and_fetch(&stats->waits, 1);
+        wait_time = __sync_add_and_fetch(&stats->wait_time, (u64)(u32)(__get_time_usec() - t0));
+
+        TRACE(DEBUG, _b("pool[%p]: starvation wait #%u (%llu us total)"), pool, waits, (unsigned long long)wait_time);
+    }
+
+    /* ...account buffers served without allocation */
+    if (ret == GST_FLOW_OK)
+    {
+        __sync_fetch_and_add(&stats->acquires, 1);
+        (allocs == __sync_fetch_and_add(&stats->allocs, 0) ? __sync_fetch_and_add(&stats->reuses, 1) : 0);
+    }
+
+    return ret;
+}
+
+/* ...snapshot pool counters (each one is read atomically) */
+static void vsink_pool_stats_read(vsink_pool_t *pool, vsink_pool_stats_t *stats)
+{
+    vsink_pool_stats_t *s = &pool->stats;
+
+    stats->allocs = __sync_fetch_and_add(&s->allocs, 0);
+    stats->acquires = __sync_fetch_and_add(&s->acquires, 0);
+    stats->reuses = __sync_fetch_and_add(&s->reuses, 0);
+    stats->waits = __sync_fetch_and_add(&s->waits, 0);
+    stats->wait_time = __sync_fetch_and_add(&s->wait_time, 0);
+    stats->renegotiations = __sync_fetch_and_add(&s->renegotiations, 0);
+}
+
+/* ...pool destructor */
+static void vsink_pool_finalize(GObject *object)
+{
+    vsink_pool_t       *pool = (vsink_pool_t *)object;
+    vsink_pool_stats_t  stats;
+
+    vsink_pool_stats_read(pool, &stats);
+
+    TRACE(INIT, _b("pool[%p] destroyed: allocs=%u, acquires=%u, reuses=%u, waits=%u (%llu us), renegotiations=%u"),
+          pool, stats.allocs, stats.acquires, stats.reuses, stats.waits, (unsigned long long)stats.wait_time, stats.renegotiations);
+
+    G_OBJECT_CLASS(vsink_pool_parent_class)->finalize(object);
+}
+
+/* ...class initialization */
+static void vsink_pool_class_init(vsink_pool_class_t *klass)
+{
+    GObjectClass       *oclass = G_OBJECT_CLASS(klass);
+    GstBufferPoolClass *pclass = GST_BUFFER_POOL_CLASS(klass);
+
+    vsink_pool_parent_class = g_type_class_peek_parent(klass);
+
+    oclass->finalize = vsink_pool_finalize;
+    pclass->alloc_buffer = vsink_pool_alloc_buffer;
+    pclass->acquire_buffer = vsink_pool_acquire_buffer;
+}
+
+/* ...instance initialization */
+static void vsink_pool_init(vsink_pool_t *pool)
+{
+    memset(&pool->stats, 0, sizeof(pool->stats));
+}
+
+/* ...pool type registration */
+static GType vsink_pool_get_type(void)
+{
+    static volatile gsize type;
+
+    if (g_once_init_enter(&type))
+    {
+        GType _type = g_type_register_static_simple(GST_TYPE_BUFFER_POOL, "VideoSinkPool",
+                                                    sizeof(vsink_pool_class_t), (GClassInitFunc)vsink_pool_class_init,
+                                                    sizeof(vsink_pool_t), (GInstanceInitFunc)vsink_pool_init, 0);
+        g_once_init_leave(&type, _type);
+    }
+
+    return type;
+}
+
+/* ...create new buffer pool */
+static inline GstBufferPool * vsink_pool_new(void)
+{
+    return g_object_new(vsink_pool_get_type(), NULL);
+}
+
 /*******************************************************************************
  * Buffer allocation
  ******************************************************************************/
@@ -181,6 +405,8 @@ static GstBuffer * vsink_buffer_create(video_sink_t *sink, gint *dmabuf,
         meta->plane[1] = planebuf[1];
         meta->dmafd[0] = dmabuf[0];
         meta->dmafd[1] = dmabuf[1];
+        meta->stride[0] = stride[0];
+        meta->stride[1] = stride[1];
 
         /* ...invoke user-supplied allocation callback */
         if (sink->cb->allocate(sink, buffer, sink->cdata))   goto error_user;
@@ -244,7 +470,7 @@ static GstPadProbeReturn vsink_probe(GstPad *pad, GstPadProbeInfo *info, gpointe
             GstAllocator           *allocator = NULL;
             GstCaps                *caps;
             GstAllocationParams     params;
-            guint                   size, min = 4, max = 4;
+            guint                   size, min, max;
             GstVideoInfo            vinfo;
             GstStructure           *config;
             gboolean                need_pool;
@@ -265,17 +491,20 @@ static GstPadProbeReturn vsink_probe(GstPad *pad, GstPadProbeInfo *info, gpointe
                 GstCaps    *_caps;
                 
                 config = gst_buffer_pool_get_config(pool);
-                gst_buffer_pool_config_get_params(config, &_caps, &size, NULL, NULL);
+                gst_buffer_pool_config_get_params(config, &_caps, &size, &min, &max);
                 
                 if (!gst_caps_is_equal(caps, _caps))
                 {
                     TRACE(INFO, _b("caps are different; destroy pool"));
+                    gst_buffer_pool_set_active(pool, FALSE);
                     gst_object_unref(pool);
                     sink->pool = pool = NULL;
                 }
                 else
                 {
-                    TRACE(DEBUG, _b("caps are same"));
+                    /* ...keep pool and all its buffers (and textures bound to them) */
+                    __sync_fetch_and_add(&((vsink_pool_t *)pool)->stats.renegotiations, 1);
+                    TRACE(DEBUG, _b("caps are same; reuse pool %p"), pool);
                 }
 
                 gst_structure_free(config);
@@ -284,9 +513,9 @@ static GstPadProbeReturn vsink_probe(GstPad *pad, GstPadProbeInfo *info, gpointe
             /* ...allocate pool if needed */
             if (pool == NULL && need_pool)
             {
-                /* ...create new buffer pool */
-                sink->pool = pool = gst_buffer_pool_new();
-                min = max = 4;
+                /* ...create new buffer pool; all buffers are allocated on activation */
+                sink->pool = pool = vsink_pool_new();
+                min = max = vsink_pool_depth;
                 size = vinfo.size;
 
                 TRACE(DEBUG, _b("pool allocated: %u/%u/%u"), size, min, max);
@@ -394,6 +623,303 @@ static GstPadProbeReturn vsink_probe(GstPad *pad, GstPadProbeInfo *info, gpointe
     return GST_PAD_PROBE_OK;
 }
 
+/*******************************************************************************
+ * Foreign buffers texture cache
+ ******************************************************************************/
+
+/* ...memory key (dmabuf descriptor or -1 for plain memory) */
+static inline int vsink_memory_fd(GstMemory *mem)
+{
+    return (gst_is_dmabuf_memory(mem) ? gst_dmabuf_memory_get_fd(mem) : -1);
+}
+
+/* ...drop cache entry (called with cache lock held) */
+static void vsink_cache_evict(vsink_cache_entry_t *entry)
+{
+    GstBuffer      *carrier = entry->carrier;
+    int             i;
+
+    TRACE(DEBUG, _b("video-sink[%p]: evict memory %p (fd=%d)"), entry->sink, entry->mem[0], entry->fd[0]);
+
+    /* ...detach memories; bindings are released by weak-reference notifications */
+    for (i = 0; i < entry->n_mem; i++)
+    {
+        entry->link[i]->entry = NULL;
+        entry->link[i] = NULL, entry->mem[i] = NULL, entry->fd[i] = -1;
+    }
+
+    entry->carrier = NULL, entry->n_mem = 0;
+
+    /* ...texture is destroyed along with the carrier as soon as no frame refers to it */
+    gst_buffer_unref(carrier);
+}
+
+/* ...memory finalization notification */
+static void __vsink_memory_finalized(gpointer data, GstMiniObject *obj)
+{
+    vsink_cache_link_t     *link = data;
+
+    pthread_mutex_lock(&vsink_cache_lock);
+
+    /* ...drop the entry unless it has been evicted already */
+    (link->entry ? vsink_cache_evict(link->entry) : 0);
+
+    pthread_mutex_unlock(&vsink_cache_lock);
+
+    free(link);
+}
+
+/* ...release CPU mapping of foreign buffer memories */
+static void vsink_carrier_unmap(vsink_carrier_map_t *map)
+{
+    while (map->n_mem-- > 0)
+    {
+        GstMemory  *mem = map->info[map->n_mem].memory;
+
+        gst_memory_unmap(mem, &map->info[map->n_mem]);
+        gst_memory_unref(mem);
+    }
+
+    free(map);
+}
+
+/* ...carrier finalization notification */
+static void __vsink_carrier_finalized(gpointer data, GstMiniObject *obj)
+{
+    vsink_carrier_unmap(data);
+}
+
+/* ...create carrier buffer with metadata for a foreign buffer (called with cache lock held) */
+static GstBuffer * vsink_cache_carrier(video_sink_t *sink, GstBuffer *buffer, GstCaps *caps)
+{
+    GstVideoInfo        vinfo;
+    GstVideoFrame       frame;
+    GstBuffer          *carrier;
+    vsink_meta_t       *meta;
+    vsink_carrier_map_t *map;
+    int                 i, n;
+
+    CHK_ERR(caps && gst_video_info_from_caps(&vinfo, caps), (errno = EINVAL, NULL));
+
+    /* ...memories stay mapped as long as the carrier refers to them */
+    CHK_ERR(map = calloc(1, sizeof(*map)), (errno = ENOMEM, NULL));
+
+    for (n = (int)gst_buffer_n_memory(buffer); map->n_mem < n; map->n_mem++)
+    {
+        GstMemory  *mem = gst_buffer_get_memory(buffer, map->n_mem);
+
+        if (!gst_memory_map(mem, &map->info[map->n_mem], GST_MAP_READ))
+        {
+            TRACE(ERROR, _x("failed to map memory #%d"), map->n_mem);
+            gst_memory_unref(mem);
+            vsink_carrier_unmap(map);
+            errno = EINVAL;
+            return NULL;
+        }
+    }
+
+    /* ...map frame to retrieve plane layout only (mapping is dropped right away) */
+    if (!gst_video_frame_map(&frame, &vinfo, buffer, GST_MAP_READ))
+    {
+        vsink_carrier_unmap(map);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    carrier = gst_buffer_new();
+    meta = gst_buffer_add_vsink_meta(carrier);
+    meta->width = GST_VIDEO_INFO_WIDTH(&vinfo);
+    meta->height = GST_VIDEO_INFO_HEIGHT(&vinfo);
+    meta->format = GST_VIDEO_INFO_FORMAT(&vinfo);
+    meta->sink = sink;
+
+    for (i = 0, n = GST_VIDEO_FRAME_N_PLANES(&frame); i < GST_VIDEO_MAX_PLANES; i++)
+    {
+        guint       idx, length;
+        gsize       skip;
+
+        meta->dmafd[i] = -1;
+
+        if (i >= n)     continue;
+
+        meta->plane[i] = NULL;
+        meta->stride[i] = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, i);
+
+        /* ...find memory holding the plane; CPU pointer refers to persistent mapping */
+        if (gst_buffer_find_memory(buffer, GST_VIDEO_FRAME_PLANE_OFFSET(&frame, i), 1, &idx, &length, &skip))
+        {
+            GstMemory  *mem = gst_buffer_peek_memory(buffer, idx);
+
+            meta->plane[i] = map->info[idx].data + skip;
+            meta->dmafd[i] = vsink_memory_fd(mem);
+            meta->offset[i] = (int)(mem->offset + skip);
+        }
+    }
+
+    gst_video_frame_unmap(&frame);
+
+    /* ...invoke user-supplied allocation callback (texture creation; padded planes are uploaded per row) */
+    if (sink->cb->allocate(sink, carrier, sink->cdata) < 0)
+    {
+        TRACE(ERROR, _x("buffer creation rejected by user"));
+        gst_buffer_unref(carrier);
+        vsink_carrier_unmap(map);
+        return NULL;
+    }
+
+    /* ...drop memories mapping after user destructors have been invoked */
+    gst_mini_object_weak_ref(GST_MINI_OBJECT(carrier), __vsink_carrier_finalized, map);
+
+    return carrier;
+}
+
+/* ...check if cache entry holds given buffer memories (dmabuf is keyed by descriptor, plain memory by identity) */
+static inline int vsink_cache_match(vsink_cache_entry_t *entry, GstBuffer *buffer, int n)
+{
+    int     i;
+
+    if (entry->n_mem != n)      return 0;
+
+    for (i = 0; i < n; i++)
+    {
+        GstMemory  *mem = gst_buffer_peek_memory(buffer, i);
+        int         fd = vsink_memory_fd(mem);
+
+        if (fd >= 0 ? entry->fd[i] != fd : entry->mem[i] != mem)    return 0;
+    }
+
+    return 1;
+}
+
+/* ...retrieve cached carrier for a foreign buffer */
+static GstBuffer * vsink_cache_lookup(video_sink_t *sink, GstBuffer *buffer, GstCaps *caps)
+{
+    int                     n = (int)gst_buffer_n_memory(buffer);
+    vsink_cache_link_t     *link[GST_VIDEO_MAX_PLANES];
+    vsink_cache_entry_t    *entry, *lru = NULL;
+    GstBuffer              *carrier;
+    int                     i;
+
+    /* ...buffer is keyed by all its memories */
+    CHK_ERR(n > 0 && n <= GST_VIDEO_MAX_PLANES, (errno = EINVAL, NULL));
+
+    pthread_mutex_lock(&vsink_cache_lock);
+
+    /* ...search the cache */
+    for (i = 0; i < VSINK_CACHE_SIZE; i++)
+    {
+        entry = &sink->cache[i];
+
+        if (entry->carrier && vsink_cache_match(entry, buffer, n))
+        {
+            sink->cache_hits++;
+            goto out;
+        }
+
+        /* ...track least recently used (or free) slot */
+        (!lru || !entry->carrier || (lru->carrier && entry->seq < lru->seq) ? lru = entry : 0);
+    }
+
+    /* ...cache miss; free least recently used slot */
+    sink->cache_misses++;
+    entry = lru;
+
+    if (entry->carrier)
+    {
+        vsink_cache_evict(entry);
+        sink->cache_evictions++;
+    }
+
+    /* ...allocate memories bindings */
+    for (i = 0; i < n; i++)
+    {
+        if ((link[i] = malloc(sizeof(*link[i]))) == NULL)
+        {
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+
+    /* ...wrap buffer memory into a texture */
+    if ((entry->carrier = vsink_cache_carrier(sink, buffer, caps)) == NULL)
+    {
+        goto error;
+    }
+
+    /* ...drop entry as soon as any of the memories is finalized */
+    for (i = 0, entry->n_mem = n, entry->sink = sink; i < n; i++)
+    {
+        GstMemory  *mem = gst_buffer_peek_memory(buffer, i);
+
+        link[i]->entry = entry;
+        entry->link[i] = link[i], entry->mem[i] = mem, entry->fd[i] = vsink_memory_fd(mem);
+        gst_mini_object_weak_ref(GST_MINI_OBJECT(mem), __vsink_memory_finalized, link[i]);
+    }
+
+    TRACE(INFO, _b("video-sink[%p]: cached buffer %p (memories=%d, fd=%d), hits=%u, misses=%u, evictions=%u"),
+          sink, buffer, n, entry->fd[0], sink->cache_hits, sink->cache_misses, sink->cache_evictions);
+
+out:
+    /* ...update usage sequence number */
+    entry->seq = ++sink->cache_seq;
+    carrier = gst_buffer_ref(entry->carrier);
+    pthread_mutex_unlock(&vsink_cache_lock);
+
+    return carrier;
+
+error:
+    /* ...release bindings allocated so far */
+    while (i--)     free(link[i]);
+    pthread_mutex_unlock(&vsink_cache_lock);
+    return NULL;
+}
+
+/* ...create per-frame wrapper of foreign buffer with cached texture */
+static GstBuffer * vsink_cache_wrap(video_sink_t *sink, GstBuffer *buffer, GstCaps *caps)
+{
+    GstBuffer      *carrier, *wrapper;
+    vsink_meta_t   *meta, *cmeta;
+    GstMeta         m;
+
+    CHK_ERR(carrier = vsink_cache_lookup(sink, buffer, caps), NULL);
+
+    /* ...wrapper has no memory; it keeps original buffer and carrier alive */
+    wrapper = gst_buffer_new();
+    gst_buffer_copy_into(wrapper, buffer, GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    gst_buffer_add_parent_buffer_meta(wrapper, buffer);
+    gst_buffer_add_parent_buffer_meta(wrapper, carrier);
+
+    /* ...replicate carrier metadata (keep generic meta header intact) */
+    cmeta = gst_buffer_get_vsink_meta(carrier);
+    meta = gst_buffer_add_vsink_meta(wrapper);
+    m = meta->meta, *meta = *cmeta, meta->meta = m;
+
+    gst_buffer_unref(carrier);
+
+    return wrapper;
+}
+
+/* ...destroy texture cache */
+static void vsink_cache_destroy(video_sink_t *sink)
+{
+    int     i;
+
+    pthread_mutex_lock(&vsink_cache_lock);
+
+    /* ...weak references are kept; bindings are detached and released on memory finalization */
+    for (i = 0; i < VSINK_CACHE_SIZE; i++)
+    {
+        vsink_cache_entry_t    *entry = &sink->cache[i];
+
+        (entry->carrier ? vsink_cache_evict(entry) : 0);
+    }
+
+    pthread_mutex_unlock(&vsink_cache_lock);
+
+    TRACE(INIT, _b("video-sink[%p]: texture cache destroyed: hits=%u, misses=%u, evictions=%u"),
+          sink, sink->cache_hits, sink->cache_misses, sink->cache_evictions);
+}
+
 /*******************************************************************************
  * Video sink implementation
  ******************************************************************************/
@@ -448,8 +974,22 @@ static GstFlowReturn vsink_new_sample(GstAppSink *appsink, gpointer user_data)
     
     TRACE(0, _b("buffer: %p, timestamp: %llu"), buffer, GST_BUFFER_PTS(buffer));
  
-    /* ...process frame; invoke user-provided callback */
-    r = sink->cb->process(sink, buffer, sink->cdata);
+    if (gst_buffer_get_vsink_meta(buffer))
+    {
+        /* ...process frame; invoke user-provided callback */
+        r = sink->cb->process(sink, buffer, sink->cdata);
+    }
+    else if ((buffer = vsink_cache_wrap(sink, buffer, gst_sample_get_caps(sample))) != NULL)
+    {
+        /* ...foreign buffer wrapped with a cached texture */
+        r = sink->cb->process(sink, buffer, sink->cdata);
+        gst_buffer_unref(buffer);
+    }
+    else
+    {
+        TRACE(ERROR, _x("failed to import buffer: %m"));
+        r = -EPIPE;
+    }
 
     /* ...release the sample (and buffer automatically unless user adds a reference) */
     gst_sample_unref(sample);
@@ -464,8 +1004,11 @@ static void vsink_destroy(gpointer data)
 
     TRACE(INIT, _b("video-sink[%p] destroy notification"), sink);
 
-    /* ...destroy buffer pool if allocated (doesn't look great - memleaks - tbd) */
-    (sink->pool ? gst_object_unref(sink->pool) : 0);
+    /* ...release textures of foreign buffers */
+    vsink_cache_destroy(sink);
+
+    /* ...release buffer pool; outstanding buffers keep it alive until returned */
+    (sink->pool ? gst_buffer_pool_set_active(sink->pool, FALSE), gst_object_unref(sink->pool) : 0);
 
     TRACE(INIT, _b("video-sink[%p] deallocate"), sink);
 
@@ -493,7 +1036,7 @@ video_sink_t * video_sink_create(GstCaps *caps, const vsink_callback_t *cb, void
     GstPad         *pad;
     
     /* ...allocate data */
-    CHK_ERR(sink = malloc(sizeof(*sink)), NULL);
+    CHK_ERR(sink = calloc(1, sizeof(*sink)), NULL);
 
     /* ...create application source item */
     if ((sink->appsink = (GstAppSink *)gst_element_factory_make("appsink", NULL)) == NULL)
@@ -537,3 +1080,23 @@ GstElement * video_sink_element(video_sink_t *sink)
 {
     return (GstElement *)sink->appsink;
 }
+
+/* ...retrieve buffer pool statistics */
+int video_sink_get_stats(video_sink_t *sink, vsink_pool_stats_t *stats)
+{
+    vsink_pool_t   *pool = (vsink_pool_t *)sink->pool;
+
+    /* ...pool statistics (upstream may use own pool); pool is replaced on sink streaming thread only */
+    memset(stats, 0, sizeof(*stats));
+
+    if (pool)   vsink_pool_stats_read(pool, stats);
+
+    /* ...texture cache statistics */
+    pthread_mutex_lock(&vsink_cache_lock);
+    stats->cache_hits = sink->cache_hits;
+    stats->cache_misses = sink->cache_misses;
+    stats->cache_evictions = sink->cache_evictions;
+    pthread_mutex_unlock(&vsink_cache_lock);
+
+    return 0;
+}